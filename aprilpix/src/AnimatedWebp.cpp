@@ -0,0 +1,160 @@
+/// @file
+/// @version 1.1
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#ifdef _WEBP
+#include <webp/demux.h>
+
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hresource.h>
+#include <hltypes/hstring.h>
+
+#include "aprilpix.h"
+#include "AnimatedWebp.h"
+
+namespace aprilpix
+{
+	AnimatedWebp::AnimatedWebp() : april::AnimatedTexture::FrameSource()
+	{
+		this->fileData = NULL;
+		this->decoder = NULL;
+		this->width = 0;
+		this->height = 0;
+		this->frameCount = 0;
+		this->frameRate = 0.0f;
+		this->nextIndex = 0;
+	}
+
+	AnimatedWebp::~AnimatedWebp()
+	{
+		if (this->decoder != NULL)
+		{
+			WebPAnimDecoderDelete(this->decoder);
+		}
+		if (this->fileData != NULL)
+		{
+			delete[] this->fileData;
+		}
+	}
+
+	int AnimatedWebp::getFrameCount() const
+	{
+		return this->frameCount;
+	}
+
+	float AnimatedWebp::getFrameRate() const
+	{
+		return this->frameRate;
+	}
+
+	april::Image* AnimatedWebp::readMetaData()
+	{
+		return april::Image::create(this->width, this->height, NULL, april::Image::Format::RGBA);
+	}
+
+	april::Image* AnimatedWebp::decodeFrame(int index, april::Image::Format format)
+	{
+		// frames are composed onto the canvas one after another so going back requires starting over
+		if (index < this->nextIndex)
+		{
+			WebPAnimDecoderReset(this->decoder);
+			this->nextIndex = 0;
+		}
+		uint8_t* canvas = NULL;
+		int timestamp = 0;
+		while (this->nextIndex <= index)
+		{
+			if (!WebPAnimDecoderGetNext(this->decoder, &canvas, &timestamp))
+			{
+				hlog::errorf(logTag, "Could not decode animated WEBP frame %d!", this->nextIndex);
+				WebPAnimDecoderReset(this->decoder);
+				this->nextIndex = 0;
+				return NULL;
+			}
+			++this->nextIndex;
+		}
+		april::Image* image = april::Image::create(this->width, this->height, NULL, format);
+		if (!april::Image::convertToFormat(this->width, this->height, canvas, april::Image::Format::RGBA, &image->data, format, false))
+		{
+			hlog::errorf(logTag, "Could not convert animated WEBP frame %d!", index);
+			delete image;
+			return NULL;
+		}
+		return image;
+	}
+
+	april::AnimatedTexture::FrameSource* AnimatedWebp::create(chstr filename, bool fromResource)
+	{
+		if (fromResource ? !hresource::exists(filename) : !hfile::exists(filename))
+		{
+			hlog::error(logTag, "Could not find animated WEBP file: " + filename);
+			return NULL;
+		}
+		AnimatedWebp* source = new AnimatedWebp();
+		int size = 0;
+		if (fromResource)
+		{
+			hresource file;
+			file.open(filename);
+			size = (int)file.size();
+			source->fileData = new unsigned char[size];
+			file.readRaw(source->fileData, size);
+		}
+		else
+		{
+			hfile file;
+			file.open(filename);
+			size = (int)file.size();
+			source->fileData = new unsigned char[size];
+			file.readRaw(source->fileData, size);
+		}
+		// the decoder references the file data instead of copying it
+		WebPData data;
+		data.bytes = source->fileData;
+		data.size = size;
+		WebPAnimDecoderOptions options;
+		if (!WebPAnimDecoderOptionsInit(&options))
+		{
+			hlog::error(logTag, "Could not initialize animated WEBP decoder!");
+			delete source;
+			return NULL;
+		}
+		options.color_mode = MODE_RGBA;
+		options.use_threads = 0; // frames are already decoded on a background thread
+		source->decoder = WebPAnimDecoderNew(&data, &options);
+		WebPAnimInfo info;
+		if (source->decoder == NULL || !WebPAnimDecoderGetInfo(source->decoder, &info) || info.frame_count == 0)
+		{
+			hlog::error(logTag, "Could not load animated WEBP file: " + filename);
+			delete source;
+			return NULL;
+		}
+		source->width = info.canvas_width;
+		source->height = info.canvas_height;
+		source->frameCount = info.frame_count;
+		// WEBP stores a duration per frame, the average is used since playback has a fixed frame rate
+		const WebPDemuxer* demuxer = WebPAnimDecoderGetDemuxer(source->decoder);
+		WebPIterator iterator;
+		int duration = 0;
+		if (WebPDemuxGetFrame(demuxer, 1, &iterator))
+		{
+			do
+			{
+				duration += iterator.duration;
+			} while (WebPDemuxNextFrame(&iterator));
+			WebPDemuxReleaseIterator(&iterator);
+		}
+		if (duration > 0)
+		{
+			source->frameRate = source->frameCount * 1000.0f / duration;
+		}
+		return source;
+	}
+
+}
+#endif
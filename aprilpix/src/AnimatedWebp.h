@@ -0,0 +1,52 @@
+/// @file
+/// @version 1.1
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a frame source for animated WEBP files.
+
+#ifdef _WEBP
+#ifndef APRILPIX_ANIMATED_WEBP_H
+#define APRILPIX_ANIMATED_WEBP_H
+
+#include <webp/demux.h>
+
+#include <april/AnimatedTexture.h>
+#include <april/Image.h>
+#include <hltypes/hstring.h>
+
+namespace aprilpix
+{
+	class AnimatedWebp : public april::AnimatedTexture::FrameSource
+	{
+	public:
+		~AnimatedWebp();
+
+		int getFrameCount() const;
+		float getFrameRate() const;
+		april::Image* readMetaData();
+		april::Image* decodeFrame(int index, april::Image::Format format);
+
+		static april::AnimatedTexture::FrameSource* create(chstr filename, bool fromResource);
+
+	protected:
+		unsigned char* fileData;
+		WebPAnimDecoder* decoder;
+		int width;
+		int height;
+		int frameCount;
+		float frameRate;
+		int nextIndex;
+
+		AnimatedWebp();
+
+	};
+
+}
+#endif
+#endif
@@ -34,45 +34,65 @@ namespace aprilpix
 	}
 
 	april::Image* ImageWebp::load(hsbase& stream)
+	{
+		return ImageWebp::loadScaled(stream, 0, 1.0f);
+	}
+
+	april::Image* ImageWebp::loadScaled(hsbase& stream, int maxDimension, float scale)
 	{
 		int size = (int)stream.size();
 		uint8_t* data = new uint8_t[size];
 		stream.readRaw(data, size);
-		WebPBitstreamFeatures features;
-		VP8StatusCode code = WebPGetFeatures(data, size, &features);
-		if (code != VP8_STATUS_OK || features.width <= 0 || features.height <= 0)
+		WebPDecoderConfig config;
+		if (!WebPInitDecoderConfig(&config))
+		{
+			hlog::error(logTag, "Could not initialize WEBP decoder!");
+			delete[] data;
+			return NULL;
+		}
+		VP8StatusCode code = WebPGetFeatures(data, size, &config.input);
+		if (code != VP8_STATUS_OK || config.input.width <= 0 || config.input.height <= 0)
 		{
 			hlog::error(logTag, "Could not load WEBP file!");
 			delete[] data;
 			return NULL;
 		}
 		april::Image* image = new ImageWebp();
-		image->w = features.width;
-		image->h = features.height;
+		image->w = config.input.width;
+		image->h = config.input.height;
+		// libwebp scales while decoding, so the full size image is never created
+		int divisor = april::Image::calcDownscaleDivisor(image->w, image->h, maxDimension, scale);
+		if (divisor > 1)
+		{
+			image->w = (image->w + divisor - 1) / divisor;
+			image->h = (image->h + divisor - 1) / divisor;
+			config.options.use_scaling = 1;
+			config.options.scaled_width = image->w;
+			config.options.scaled_height = image->h;
+		}
 		int bpp = 0;
-		if (features.has_alpha)
+		if (config.input.has_alpha)
 		{
 			image->format = Format::RGBA;
+			config.output.colorspace = MODE_RGBA;
 			bpp = 4;
 		}
 		else
 		{
 			image->format = Format::RGB;
+			config.output.colorspace = MODE_RGB;
 			bpp = 3;
 		}
 		int imageDataSize = image->w * image->h * bpp;
 		image->data = new unsigned char[imageDataSize];
-		uint8_t* result = NULL;
-		if (bpp == 4)
-		{
-			result = WebPDecodeRGBAInto(data, size, image->data, imageDataSize, image->w * bpp);
-		}
-		else
-		{
-			result = WebPDecodeRGBInto(data, size, image->data, imageDataSize, image->w * bpp);
-		}
+		config.output.is_external_memory = 1;
+		config.output.u.RGBA.rgba = image->data;
+		config.output.u.RGBA.stride = image->w * bpp;
+		config.output.u.RGBA.size = imageDataSize;
+		code = WebPDecode(data, size, &config);
+		WebPFreeDecBuffer(&config.output);
 		delete[] data;
-		if (result == NULL || result != image->data)
+		if (code != VP8_STATUS_OK)
 		{
 			hlog::error(logTag, "Could not decode WEBP file! Possibly not enough memory allocated.");
 			delete image;
@@ -27,6 +27,7 @@ namespace aprilpix
 		~ImageWebp();
 
 		static april::Image* load(hsbase& stream);
+		static april::Image* loadScaled(hsbase& stream, int maxDimension, float scale);
 		static april::Image* loadMetaData(hsbase& stream);
 #ifndef _WEBP_NO_ENCODE
 		static bool save(hsbase& stream, april::Image* image, april::Image::SaveParameters parameters);
@@ -6,6 +6,7 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <april/AnimatedTexture.h>
 #include <april/april.h>
 #include <april/Image.h>
 #include <hltypes/hlog.h>
@@ -17,6 +18,7 @@
 #include "ImagePvr.h"
 #endif
 #ifdef _WEBP
+#include "AnimatedWebp.h"
 #include "ImageWebp.h"
 #endif
 
@@ -30,6 +32,8 @@ namespace aprilpix
 		hlog::write(logTag, "Initializing AprilPIX: " + version.toString());
 #ifdef _WEBP
 		april::Image::registerCustomLoader(".webp", &ImageWebp::load, &ImageWebp::loadMetaData);
+		april::Image::registerCustomScaledLoader(".webp", &ImageWebp::loadScaled);
+		april::AnimatedTexture::registerCustomFrameSource(".webp", &AnimatedWebp::create);
 #ifndef _WEBP_NO_ENCODE
 		april::Image::registerCustomSaver(".webp", &ImageWebp::save, &ImageWebp::makeDefaultSaveParameters);
 #endif
@@ -199,6 +199,8 @@ void __aprilApplicationInit()
 	cursor = april::window->createCursorFromResource(RESOURCE_PATH "cursor");
 	april::window->setCursor(cursor);
 	texture = april::rendersys->createTextureFromResource(RESOURCE_PATH "texture");
+	texture->setFilter(april::Texture::Filter::MipLinear);
+	texture->setAnisotropy(4.0f);
 	logo = april::rendersys->createTextureFromResource(RESOURCE_PATH "logo");
 	gvec3f _v[8];
 	_v[0].x = -1.0f;	_v[0].y = -1.0f;	_v[0].z = 1.0f;
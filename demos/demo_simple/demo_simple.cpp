@@ -39,12 +39,19 @@
 #include <gtypes/Rectangle.h>
 #include <gtypes/Vector2.h>
 #include <hltypes/hlog.h>
+#include <hltypes/hfile.h>
 #include <hltypes/hltypesUtil.h>
+#include <hltypes/hresource.h>
+#include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
 #define LOG_TAG "demo_simple"
 
 #define _ENGINE_RENDER_TEST
+//#define _QOI_BENCHMARK
+
+#define QOI_BENCHMARK_ITERATIONS 20
+#define QOI_BENCHMARK_FILENAME "qoi_benchmark.qoi"
 
 april::Cursor* cursor = NULL;
 april::Texture* texture = NULL;
@@ -176,6 +183,65 @@ void ObjCUtil_setCWD(const char* override_default_dir)
 }
 #endif
 
+#ifdef _QOI_BENCHMARK
+static float _decodeBenchmark(hstream& stream, chstr extension, int* pixels)
+{
+	int64_t start = htickCount();
+	april::Image* image = NULL;
+	for_iter (i, 0, QOI_BENCHMARK_ITERATIONS)
+	{
+		stream.rewind();
+		image = april::Image::createFromStream(stream, extension);
+		if (image == NULL)
+		{
+			return 0.0f;
+		}
+		*pixels = image->w * image->h;
+		delete image;
+	}
+	return (float)(htickCount() - start) / QOI_BENCHMARK_ITERATIONS;
+}
+
+// compares QOI decoding throughput against PNG decoding using the demo media
+void _benchmarkQoi()
+{
+	harray<hstr> filenames = hstr(RESOURCE_PATH "logo.png," RESOURCE_PATH "jpt_raw.png," RESOURCE_PATH "bloom.png").split(',');
+	hstream pngStream;
+	hstream qoiStream;
+	int pixels = 0;
+	float pngTime = 0.0f;
+	float qoiTime = 0.0f;
+	foreach (hstr, it, filenames)
+	{
+		pngStream.clear();
+		qoiStream.clear();
+		hresource resource;
+		resource.open(*it);
+		pngStream.writeRaw(resource);
+		resource.close();
+		pngStream.rewind();
+		april::Image* image = april::Image::createFromStream(pngStream, ".png");
+		if (image == NULL || !april::Image::save(image, QOI_BENCHMARK_FILENAME, april::Image::FileFormat::Qoi))
+		{
+			delete image;
+			hlog::error(LOG_TAG, "QOI benchmark could not convert: " + (*it));
+			continue;
+		}
+		delete image;
+		hfile file;
+		file.open(QOI_BENCHMARK_FILENAME);
+		qoiStream.writeRaw(file);
+		file.close();
+		hfile::remove(QOI_BENCHMARK_FILENAME);
+		pngTime = _decodeBenchmark(pngStream, ".png", &pixels);
+		qoiTime = _decodeBenchmark(qoiStream, ".qoi", &pixels);
+		hlog::writef(LOG_TAG, "%s: PNG %d bytes, %.2f ms (%.1f MP/s); QOI %d bytes, %.2f ms (%.1f MP/s)", it->cStr(),
+			(int)pngStream.size(), pngTime, (pngTime > 0.0f ? pixels / pngTime * 0.001f : 0.0f),
+			(int)qoiStream.size(), qoiTime, (qoiTime > 0.0f ? pixels / qoiTime * 0.001f : 0.0f));
+	}
+}
+#endif
+
 void __aprilApplicationInit()
 {
 #ifdef __APPLE__
@@ -241,6 +307,9 @@ void __aprilApplicationInit()
 	manualTexture->blit(0, 0, texture->getWidth(), texture->getHeight(), 256, 128, texture, 96);
 	manualTexture->blitStretch(texture->getWidth() / 2, 0, texture->getWidth() / 2, texture->getHeight(), 128, 256, 700, 200, texture, 208);
 	manualTexture->blitRect(320, 0, 48, 192, april::Color(april::Color::Green, 128));
+#ifdef _QOI_BENCHMARK
+	_benchmarkQoi();
+#endif
 }
 
 void __aprilApplicationDestroy()
@@ -0,0 +1,250 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines an animated texture that streams a sequence of frames.
+
+#ifndef APRIL_ANIMATED_TEXTURE_H
+#define APRIL_ANIMATED_TEXTURE_H
+
+#include <condition_variable>
+#include <mutex>
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include "aprilExport.h"
+#include "Image.h"
+
+namespace april
+{
+	class RenderSystem;
+	class Texture;
+
+	/// @brief Defines an animated texture that streams a sequence of frames.
+	/// @note Frames come from a sequence of image files or from a single animated file if a frame source is registered for its format.
+	/// Frames are decoded by a background thread into a small RAM ring and uploaded ahead of the playback clock into a small ring of
+	/// GPU textures so only a few textures exist regardless of how many frames the animation has.
+	class aprilExport AnimatedTexture
+	{
+	public:
+		friend class RenderSystem;
+
+		/// @brief Defines a source of decoded animation frames.
+		/// @note Frames are only ever decoded by one thread at a time, but not necessarily the thread that created the frame source.
+		class aprilExport FrameSource
+		{
+		public:
+			/// @brief Basic constructor.
+			FrameSource();
+			/// @brief Destructor.
+			virtual ~FrameSource();
+
+			/// @brief Gets the number of frames.
+			/// @return The number of frames.
+			virtual int getFrameCount() const = 0;
+			/// @brief Gets the frame rate stored in the source.
+			/// @return The frame rate stored in the source or 0 if the source doesn't have one.
+			virtual float getFrameRate() const;
+			/// @brief Reads the size and format of the frames.
+			/// @return An Image object without data or NULL if failed.
+			virtual Image* readMetaData() = 0;
+			/// @brief Decodes a frame.
+			/// @param[in] index Index of the frame.
+			/// @param[in] format The pixel format the frame should be converted to.
+			/// @return The decoded frame or NULL if failed.
+			/// @note Frames are usually requested in order, sources that can only decode sequentially may restart when they aren't.
+			virtual Image* decodeFrame(int index, Image::Format format) = 0;
+
+		};
+
+		/// @brief The filenames of all frames.
+		HL_DEFINE_GET(harray<hstr>, filenames, Filenames);
+		/// @brief Whether the frames are loaded from resource files or normal files.
+		HL_DEFINE_IS(fromResource, FromResource);
+		/// @brief How many frames are displayed per second.
+		HL_DEFINE_GETSET(float, frameRate, FrameRate);
+		/// @brief Whether playback restarts from the first frame after the last frame.
+		HL_DEFINE_ISSET(looping, Looping);
+		/// @brief Whether the animation is currently playing.
+		HL_DEFINE_IS(playing, Playing);
+		/// @brief Width of the frames in pixels.
+		HL_DEFINE_GET(int, width, Width);
+		/// @brief Height of the frames in pixels.
+		HL_DEFINE_GET(int, height, Height);
+		/// @brief Pixel format of the frames.
+		HL_DEFINE_GET(Image::Format, format, Format);
+		/// @brief How many frames were skipped, because they weren't ready in time or the playback clock advanced past them.
+		HL_DEFINE_GET(int, droppedFrameCount, DroppedFrameCount);
+		/// @brief How many times a frame wasn't ready when it should have been displayed.
+		HL_DEFINE_GET(int, lateFrameCount, LateFrameCount);
+
+		/// @brief Gets the number of frames.
+		/// @return The number of frames.
+		int getFrameCount() const;
+		/// @brief Gets the index of the currently displayed frame.
+		/// @return The index of the currently displayed frame or -1 if no frame has been displayed yet.
+		int getCurrentFrame() const;
+		/// @brief Gets the texture that contains the currently displayed frame.
+		/// @return The texture that contains the currently displayed frame.
+		/// @note The returned texture can change after every call to update(), so it shouldn't be stored.
+		Texture* getTexture() const;
+
+		/// @brief Starts or resumes playback.
+		void play();
+		/// @brief Pauses playback.
+		void pause();
+		/// @brief Stops playback and rewinds to the first frame.
+		void stop();
+		/// @brief Resets the dropped and late frame counters.
+		void resetStatistics();
+
+		/// @brief Advances the playback clock, uploads decoded frames to the GPU and selects the frame to display.
+		/// @param[in] timeDelta Time since the last update.
+		/// @note This has to be called on the main thread, usually once per frame.
+		void update(float timeDelta);
+
+		/// @brief Registers a frame source for a file format that can contain a whole animation.
+		/// @param[in] extension Filename extension.
+		/// @param[in] createFunction The function pointer that opens a file as frame source. It returns NULL if failed.
+		/// @note Used when an animated texture is created from a single file with this extension.
+		static void registerCustomFrameSource(chstr extension, FrameSource* (*createFunction)(chstr filename, bool fromResource));
+
+	protected:
+		/// @brief Plays a sequence of image files, one frame per file.
+		class FileSequence : public FrameSource
+		{
+		public:
+			FileSequence(const harray<hstr>& filenames, bool fromResource);
+
+			int getFrameCount() const;
+			Image* readMetaData();
+			Image* decodeFrame(int index, Image::Format format);
+
+		protected:
+			harray<hstr> filenames;
+			bool fromResource;
+
+		};
+
+		/// @brief The filenames of all frames.
+		harray<hstr> filenames;
+		/// @brief Whether the frames are loaded from resource files or normal files.
+		bool fromResource;
+		/// @brief The source of the decoded frames.
+		FrameSource* frameSource;
+		/// @brief The number of frames.
+		int frameCount;
+		/// @brief How many frames are displayed per second.
+		float frameRate;
+		/// @brief Whether playback restarts from the first frame after the last frame.
+		bool looping;
+		/// @brief Whether the animation is currently playing.
+		bool playing;
+		/// @brief Width of the frames in pixels.
+		int width;
+		/// @brief Height of the frames in pixels.
+		int height;
+		/// @brief Pixel format of the frames.
+		Image::Format format;
+		/// @brief How many frames were skipped.
+		int droppedFrameCount;
+		/// @brief How many times a frame wasn't ready in time.
+		int lateFrameCount;
+		/// @brief Time accumulated since the current target frame started.
+		float frameTime;
+		/// @brief Sequence number of the frame that should be currently displayed according to the playback clock.
+		/// @note Sequence numbers keep increasing when looping, the frame index is the sequence number modulo the frame count.
+		int targetSequence;
+		/// @brief Sequence number of the currently displayed frame.
+		int displayedSequence;
+		/// @brief Last target sequence number that was reported as late.
+		int lateSequence;
+		/// @brief The ring of GPU textures.
+		harray<Texture*> textures;
+		/// @brief The sequence numbers of the frames in the GPU textures.
+		harray<int> textureSequences;
+		/// @brief Index of the GPU texture with the currently displayed frame.
+		int textureIndex;
+		/// @brief Mutex for the decoded frames ring.
+		hmutex decodeMutex;
+		/// @brief Decoded frames waiting for upload.
+		harray<Image*> decodedImages;
+		/// @brief The sequence numbers of the decoded frames waiting for upload.
+		harray<int> decodedSequences;
+		/// @brief How many frames are decoded ahead of the upload at most.
+		int decodeAheadCount;
+		/// @brief Sequence number of the next frame to be decoded.
+		int decodeSequence;
+		/// @brief Incremented when playback is reset so frames that are decoded in the meantime can be discarded.
+		int decodeGeneration;
+		/// @brief Whether the background decoder thread is currently decoding a frame of this animated texture.
+		/// @note This is protected by animatedTexturesMutex.
+		bool decoding;
+
+		/// @brief All animated textures that are currently being decoded.
+		static harray<AnimatedTexture*> animatedTextures;
+		/// @brief Mutex for the list of animated textures.
+		/// @note hmutex can't be used with condition variables.
+		static std::mutex animatedTexturesMutex;
+		/// @brief Signaled when an animated texture may have room for more decoded frames.
+		static std::condition_variable decodeCondition;
+		/// @brief Signaled when the background decoder thread finished decoding a frame.
+		static std::condition_variable decodedCondition;
+		/// @brief Frame sources for file formats that can contain a whole animation.
+		static hmap<hstr, FrameSource* (*)(chstr, bool)> customFrameSources;
+		/// @brief The background decoder thread shared by all animated textures.
+		static hthread decoderThread;
+		/// @brief Whether the background decoder thread is running.
+		static bool decoderRunning;
+
+		/// @brief Basic constructor.
+		/// @param[in] fromResource Whether the frames are loaded from resource files or normal files.
+		AnimatedTexture(bool fromResource);
+		/// @brief Destructor.
+		virtual ~AnimatedTexture();
+
+		/// @brief Creates the GPU textures and starts decoding.
+		/// @param[in] filenames The filenames of all frames or a single animated file.
+		/// @param[in] frameRate How many frames are displayed per second. 0 or less uses the frame rate stored in an animated file.
+		/// @param[in] looping Whether playback restarts from the first frame after the last frame.
+		/// @param[in] ringSize How many GPU textures are used for the frames.
+		/// @return True if successful.
+		bool _create(const harray<hstr>& filenames, float frameRate, bool looping, int ringSize);
+		/// @brief Stops decoding and destroys the GPU textures.
+		void _destroy();
+		/// @brief Clears all decoded frames.
+		/// @note decodeMutex has to be locked when calling this.
+		void _clearDecodedImages();
+		/// @brief Checks whether there is room in the decoded frames ring and a frame left to decode.
+		/// @return True if the next frame can be decoded.
+		bool _canDecodeNextFrame();
+		/// @brief Decodes the next frame if there is room in the decoded frames ring.
+		/// @return True if a frame was decoded.
+		/// @note This is called on the background decoder thread.
+		bool _decodeNextFrame();
+		/// @brief Writes decoded frames into GPU textures that aren't needed anymore and uploads them.
+		void _uploadDecodedFrames();
+
+		/// @brief Wakes up the background decoder thread.
+		/// @note decodeMutex must not be locked when calling this.
+		static void _notifyDecoder();
+		/// @brief The background decoder thread function.
+		/// @param[in] thread The thread.
+		static void _decode(hthread* thread);
+
+	};
+
+}
+
+#endif
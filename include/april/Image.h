@@ -32,6 +32,9 @@
 #define APRIL_JPEG_SAVE_QUALITY "quality"
 #define APRIL_JPEG_SAVE_QUALITY_DEFAULT 95
 
+#define APRIL_IMAGE_PALETTE_COLORS 256
+#define APRIL_IMAGE_PALETTE_BYTE_SIZE (APRIL_IMAGE_PALETTE_COLORS * 4)
+
 namespace april
 {
 	/// @brief Defines a generic image data source.
@@ -87,6 +90,7 @@ namespace april
 			HL_ENUM_DECLARE(Format, Compressed);
 			/// @var static const Format Format::Palette
 			/// @brief Defines an image with palette colors.
+			/// @note The data starts with APRIL_IMAGE_PALETTE_COLORS RGBA palette entries followed by one byte-per-pixel index data.
 			HL_ENUM_DECLARE(Format, Palette);
 
 			/// @brief Gets the BPP.
@@ -127,6 +131,9 @@ namespace april
 			/// @var static const FileFormat FileFormat::Jpeg
 			/// @brief Defines JPEG.
 			HL_ENUM_DECLARE(FileFormat, Jpeg);
+			/// @var static const FileFormat FileFormat::Qoi
+			/// @brief Defines QOI.
+			HL_ENUM_DECLARE(FileFormat, Qoi);
 			/// @var static const FileFormat FileFormat::Custom
 			/// @brief Defines a custom format.
 			HL_ENUM_DECLARE(FileFormat, Custom);
@@ -138,6 +145,34 @@ namespace april
 
 		));
 
+		/// @class BlockFormat
+		/// @brief Defines GPU block compression formats that image data can be encoded into at runtime.
+		/// @note All formats use 4x4 pixel blocks.
+		HL_ENUM_CLASS_PREFIX_DECLARE(aprilExport, BlockFormat,
+		(
+			/// @var static const BlockFormat BlockFormat::Etc2Rgb
+			/// @brief Defines ETC2 RGB.
+			/// @note Blocks are encoded in ETC1 compatible mode.
+			HL_ENUM_DECLARE(BlockFormat, Etc2Rgb);
+			/// @var static const BlockFormat BlockFormat::Etc2Rgba
+			/// @brief Defines ETC2 RGBA8 with EAC alpha.
+			HL_ENUM_DECLARE(BlockFormat, Etc2Rgba);
+			/// @var static const BlockFormat BlockFormat::Bc1
+			/// @brief Defines BC1 (DXT1) without alpha.
+			HL_ENUM_DECLARE(BlockFormat, Bc1);
+			/// @var static const BlockFormat BlockFormat::Bc3
+			/// @brief Defines BC3 (DXT5).
+			HL_ENUM_DECLARE(BlockFormat, Bc3);
+
+			/// @brief Gets the byte size of one 4x4 pixel block.
+			/// @return The byte size of one 4x4 pixel block.
+			int getBlockSize() const;
+			/// @brief Checks whether the format stores an alpha channel.
+			/// @return True if the format stores an alpha channel.
+			bool hasAlpha() const;
+
+		));
+
 		/// @brief The raw image data.
 		unsigned char* data;
 		/// @brief Width of the image in pixels.
@@ -149,7 +184,7 @@ namespace april
 		/// @brief Internal format identifier.
 		/// @note Needed for special platform dependent formats, usually used internally only.
 		int internalFormat;
-		/// @brief The byte size of the image data when handling compressed formats (e.g. FORMAT_PALETTE).
+		/// @brief The byte size of the image data when handling compressed formats (e.g. Format::Compressed or Format::Palette).
 		int compressedSize;
 
 		/// @brief Destructor.
@@ -161,8 +196,14 @@ namespace april
 		int getBpp() const;
 		/// @brief Gets the size of the image data in bytes.
 		/// @return Size of the image data in bytes.
-		/// @note The calculation is basically "w * h * getBpp()".
+		/// @note The calculation is basically "w * h * getBpp()" except for compressed formats where compressedSize is used.
 		int getByteSize() const;
+		/// @brief Gets the RGBA palette entries of a Format::Palette image.
+		/// @return Pointer to APRIL_IMAGE_PALETTE_COLORS RGBA entries or NULL if the image is not paletted.
+		unsigned char* getPalette() const;
+		/// @brief Gets the one byte-per-pixel palette index data of a Format::Palette image.
+		/// @return Pointer to the index data or NULL if the image is not paletted.
+		unsigned char* getPaletteIndices() const;
 		/// @brief Checks if the image is a valid image data construct with appropriate meta data.
 		/// @return True if the image is a valid image data construct with appropriate meta data.
 		bool isValid() const;
@@ -559,6 +600,12 @@ namespace april
 		/// @note This is an expensive operation and should be used sparingly.
 		/// @note Currently this operation is only supported for single-channel 8-bit images.
 		bool dilate(Image* image);
+		/// @brief Downscales the image in place.
+		/// @param[in] divisor By how much the image dimensions are reduced. The new size is rounded up.
+		/// @return True if successful.
+		/// @note A box filter is used except for Format::Palette where the top-left pixel of every block is used.
+		/// @note Format::Compressed images can't be downscaled.
+		bool downscale(int divisor);
 
 		/// @brief Creates an Image object from a resource file.
 		/// @param[in] filename Filename of the resource file.
@@ -568,6 +615,7 @@ namespace april
 		/// @param[in] filename Filename of the resource file.
 		/// @param[in] format Convert to a certain pixel format during load.
 		/// @return The loaded Image object or NULL if failed.
+		/// @note Using Format::Palette keeps paletted image data unexpanded while other image data is returned in its natural format.
 		static Image* createFromResource(chstr filename, Format format);
 		/// @brief Creates an Image object from a file.
 		/// @param[in] filename Filename of the file.
@@ -577,6 +625,7 @@ namespace april
 		/// @param[in] filename Filename of the file.
 		/// @param[in] format Convert to a certain pixel format during load.
 		/// @return The loaded Image object or NULL if failed.
+		/// @note Using Format::Palette keeps paletted image data unexpanded while other image data is returned in its natural format.
 		static Image* createFromFile(chstr filename, Format format);
 		/// @brief Creates an Image object from a data stream.
 		/// @param[in] stream Data stream containing the compressed image data.
@@ -589,7 +638,33 @@ namespace april
 		/// @param[in] logicalExtension The logical extension of the loaded stream so the method knows what data is contained in the stream.
 		/// @param[in] format Convert to a certain pixel format during load.
 		/// @return The loaded Image object or NULL if failed.
+		/// @note Using Format::Palette keeps paletted image data unexpanded while other image data is returned in its natural format.
 		static Image* createFromStream(hsbase& stream, chstr logicalExtension, Format format);
+		/// @brief Creates an Image object from a resource file and downscales it during decoding.
+		/// @param[in] filename Filename of the resource file.
+		/// @param[in] maxDimension Maximum width and height of the loaded image. 0 or less means no limit.
+		/// @param[in] scale Scale factor for the loaded image.
+		/// @return The loaded Image object or NULL if failed.
+		/// @note PNG and JPEG files and custom formats with a scaled loader are downscaled while decoding, other formats are downscaled after decoding.
+		/// @see calcDownscaleDivisor
+		static Image* createFromResource(chstr filename, int maxDimension, float scale);
+		/// @brief Creates an Image object from a file and downscales it during decoding.
+		/// @param[in] filename Filename of the file.
+		/// @param[in] maxDimension Maximum width and height of the loaded image. 0 or less means no limit.
+		/// @param[in] scale Scale factor for the loaded image.
+		/// @return The loaded Image object or NULL if failed.
+		/// @note PNG and JPEG files and custom formats with a scaled loader are downscaled while decoding, other formats are downscaled after decoding.
+		/// @see calcDownscaleDivisor
+		static Image* createFromFile(chstr filename, int maxDimension, float scale);
+		/// @brief Creates an Image object from a data stream and downscales it during decoding.
+		/// @param[in] stream Data stream containing the compressed image data.
+		/// @param[in] logicalExtension The logical extension of the loaded stream so the method knows what data is contained in the stream.
+		/// @param[in] maxDimension Maximum width and height of the loaded image. 0 or less means no limit.
+		/// @param[in] scale Scale factor for the loaded image.
+		/// @return The loaded Image object or NULL if failed.
+		/// @note PNG and JPEG files and custom formats with a scaled loader are downscaled while decoding, other formats are downscaled after decoding.
+		/// @see calcDownscaleDivisor
+		static Image* createFromStream(hsbase& stream, chstr logicalExtension, int maxDimension, float scale);
 		/// @brief Creates an Image object from a raw image data.
 		/// @param[in] w Width of the image data.
 		/// @param[in] h Height of the image data.
@@ -862,6 +937,53 @@ namespace april
 		/// @return True if successful.
 		/// @note Helps to determine whether there is a need to convert an image format into another. It can be helpful to avoid conversions from e.g. RGBA to RGBX if the GPU ignores the X anyway.
 		static bool needsConversion(Format srcFormat, Format destFormat, bool preventCopy = true);
+		/// @brief Calculates by how much an image is reduced when it's downscaled during decoding.
+		/// @param[in] w Original width of the image.
+		/// @param[in] h Original height of the image.
+		/// @param[in] maxDimension Maximum width and height of the image. 0 or less means no limit.
+		/// @param[in] scale Scale factor for the image. Values of 1 or more (or 0 and less) mean no scaling.
+		/// @return The power-of-two divisor of the image dimensions. The downscaled size is the original size divided by this value and rounded up.
+		/// @note Only power-of-two reductions are used, because they can be done exactly by the decoders. The scale is rounded to the nearest reduction that isn't smaller than requested.
+		static int calcDownscaleDivisor(int w, int h, int maxDimension, float scale);
+		/// @brief Calculates how many levels a full mipmap chain has.
+		/// @param[in] w Width of the base level.
+		/// @param[in] h Height of the base level.
+		/// @return How many levels a full mipmap chain has, including the base level.
+		static int calcMipmapLevels(int w, int h);
+		/// @brief Calculates the byte size of a mipmap chain.
+		/// @param[in] w Width of the base level.
+		/// @param[in] h Height of the base level.
+		/// @param[in] bpp Bytes per pixel.
+		/// @param[in] levels How many levels the mipmap chain has, including the base level.
+		/// @return The byte size of all levels of the mipmap chain.
+		static int calcMipmapChainSize(int w, int h, int bpp, int levels);
+		/// @brief Creates the next smaller mipmap level from raw image data.
+		/// @param[in] w Width of the raw image data.
+		/// @param[in] h Height of the raw image data.
+		/// @param[in] srcData The source raw image data.
+		/// @param[in] srcFormat The pixel format of source raw image data.
+		/// @param[out] destData The destination raw image data.
+		/// @return True if successful.
+		/// @note The new size is half of the source size rounded down, but at least 1. A 2x2 box filter is used.
+		/// @note Format::Compressed and Format::Palette data isn't supported.
+		static bool createMipmapLevel(int w, int h, unsigned char* srcData, Format srcFormat, unsigned char** destData);
+		/// @brief Calculates the byte size of block compressed image data.
+		/// @param[in] w Width of the image.
+		/// @param[in] h Height of the image.
+		/// @param[in] blockFormat The block compression format.
+		/// @return The byte size of the block compressed image data.
+		static int getBlockDataSize(int w, int h, BlockFormat blockFormat);
+		/// @brief Encodes raw image data into a GPU block compression format.
+		/// @param[in] w Width of the raw image data.
+		/// @param[in] h Height of the raw image data.
+		/// @param[in] srcData The source raw image data.
+		/// @param[in] srcFormat The pixel format of source raw image data.
+		/// @param[in] blockFormat The block compression format.
+		/// @param[in,out] destData The destination block compressed data.
+		/// @return True if successful.
+		/// @note If destData has not been allocated yet, it will be allocated with the new operator.
+		/// @note The encoder favors speed over quality so it can be used at runtime. Partial blocks on the edges repeat the last column and row.
+		static bool encodeBlocks(int w, int h, unsigned char* srcData, Format srcFormat, BlockFormat blockFormat, unsigned char** destData);
 		
 		/// @brief Checks if the coordinates are out of bounds.
 		/// @param[in] x Position X-coordinate.
@@ -927,6 +1049,13 @@ namespace april
 		/// @note The loading function will only be triggered if the extension is added with april::setTextureExtensions as well.
 		/// @see setTextureExtensions
 		static void registerCustomLoader(chstr extension, Image* (*loadFunction)(hsbase&), Image* (*metaDataLoadfunction)(hsbase&));
+		/// @brief Registers a custom image loader that can downscale while decoding.
+		/// @param[in] extension Filename extension.
+		/// @param[in] loadFunction The function pointer to use for loading the Image with a maximum dimension and a scale factor.
+		/// @note The regular custom loader has to be registered as well, this one is only used when an image is loaded with downscaling.
+		/// @see registerCustomLoader
+		/// @see calcDownscaleDivisor
+		static void registerCustomScaledLoader(chstr extension, Image* (*loadFunction)(hsbase&, int, float));
 		/// @brief Registers a custom image saver for custom image formats.
 		/// @param[in] extension Filename extension.
 		/// @param[in] saveFunction The function pointer to use for loading the Image.
@@ -946,11 +1075,17 @@ namespace april
 		static hmap<hstr, Image* (*)(hsbase&)> customLoaders;
 		/// @brief Custom image format meta data loaders.
 		static hmap<hstr, Image* (*)(hsbase&)> customMetaDataLoaders;
+		/// @brief Custom image format loaders that can downscale while decoding.
+		static hmap<hstr, Image* (*)(hsbase&, int, float)> customScaledLoaders;
 		/// @brief Custom image format savers.
 		static hmap<hstr, bool (*)(hsbase&, Image*, SaveParameters)> customSavers;
 		/// @brief Custom image format saver default parameters.
 		static hmap<hstr, SaveParameters (*)()> customSaverDefaultParameters;
 
+		/// @brief Checks whether a file's format can be downscaled while it's being decoded.
+		/// @param[in] filename Filename or logical extension of the file.
+		/// @return True if the file's format can be downscaled while it's being decoded.
+		static bool _canDownscaleWhileDecoding(chstr filename);
 		/// @brief Loads and decodes PNG file data.
 		/// @param[in] stream The encoded image data stream.
 		/// @param[in] size The size within the data stream that actually belongs to this encoded file.
@@ -958,6 +1093,16 @@ namespace april
 		static Image* _loadPng(hsbase& stream, int size);
 		/// @brief Loads and decodes PNG file data.
 		/// @param[in] stream The encoded image data stream.
+		/// @param[in] size The size within the data stream that actually belongs to this encoded file.
+		/// @param[in] keepPalette Whether paletted PNG files should be kept as Format::Palette instead of being expanded to RGB(A).
+		/// @param[in] maxDimension Maximum width and height of the decoded image. 0 or less means no limit.
+		/// @param[in] scale Scale factor for the decoded image.
+		/// @return The created Image object or NULL if failed.
+		/// @note Non-interlaced data is box filtered row by row while reading so the full sized image is never held in memory.
+		/// @see calcDownscaleDivisor
+		static Image* _loadPng(hsbase& stream, int size, bool keepPalette, int maxDimension, float scale);
+		/// @brief Loads and decodes PNG file data.
+		/// @param[in] stream The encoded image data stream.
 		/// @return The created Image object or NULL if failed.
 		static Image* _loadPng(hsbase& stream);
 		/// @brief Loads and decodes JPG file data.
@@ -967,6 +1112,15 @@ namespace april
 		static Image* _loadJpg(hsbase& stream, int size);
 		/// @brief Loads and decodes JPG file data.
 		/// @param[in] stream The encoded image data stream.
+		/// @param[in] size The size within the data stream that actually belongs to this encoded file.
+		/// @param[in] maxDimension Maximum width and height of the decoded image. 0 or less means no limit.
+		/// @param[in] scale Scale factor for the decoded image.
+		/// @return The created Image object or NULL if failed.
+		/// @note Uses the DCT scaling of libjpeg so only the reduced image is actually decoded.
+		/// @see calcDownscaleDivisor
+		static Image* _loadJpg(hsbase& stream, int size, int maxDimension, float scale);
+		/// @brief Loads and decodes JPG file data.
+		/// @param[in] stream The encoded image data stream.
 		/// @return The created Image object or NULL if failed.
 		static Image* _loadJpg(hsbase& stream);
 		/// @brief Loads and decodes JPT file data.
@@ -996,6 +1150,22 @@ namespace april
 		/// @param[in] stream The encoded image data stream.
 		/// @return The created Image object or NULL if failed.
 		static Image* _loadPvrz(hsbase& stream);
+		/// @brief Loads and decodes QOI file data.
+		/// @param[in] stream The encoded image data stream.
+		/// @param[in] size The size within the data stream that actually belongs to this encoded file.
+		/// @param[in] format Pixel format to decode into directly. Format::Invalid uses the format stored in the file.
+		/// @return The created Image object or NULL if failed.
+		/// @note 3 and 4 BPP formats are decoded into directly, other formats are converted after decoding.
+		static Image* _loadQoi(hsbase& stream, int size, Format format);
+		/// @brief Loads and decodes QOI file data.
+		/// @param[in] stream The encoded image data stream.
+		/// @param[in] size The size within the data stream that actually belongs to this encoded file.
+		/// @return The created Image object or NULL if failed.
+		static Image* _loadQoi(hsbase& stream, int size);
+		/// @brief Loads and decodes QOI file data.
+		/// @param[in] stream The encoded image data stream.
+		/// @return The created Image object or NULL if failed.
+		static Image* _loadQoi(hsbase& stream);
 
 		/// @brief Saves image data into a stream encoded as PNG file.
 		/// @param[in,out] stream The destination image data stream.
@@ -1009,6 +1179,12 @@ namespace april
 		/// @param[in] parameters Special parameters that can be adjusted in the saving Format.
 		/// @return True if successful.
 		static bool _saveJpeg(hsbase& stream, Image* image, SaveParameters parameters);
+		/// @brief Saves image data into a stream encoded as QOI file.
+		/// @param[in,out] stream The destination image data stream.
+		/// @param[in] image The Image object to save.
+		/// @param[in] parameters Special parameters that can be adjusted in the saving Format.
+		/// @return True if successful.
+		static bool _saveQoi(hsbase& stream, Image* image, SaveParameters parameters);
 		/// @brief Loads and decodes meta data from PNG file data.
 		/// @param[in] stream The encoded image data stream.
 		/// @param[in] size The size within the data stream that actually belongs to this encoded file.
@@ -1054,6 +1230,15 @@ namespace april
 		/// @param[in] stream The encoded image data stream.
 		/// @return The created Image object or NULL if failed.
 		static Image* _readMetaDataPvrz(hsbase& stream);
+		/// @brief Loads and decodes meta data from QOI file data.
+		/// @param[in] stream The encoded image data stream.
+		/// @param[in] size The size within the data stream that actually belongs to this encoded file.
+		/// @return The created Image object or NULL if failed.
+		static Image* _readMetaDataQoi(hsbase& stream, int size);
+		/// @brief Loads and decodes meta data from QOI file data.
+		/// @param[in] stream The encoded image data stream.
+		/// @return The created Image object or NULL if failed.
+		static Image* _readMetaDataQoi(hsbase& stream);
 
 		/// @brief Converts raw image data from a source pixel format with 1 byte-per-pixel to a raw image data destination.
 		/// @param[in] w Width of the data to convert.
@@ -1088,6 +1273,34 @@ namespace april
 		/// @note This is a utility method called by convertToFormat to split a large method into a few smaller ones.
 		/// @see convertToFormat
 		static bool _convertFrom4Bpp(int w, int h, unsigned char* srcData, Format srcFormat, unsigned char** destData, Format destFormat);
+		/// @brief Converts raw image data from Format::Palette to a raw image data destination.
+		/// @param[in] w Width of the data to convert.
+		/// @param[in] h Height of the data to convert.
+		/// @param[in] srcData The source raw image data.
+		/// @param[in,out] destData The destination raw image data.
+		/// @param[in] destFormat The pixel format of destination raw image data.
+		/// @return True if successful.
+		/// @note The palette is first converted into a lookup table in the destination format so every pixel is resolved with a single table lookup.
+		/// @note This is a utility method called by convertToFormat to split a large method into a few smaller ones.
+		/// @see convertToFormat
+		static bool _convertFromPalette(int w, int h, unsigned char* srcData, unsigned char** destData, Format destFormat);
+
+		/// @brief Adds a row of raw image data to the box filter sums used for downscaling.
+		/// @param[in] srcRow The source row of raw image data.
+		/// @param[in] srcWidth Width of the source row.
+		/// @param[in] bpp Bytes per pixel of the source row.
+		/// @param[in] divisor By how much the width is reduced.
+		/// @param[in,out] sums The channel sums of the downscaled row.
+		/// @note This is used by decoders to downscale images while data is read row by row.
+		static void _boxFilterAddRow(const unsigned char* srcRow, int srcWidth, int bpp, int divisor, unsigned int* sums);
+		/// @brief Writes the averaged box filter sums into a downscaled row and resets the sums.
+		/// @param[in,out] sums The channel sums of the downscaled row.
+		/// @param[in] srcWidth Width of the source rows.
+		/// @param[in] bpp Bytes per pixel.
+		/// @param[in] divisor By how much the width is reduced.
+		/// @param[in] rowCount How many source rows were added to the sums.
+		/// @param[out] destRow The destination row of raw image data.
+		static void _boxFilterWriteRow(unsigned int* sums, int srcWidth, int bpp, int divisor, int rowCount, unsigned char* destRow);
 
 		/// @brief Executes a raw image data block transfer from a source pixel format with 1 byte-per-pixel to a raw image data destination.
 		/// @param[in] sx Source data X-coordinate.
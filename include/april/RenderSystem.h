@@ -13,6 +13,9 @@
 #ifndef APRIL_RENDER_SYSTEM_H
 #define APRIL_RENDER_SYSTEM_H
 
+#include <condition_variable>
+#include <mutex>
+
 #include <hltypes/harray.h>
 #include <hltypes/henum.h>
 #include <hltypes/hltypesUtil.h>
@@ -33,12 +36,14 @@
 namespace april
 {
 	class Application;
+	class AnimatedTexture;
 	class AssignWindowCommand;
 	class AsyncCommand;
 	class AsyncCommandQueue;
 	class ClearCommand;
 	class ClearColorCommand;
 	class ClearDepthCommand;
+	class CopyTextureCommand;
 	class CreateCommand;
 	class DestroyCommand;
 	class Image;
@@ -65,6 +70,7 @@ namespace april
 		friend class ClearCommand;
 		friend class ClearColorCommand;
 		friend class ClearDepthCommand;
+		friend class CopyTextureCommand;
 		friend class CreateCommand;
 		friend class DestroyCommand;
 		friend class PresentFrameCommand;
@@ -76,6 +82,7 @@ namespace april
 		friend class SuspendCommand;
 		friend class TakeScreenshotCommand;
 		friend class Texture;
+		friend class TextureAtlas;
 		template <typename T> friend class VertexRenderCommand;
 		friend class Window;
 
@@ -141,6 +148,9 @@ namespace april
 			bool intermediateRenderTexture;
 			/// @brief Special debug info.
 			bool debugInfo;
+			/// @brief Whether Format::Palette textures should be kept as index data and resolved in the pixel shader if the render system supports it.
+			/// @note When not enabled or not supported, palette data is expanded on the CPU.
+			bool paletteTextures;
 
 			/// @brief Basic constructor.
 			Options();
@@ -157,6 +167,8 @@ namespace april
 		public:
 			/// @brief The maximum supported texture size.
 			int maxTextureSize;
+			/// @brief The maximum supported anisotropic filtering level.
+			float maxAnisotropy;
 			/// @brief Whether the "limited" implementation of non-power-of-two textures is supported.
 			bool npotTexturesLimited;
 			/// @brief Whether the full implementation of non-power-of-two textures is supported.
@@ -165,6 +177,9 @@ namespace april
 			bool externalTextures;
 			/// @brief Supported texture pixel formats.
 			harray<Image::Format> textureFormats;
+			/// @brief Supported block compression formats that textures can be encoded into at runtime.
+			/// @see Texture::setCompressible
+			harray<Image::BlockFormat> blockFormats;
 			/// @brief Whether render targets are supported properly. Also 
 			/// @note This also controls internal rendertarget usage for basic rendering.
 			bool renderTarget;
@@ -235,8 +250,53 @@ namespace april
 		HL_DEFINE_GET(int, statCurrentFrameLineCount, StatCurrentFrameLineCount);
 		/// @brief Gets how many lines were rendered during the last frame.
 		HL_DEFINE_GET(int, statLastFrameLineCount, StatLastFrameLineCount);
+		/// @brief Gets how many bytes of texture data were uploaded to the GPU during this frame.
+		HL_DEFINE_GET(int64_t, statCurrentFrameTextureUploadBytes, StatCurrentFrameTextureUploadBytes);
+		/// @brief Gets how many bytes of texture data were uploaded to the GPU during the last frame.
+		HL_DEFINE_GET(int64_t, statLastFrameTextureUploadBytes, StatLastFrameTextureUploadBytes);
+		/// @brief Gets how many times a resident texture was bound.
+		HL_DEFINE_GET(int64_t, statTextureResidencyHits, StatTextureResidencyHits);
+		/// @brief Gets how many textures were evicted to stay within the texture memory budgets.
+		HL_DEFINE_GET(int64_t, statTextureEvictions, StatTextureEvictions);
+		/// @brief Gets how many evicted textures were loaded again after being used.
+		HL_DEFINE_GET(int64_t, statTextureReloads, StatTextureReloads);
+		/// @brief Gets how many times a streamed texture's low resolution proxy was bound instead of the texture.
+		HL_DEFINE_GET(int64_t, statTextureProxyUses, StatTextureProxyUses);
+		/// @brief Gets how many times a pooled render target could be reused.
+		HL_DEFINE_GET(int64_t, statRenderTargetPoolHits, StatRenderTargetPoolHits);
+		/// @brief Gets how many times a new render target had to be created for the render target pool.
+		HL_DEFINE_GET(int64_t, statRenderTargetPoolMisses, StatRenderTargetPoolMisses);
+		/// @brief Gets how many textures were loaded from the decoded texture cache instead of being decoded.
+		/// @return How many textures were loaded from the decoded texture cache instead of being decoded.
+		/// @see april::setTextureCachePath
+		int64_t getStatTextureCacheHits() const;
+		/// @brief Gets how many textures had to be decoded because they weren't in the decoded texture cache.
+		/// @return How many textures had to be decoded because they weren't in the decoded texture cache.
+		int64_t getStatTextureCacheMisses() const;
+		/// @brief Gets how many decoded textures were written to the decoded texture cache.
+		/// @return How many decoded textures were written to the decoded texture cache.
+		int64_t getStatTextureCacheWrites() const;
+		/// @brief Gets how many entries were removed from the decoded texture cache to stay within its size limit.
+		/// @return How many entries were removed from the decoded texture cache to stay within its size limit.
+		/// @see april::setTextureCacheMaxSize
+		int64_t getStatTextureCacheEvictions() const;
+		/// @brief Gets the current size of the decoded texture cache in bytes.
+		/// @return The current size of the decoded texture cache in bytes.
+		int64_t getStatTextureCacheSize() const;
+		/// @brief The texture that is used instead of an evicted texture while it's being loaded again.
+		/// @note If this is NULL, no texture is used.
+		/// @see april::setTextureVRamBudget
+		HL_DEFINE_GETSET(Texture*, residencyPlaceholderTexture, ResidencyPlaceholderTexture);
 		/// @brief Gets how frames are queued for rendering.
 		int getAsyncQueuesCount();
+		/// @brief Gets how many shared texture atlas pages currently exist.
+		/// @return How many shared texture atlas pages currently exist.
+		/// @see april::setTextureAtlasMaxDimension
+		int getTextureAtlasPageCount();
+		/// @brief Gets how much of the shared texture atlas pages' area is used by packed textures, including their padding.
+		/// @return How much of the shared texture atlas pages' area is used by packed textures, from 0.0 to 1.0.
+		/// @see april::setTextureAtlasMaxDimension
+		float getTextureAtlasOccupancy();
 		/// @brief Gets all currently existing textures in the RenderSystem.
 		/// @return All currently existing textures in the RenderSystem.
 		harray<Texture*> getTextures();
@@ -313,6 +373,16 @@ namespace april
 		/// @return The created Texture object or NULL if failed.
 		/// @note When a format is forced, it's best to use managed (but not necessary).
 		Texture* createTextureFromResource(chstr filename, Image::Format format, Texture::Type type = Texture::Type::Managed, Texture::LoadMode loadMode = Texture::LoadMode::Async);
+		/// @brief Creates a Texture object from a resource file that is downscaled while loading.
+		/// @param[in] filename The filename of the resource.
+		/// @param[in] maxDimension Max width and height of the loaded image data. 0 or less means no limit.
+		/// @param[in] scale Scale factor of the loaded image data.
+		/// @param[in] type The Texture type that should be created.
+		/// @param[in] loadMode How and when the Texture should be loaded.
+		/// @return The created Texture object or NULL if failed.
+		/// @note This overrides the global settings from april::setMaxTextureLoadDimension() and april::setTextureLoadScale().
+		/// @see Image::calcDownscaleDivisor
+		Texture* createTextureFromResource(chstr filename, int maxDimension, float scale, Texture::Type type = Texture::Type::Immutable, Texture::LoadMode loadMode = Texture::LoadMode::Async);
 		/// @brief Creates a Texture object from a file.
 		/// @param[in] filename The filename of the file.
 		/// @param[in] type The Texture type that should be created.
@@ -327,6 +397,16 @@ namespace april
 		/// @return The created Texture object or NULL if failed.
 		/// @note When a format is forced, it's best to use managed (but not necessary).
 		Texture* createTextureFromFile(chstr filename, Image::Format format, Texture::Type type = Texture::Type::Managed, Texture::LoadMode loadMode = Texture::LoadMode::Async);
+		/// @brief Creates a Texture object from a file that is downscaled while loading.
+		/// @param[in] filename The filename of the file.
+		/// @param[in] maxDimension Max width and height of the loaded image data. 0 or less means no limit.
+		/// @param[in] scale Scale factor of the loaded image data.
+		/// @param[in] type The Texture type that should be created.
+		/// @param[in] loadMode How and when the Texture should be loaded.
+		/// @return The created Texture object or NULL if failed.
+		/// @note This overrides the global settings from april::setMaxTextureLoadDimension() and april::setTextureLoadScale().
+		/// @see Image::calcDownscaleDivisor
+		Texture* createTextureFromFile(chstr filename, int maxDimension, float scale, Texture::Type type = Texture::Type::Immutable, Texture::LoadMode loadMode = Texture::LoadMode::Async);
 		/// @brief Creates a Texture object from raw data.
 		/// @param[in] w Width of the image data.
 		/// @param[in] h Height of the image data.
@@ -353,7 +433,91 @@ namespace april
 		/// @brief Destroys a Texture object.
 		/// @param[in] texture The Texture that should be destroyed.
 		/// @note After this call the Texture pointer becomes invalid.
+		/// @note Shared textures should be released with releaseSharedTexture() instead.
+		/// @note Pooled render targets should be released with releaseRenderTarget() instead.
 		void destroyTexture(Texture* texture);
+		/// @brief Gets a render target from the render target pool and creates it if there is no free one with the same size.
+		/// @param[in] w Width of the render target.
+		/// @param[in] h Height of the render target.
+		/// @return The render target or NULL if failed.
+		/// @note Every call has to be matched with a call to releaseRenderTarget().
+		/// @note The contents of a reused render target are undefined.
+		Texture* acquireRenderTarget(int w, int h);
+		/// @brief Gets a render target from the render target pool that is released automatically at the end of the frame.
+		/// @param[in] w Width of the render target.
+		/// @param[in] h Height of the render target.
+		/// @return The render target or NULL if failed.
+		/// @note The render target must not be used anymore after presentFrame() was called.
+		/// @note The contents of a reused render target are undefined.
+		Texture* acquireTransientRenderTarget(int w, int h);
+		/// @brief Returns a render target to the render target pool.
+		/// @param[in] texture The render target.
+		/// @note Released render targets are only handed out again in a later frame so they can still be used by rendering in this frame.
+		/// @note Render targets that weren't used for a while are destroyed.
+		/// @see april::setRenderTargetPoolMaxIdleFrames
+		void releaseRenderTarget(Texture* texture);
+		/// @brief Gets a shared Texture object for a resource file and creates it if it doesn't exist yet.
+		/// @param[in] filename The filename of the resource.
+		/// @param[in] type The Texture type that should be created.
+		/// @param[in] loadMode How and when the Texture should be loaded.
+		/// @return The shared Texture object or NULL if failed.
+		/// @note Every call has to be matched with a call to releaseSharedTexture().
+		/// @note Textures are shared when the resolved filename, type, format and load mode are the same, so the image is only decoded and uploaded once.
+		Texture* acquireSharedTextureFromResource(chstr filename, Texture::Type type = Texture::Type::Immutable, Texture::LoadMode loadMode = Texture::LoadMode::Async);
+		/// @brief Gets a shared Texture object for a resource file and creates it if it doesn't exist yet.
+		/// @param[in] filename The filename of the resource.
+		/// @param[in] format To which pixel format the loaded data should be converted.
+		/// @param[in] type The Texture type that should be created.
+		/// @param[in] loadMode How and when the Texture should be loaded.
+		/// @return The shared Texture object or NULL if failed.
+		/// @note Every call has to be matched with a call to releaseSharedTexture().
+		Texture* acquireSharedTextureFromResource(chstr filename, Image::Format format, Texture::Type type = Texture::Type::Managed, Texture::LoadMode loadMode = Texture::LoadMode::Async);
+		/// @brief Gets a shared Texture object for a file and creates it if it doesn't exist yet.
+		/// @param[in] filename The filename of the file.
+		/// @param[in] type The Texture type that should be created.
+		/// @param[in] loadMode How and when the Texture should be loaded.
+		/// @return The shared Texture object or NULL if failed.
+		/// @note Every call has to be matched with a call to releaseSharedTexture().
+		/// @note Textures are shared when the resolved filename, type, format and load mode are the same, so the image is only decoded and uploaded once.
+		Texture* acquireSharedTextureFromFile(chstr filename, Texture::Type type = Texture::Type::Immutable, Texture::LoadMode loadMode = Texture::LoadMode::Async);
+		/// @brief Gets a shared Texture object for a file and creates it if it doesn't exist yet.
+		/// @param[in] filename The filename of the file.
+		/// @param[in] format To which pixel format the loaded data should be converted.
+		/// @param[in] type The Texture type that should be created.
+		/// @param[in] loadMode How and when the Texture should be loaded.
+		/// @return The shared Texture object or NULL if failed.
+		/// @note Every call has to be matched with a call to releaseSharedTexture().
+		Texture* acquireSharedTextureFromFile(chstr filename, Image::Format format, Texture::Type type = Texture::Type::Managed, Texture::LoadMode loadMode = Texture::LoadMode::Async);
+		/// @brief Releases a reference to a shared Texture object.
+		/// @param[in] texture The shared Texture.
+		/// @note The Texture is destroyed when the last reference is released. After that the Texture pointer becomes invalid.
+		void releaseSharedTexture(Texture* texture);
+		/// @brief Gets how many references to a shared Texture object currently exist.
+		/// @param[in] texture The shared Texture.
+		/// @return How many references currently exist or 0 if the Texture isn't shared.
+		int getSharedTextureReferenceCount(Texture* texture);
+		/// @brief Creates an AnimatedTexture object from a sequence of resource files.
+		/// @param[in] filenames The filenames of the frame resources.
+		/// @param[in] frameRate How many frames are displayed per second. 0 or less uses the frame rate stored in an animated file.
+		/// @param[in] looping Whether playback restarts from the first frame after the last frame.
+		/// @param[in] ringSize How many GPU textures are used to hold frames that are uploaded ahead of the playback clock.
+		/// @return The created AnimatedTexture object or NULL if failed.
+		/// @note All frames need to have the same size as the first one.
+		/// @note A single file is played as an animated file if a frame source is registered for its extension (see AnimatedTexture::registerCustomFrameSource()).
+		AnimatedTexture* createAnimatedTextureFromResource(const harray<hstr>& filenames, float frameRate, bool looping = true, int ringSize = 3);
+		/// @brief Creates an AnimatedTexture object from a sequence of files.
+		/// @param[in] filenames The filenames of the frame files.
+		/// @param[in] frameRate How many frames are displayed per second. 0 or less uses the frame rate stored in an animated file.
+		/// @param[in] looping Whether playback restarts from the first frame after the last frame.
+		/// @param[in] ringSize How many GPU textures are used to hold frames that are uploaded ahead of the playback clock.
+		/// @return The created AnimatedTexture object or NULL if failed.
+		/// @note All frames need to have the same size as the first one.
+		/// @note A single file is played as an animated file if a frame source is registered for its extension (see AnimatedTexture::registerCustomFrameSource()).
+		AnimatedTexture* createAnimatedTextureFromFile(const harray<hstr>& filenames, float frameRate, bool looping = true, int ringSize = 3);
+		/// @brief Destroys an AnimatedTexture object.
+		/// @param[in] animatedTexture The AnimatedTexture that should be destroyed.
+		/// @note After this call the AnimatedTexture pointer becomes invalid.
+		void destroyAnimatedTexture(AnimatedTexture* animatedTexture);
 
 		/// @brief Creates a pixel shader from a resource file.
 		/// @param[in] filename The filename of the resource file.
@@ -575,6 +739,10 @@ namespace april
 		/// @param[in] includeExtension Whether the exact extension should be included.
 		/// @return The detected filename or an empty string if no file could be found.
 		hstr findTextureFile(chstr filename, bool includeExtension = false) const;
+		/// @brief Discards cached directory contents used by findTextureResource() and findTextureFile().
+		/// @param[in] path A directory or a file within a directory whose contents changed. An empty string discards everything.
+		/// @note Texture lookups scan each directory only once, so this has to be called when texture files are added or removed at runtime (e.g. hot reloading).
+		void invalidateTextureLookups(chstr path = "");
 		/// @brief Unloads all textures.
 		/// @note Useful for clearing all memory or if something invalidates textures and cannot guarantee that they are loaded anymore.
 		void unloadTextures();
@@ -601,6 +769,31 @@ namespace april
 		/// @param[in] format The format to which the screenshot should be converted.
 		/// @param[in] backBufferOnly Whether only the backbuffer data should be used and nothing else.
 		void takeScreenshot(Image::Format format, bool backBufferOnly = true);
+		/// @brief Copies an area of a texture into another texture on the GPU without going through the CPU.
+		/// @param[in] source The source Texture.
+		/// @param[in] destination The destination Texture.
+		/// @param[in] sourceRect The area on the source to be copied.
+		/// @param[in] destinationPosition Where the area is copied to on the destination.
+		/// @note Pixels on the destination will be overwritten. The area is clipped to both textures.
+		/// @note This works with textures that don't have any CPU-side data anymore. The CPU-side data of the destination isn't updated.
+		/// @note The destination isn't evicted after this and later CPU-side changes only upload the changed areas, except when they cover the whole
+		/// texture. The copied content is lost if the destination is unloaded manually or the device is lost.
+		/// @note The copy is executed on the render thread in the order it was called with other rendering operations.
+		void copyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgvec2i destinationPosition);
+		/// @brief Copies an entire texture into another texture on the GPU without going through the CPU.
+		/// @param[in] source The source Texture.
+		/// @param[in] destination The destination Texture.
+		/// @see copyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgvec2i destinationPosition)
+		void copyTexture(Texture* source, Texture* destination);
+		/// @brief Copies an area of a texture into another texture on the GPU while stretching it to the destination area.
+		/// @param[in] source The source Texture.
+		/// @param[in] destination The destination Texture.
+		/// @param[in] sourceRect The area on the source to be copied.
+		/// @param[in] destinationRect The area on the destination to be covered.
+		/// @note Pixels on the destination will be overwritten. Stretched pixels use the source's filter.
+		/// @note Render systems without a native implementation can only blit into render targets.
+		/// @see copyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgvec2i destinationPosition)
+		void blitTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect);
 		/// @brief Flushes the currently rendered data to the backbuffer for display.
 		/// @note Usually this doesn't need to be called manually. Calls flushFrame().
 		/// @see flushFrame
@@ -630,6 +823,30 @@ namespace april
 		RenderState* deviceState;
 		/// @brief Mutex required for registering and unregistering of textures that allows for multi-threaded access.
 		hmutex texturesMutex;
+		/// @brief Shared textures by their sharing key.
+		/// @note The key consists of the source, the resolved filename, the type, the format and the load mode.
+		/// @note A NULL entry is a placeholder for a shared texture that is still being created.
+		hmap<hstr, Texture*> sharedTextures;
+		/// @brief How many references to each shared texture currently exist.
+		hmap<Texture*, int> sharedTextureReferences;
+		/// @brief Mutex for shared textures.
+		/// @note hmutex can't be used with condition variables.
+		std::mutex sharedTexturesMutex;
+		/// @brief Signaled when a shared texture placeholder was replaced or removed.
+		/// @note Concurrent requests for a texture that is still being created wait for it instead of creating it twice.
+		std::condition_variable sharedTextureCreatedCondition;
+		/// @brief Render targets from the render target pool that are currently in use.
+		harray<Texture*> pooledRenderTargets;
+		/// @brief Pooled render targets that are released automatically at the end of the frame.
+		harray<Texture*> transientRenderTargets;
+		/// @brief Released render targets that can be reused.
+		harray<Texture*> freeRenderTargets;
+		/// @brief In which frame each free render target was released.
+		hmap<Texture*, int64_t> freeRenderTargetFrames;
+		/// @brief Number of presented frames used for releasing pooled render targets.
+		int64_t renderTargetPoolFrame;
+		/// @brief Mutex for the render target pool.
+		hmutex renderTargetPoolMutex;
 		/// @brief Mutex required for async update/rendering.
 		hmutex asyncMutex;
 		/// @brief Special helper object that can handle rendering in a different way.
@@ -681,6 +898,30 @@ namespace april
 		int statCurrentFrameLineCount;
 		/// @brief How many lines were rendered during the last frame.
 		int statLastFrameLineCount;
+		/// @brief How many bytes of texture data were uploaded to the GPU during this frame.
+		int64_t statCurrentFrameTextureUploadBytes;
+		/// @brief How many bytes of texture data were uploaded to the GPU during the last frame.
+		int64_t statLastFrameTextureUploadBytes;
+		/// @brief How many times a resident texture was bound.
+		int64_t statTextureResidencyHits;
+		/// @brief How many textures were evicted to stay within the texture memory budgets.
+		int64_t statTextureEvictions;
+		/// @brief How many evicted textures were loaded again after being used.
+		int64_t statTextureReloads;
+		/// @brief How many times a streamed texture's low resolution proxy was bound instead of the texture.
+		int64_t statTextureProxyUses;
+		/// @brief How many times a pooled render target could be reused.
+		int64_t statRenderTargetPoolHits;
+		/// @brief How many times a new render target had to be created for the render target pool.
+		int64_t statRenderTargetPoolMisses;
+		/// @brief The texture that is used instead of an evicted texture while it's being loaded again.
+		Texture* residencyPlaceholderTexture;
+		/// @brief Number of presented frames used to find the least recently used textures.
+		int64_t residencyFrame;
+		/// @brief Whether the bound texture is an atlas page that was bound in place of a packed texture.
+		bool deviceAtlasUsed;
+		/// @brief The region of the packed texture in the bound atlas page.
+		grectf deviceAtlasUvRect;
 
 		/// @brief Registers a created Texture in the system.
 		/// @param[in] texture The Texture to be registered.
@@ -695,8 +936,43 @@ namespace april
 		/// @param[in] type The Texture type that should be created.
 		/// @param[in] loadMode How and when the Texture should be loaded.
 		/// @param[in] format To which pixel format the loaded data should be converted.
+		/// @param[in] maxDimension Max width and height of the loaded image data. Negative values use the global setting.
+		/// @param[in] scale Scale factor of the loaded image data. Negative values use the global setting.
 		/// @return The created Texture object or NULL if failed.
-		Texture* _createTextureFromSource(bool fromResource, chstr filename, Texture::Type type, Texture::LoadMode loadMode, Image::Format format = Image::Format::Invalid);
+		Texture* _createTextureFromSource(bool fromResource, chstr filename, Texture::Type type, Texture::LoadMode loadMode, Image::Format format = Image::Format::Invalid, int maxDimension = -1, float scale = -1.0f);
+		/// @brief Internally safe method for getting a shared Texture object.
+		/// @param[in] fromResource Whether the Texture should be created from a resource file or a normal file.
+		/// @param[in] filename The filename of the texture.
+		/// @param[in] type The Texture type that should be created.
+		/// @param[in] loadMode How and when the Texture should be loaded.
+		/// @param[in] format To which pixel format the loaded data should be converted.
+		/// @return The shared Texture object or NULL if failed.
+		Texture* _acquireSharedTextureFromSource(bool fromResource, chstr filename, Texture::Type type, Texture::LoadMode loadMode, Image::Format format = Image::Format::Invalid);
+		/// @brief Removes a Texture from the shared textures without destroying it.
+		/// @param[in] texture The Texture.
+		/// @note This expects sharedTexturesMutex to be locked.
+		void _removeSharedTexture(Texture* texture);
+		/// @brief Internally safe method for getting a render target from the render target pool.
+		/// @param[in] width Width of the render target.
+		/// @param[in] height Height of the render target.
+		/// @param[in] transient Whether the render target is released automatically at the end of the frame.
+		/// @return The render target or NULL if failed.
+		Texture* _acquireRenderTarget(int width, int height, bool transient);
+		/// @brief Removes a Texture from the render target pool without destroying it.
+		/// @param[in] texture The Texture.
+		/// @note This expects renderTargetPoolMutex to be locked.
+		void _removePooledRenderTarget(Texture* texture);
+		/// @brief Releases transient render targets and destroys render targets that weren't used for a while.
+		/// @note This is called at the end of every frame.
+		void _updateRenderTargetPool();
+		/// @brief Internally safe method for creating an AnimatedTexture object.
+		/// @param[in] fromResource Whether the AnimatedTexture should be created from resource files or normal files.
+		/// @param[in] filenames The filenames of the frames.
+		/// @param[in] frameRate How many frames are displayed per second.
+		/// @param[in] looping Whether playback restarts from the first frame after the last frame.
+		/// @param[in] ringSize How many GPU textures are used to hold frames.
+		/// @return The created AnimatedTexture object or NULL if failed.
+		AnimatedTexture* _createAnimatedTextureFromSource(bool fromResource, const harray<hstr>& filenames, float frameRate, bool looping, int ringSize);
 		/// @brief Internally safe method for creating a PixelShader object.
 		/// @param[in] fromResource Whether the PixelShader should be created from a resource file or a normal file.
 		/// @param[in] filename The filename of the pixel shader.
@@ -714,6 +990,53 @@ namespace april
 		/// @param[in] ignoreRenderTarget If true, will ignore render target setup (used for intermediate render textures).
 		/// @note The parameter forceUpdate is useful when the device is in an unknown or inconsistent state, but should be used with care as it invalidates all optimizations.
 		virtual void _updateDeviceState(RenderState* state, bool forceUpdate = false, bool ignoreRenderTarget = false);
+		/// @brief Prepares both textures and copies texture data on the GPU.
+		/// @param[in] source The source Texture.
+		/// @param[in] destination The destination Texture.
+		/// @param[in] sourceRect The area on the source to be copied.
+		/// @param[in] destinationRect The area on the destination to be covered.
+		/// @note A plain copy is used when the areas have the same size, a blit otherwise.
+		void _copyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect);
+		/// @brief Renders an area of a texture into an area of another texture with a textured quad.
+		/// @param[in] source The source Texture.
+		/// @param[in] destination The destination Texture.
+		/// @param[in] sourceRect The area on the source to be copied.
+		/// @param[in] destinationRect The area on the destination to be covered.
+		/// @param[in] flipped Whether the destination's rows are stored bottom-up in the framebuffer.
+		/// @note The destination is bound as render target so the render system has to be able to render into it.
+		/// @note The source is bound directly without a proxy or placeholder so it has to be loaded already.
+		void _renderTextureQuad(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect, bool flipped);
+		/// @brief Marks a texture as used and gets the texture that should actually be bound.
+		/// @param[in] texture The texture that should be bound.
+		/// @return The texture that should actually be bound. This can be the placeholder texture or NULL if the texture was evicted and isn't available yet.
+		Texture* _useResidentTexture(Texture* texture);
+		/// @brief Evicts the least recently used textures if the texture memory budgets are exceeded.
+		/// @note This is called after a frame was presented.
+		void _updateTextureResidency();
+		/// @brief Gets the vertices that should actually be rendered with the bound texture.
+		/// @param[in] vertices The vertices.
+		/// @param[in] count The number of vertices.
+		/// @return The vertices that should actually be rendered.
+		/// @note Vertices with texture coordinates are remapped into the atlas page region if an atlas page was bound in place of a packed texture.
+		PlainVertex* _useDeviceAtlasVertices(PlainVertex* vertices, int count);
+		/// @brief Gets the vertices that should actually be rendered with the bound texture.
+		/// @param[in] vertices The vertices.
+		/// @param[in] count The number of vertices.
+		/// @return The vertices that should actually be rendered.
+		/// @note Vertices with texture coordinates are remapped into the atlas page region if an atlas page was bound in place of a packed texture.
+		TexturedVertex* _useDeviceAtlasVertices(TexturedVertex* vertices, int count);
+		/// @brief Gets the vertices that should actually be rendered with the bound texture.
+		/// @param[in] vertices The vertices.
+		/// @param[in] count The number of vertices.
+		/// @return The vertices that should actually be rendered.
+		/// @note Vertices with texture coordinates are remapped into the atlas page region if an atlas page was bound in place of a packed texture.
+		ColoredVertex* _useDeviceAtlasVertices(ColoredVertex* vertices, int count);
+		/// @brief Gets the vertices that should actually be rendered with the bound texture.
+		/// @param[in] vertices The vertices.
+		/// @param[in] count The number of vertices.
+		/// @return The vertices that should actually be rendered.
+		/// @note Vertices with texture coordinates are remapped into the atlas page region if an atlas page was bound in place of a packed texture.
+		ColoredTexturedVertex* _useDeviceAtlasVertices(ColoredTexturedVertex* vertices, int count);
 		/// @brief Adds a render command to the queue.
 		/// @param[in] command The command to add.
 		void _addAsyncCommand(AsyncCommand* command);
@@ -925,6 +1248,20 @@ namespace april
 		/// @brief Copies RenderTarget data from one texture to another.
 		/// @note Both textures must be render targets.
 		virtual void _deviceCopyRenderTargetData(Texture* source, Texture* destination);
+		/// @brief Copies an area of a texture into another texture without stretching.
+		/// @param[in] source The source Texture.
+		/// @param[in] destination The destination Texture.
+		/// @param[in] sourceRect The area on the source to be copied.
+		/// @param[in] destinationPosition Where the area is copied to on the destination.
+		/// @note By default this uses _deviceBlitTexture().
+		virtual void _deviceCopyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgvec2i destinationPosition);
+		/// @brief Copies an area of a texture into another texture while stretching it.
+		/// @param[in] source The source Texture.
+		/// @param[in] destination The destination Texture.
+		/// @param[in] sourceRect The area on the source to be copied.
+		/// @param[in] destinationRect The area on the destination to be covered.
+		/// @note By default this renders a quad and only works with render targets as destination.
+		virtual void _deviceBlitTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect);
 		/// @brief Takes a screenshot a.k.a. captures the image data of the backbuffer.
 		/// @param[in] format The format to which the screenshot should be converted.
 		/// @param[in] backBufferOnly Whether only the backbuffer data should be used and nothing else.
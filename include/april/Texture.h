@@ -28,21 +28,28 @@
 
 namespace april
 {
+	class AnimatedTexture;
 	class DestroyTextureCommand;
 	class Image;
 	class RenderSystem;
 	class ResetCommand;
 	class TextureAsync;
+	class TextureCompressor;
+	class TextureDataPacker;
 	class UnloadTextureCommand;
 	
 	/// @brief Defines a generic texture.
 	class aprilExport Texture
 	{
 	public:
+		friend class AnimatedTexture;
 		friend class DestroyTextureCommand;
 		friend class RenderSystem;
 		friend class ResetCommand;
 		friend class TextureAsync;
+		friend class TextureAtlas;
+		friend class TextureCompressor;
+		friend class TextureDataPacker;
 		friend class UnloadTextureCommand;
 
 		/// @class Type
@@ -74,6 +81,14 @@ namespace april
 			/// @var static const Filter Filter::Linear
 			/// @brief Linear interpolation.
 			HL_ENUM_DECLARE(Filter, Linear);
+			/// @var static const Filter Filter::MipNearest
+			/// @brief Linear interpolation within the nearest mipmap level.
+			/// @note Mipmaps are created automatically. If they can't be created, Linear is used.
+			HL_ENUM_DECLARE(Filter, MipNearest);
+			/// @var static const Filter Filter::MipLinear
+			/// @brief Linear interpolation within and between the two nearest mipmap levels (trilinear filtering).
+			/// @note Mipmaps are created automatically. If they can't be created, Linear is used.
+			HL_ENUM_DECLARE(Filter, MipLinear);
 		));
 
 		/// @class AddressMode
@@ -105,6 +120,21 @@ namespace april
 			HL_ENUM_DECLARE(LoadMode, OnDemand);
 		));
 
+		/// @class LoadPriority
+		/// @brief Defines in which order asynchronously loaded textures are read and decoded.
+		HL_ENUM_CLASS_PREFIX_DECLARE(aprilExport, LoadPriority,
+		(
+			/// @var static const LoadPriority LoadPriority::Prefetch
+			/// @brief Speculatively loaded texture that is not needed yet. Loaded only when nothing more important is queued.
+			HL_ENUM_DECLARE(LoadPriority, Prefetch);
+			/// @var static const LoadPriority LoadPriority::Normal
+			/// @brief Regular asynchronously loaded texture.
+			HL_ENUM_DECLARE(LoadPriority, Normal);
+			/// @var static const LoadPriority LoadPriority::Visible
+			/// @brief Texture that is needed on screen as soon as possible.
+			HL_ENUM_DECLARE(LoadPriority, Visible);
+		));
+
 		/// @brief The texture filename if available.
 		HL_DEFINE_GET(hstr, filename, Filename);
 		/// @brief The texture's custom name.
@@ -117,20 +147,68 @@ namespace april
 		/// @brief The texture's image data pixel format.
 		HL_DEFINE_GET(Image::Format, format, Format);
 		/// @brief The texture's filtering mode.
-		HL_DEFINE_GETSET(Filter, filter, Filter);
+		HL_DEFINE_GET(Filter, filter, Filter);
+		/// @brief Sets the texture's filtering mode.
+		/// @param[in] value The texture's filtering mode.
+		/// @note Switching to a mipmap filter creates the mipmaps on the next use.
+		/// @note A texture that was packed into a texture atlas is uploaded again on its next use, because atlas pages use one filter for all textures.
+		void setFilter(Filter value);
+		/// @brief The texture's anisotropic filtering level.
+		HL_DEFINE_GET(float, anisotropy, Anisotropy);
+		/// @brief Sets the texture's anisotropic filtering level.
+		/// @param[in] value The texture's anisotropic filtering level.
+		/// @note A value of 1 disables anisotropic filtering. The value is limited by RenderSystem::Caps::maxAnisotropy.
+		void setAnisotropy(float value);
+		/// @brief How many mipmap levels the texture currently has on the GPU, including the base level.
+		HL_DEFINE_GET(int, mipmapLevels, MipmapLevels);
 		/// @brief The texture's UV coordinate address mode.
-		HL_DEFINE_GETSET(AddressMode, addressMode, AddressMode);
+		HL_DEFINE_GET(AddressMode, addressMode, AddressMode);
+		/// @brief Sets the texture's UV coordinate address mode.
+		/// @param[in] value The texture's UV coordinate address mode.
+		/// @note A texture that was packed into a texture atlas is uploaded as its own texture on its next use if it's not eligible for packing anymore.
+		void setAddressMode(AddressMode value);
+		/// @brief The filename of the low resolution proxy image that is shown while the texture is streamed in.
+		/// @see april::setTextureProxySuffix
+		HL_DEFINE_GET(hstr, proxyFilename, ProxyFilename);
+		/// @brief The largest width or height in screen pixels at which the texture is currently displayed.
+		HL_DEFINE_GET(int, visibleDimension, VisibleDimension);
+		/// @brief Sets the largest width or height in screen pixels at which the texture is currently displayed.
+		/// @param[in] value The largest width or height in screen pixels at which the texture is currently displayed.
+		/// @note If the texture has a proxy that is at least this large, the full resolution image isn't loaded asynchronously. Raising the value loads it when needed.
+		/// @note A value of 0 or less means that the full resolution image is always needed.
+		/// @see april::setTextureProxySuffix
+		void setVisibleDimension(int value);
 		/// @brief Whether the texture is locked for raw image data manipulation.
 		HL_DEFINE_IS(locked, Locked);
 		/// @brief Whether the texture is dirty and needs to be reuploaded to the GPU.
 		HL_DEFINE_IS(dirty, Dirty);
 		/// @brief Whether the texture was loaded from a resource file or a normal file.
 		HL_DEFINE_IS(fromResource, FromResource);
+		/// @brief Whether the texture's image data is encoded into a GPU block compression format in the background.
+		HL_DEFINE_IS(compressible, Compressible);
+		/// @brief Sets whether the texture's image data is encoded into a GPU block compression format in the background.
+		/// @param[in] value Whether the texture's image data is encoded into a GPU block compression format in the background.
+		/// @note Only textures that keep their image data in RAM can be compressed (Type::Managed or Type::Immutable created from memory).
+		/// @note Compression only happens if RenderSystem::Caps::blockFormats has a suitable format. Until the compressed data is ready, the uncompressed data is used.
+		/// @note Modifying the image data uploads it uncompressed and queues compression again.
+		/// @see april::setTextureCompressionCachePath
+		void setCompressible(bool value);
+		/// @brief Whether the texture's raw image data is kept compressed in RAM while it isn't used.
+		HL_DEFINE_IS(dataPacking, DataPacking);
+		/// @brief Sets whether the texture's raw image data is kept compressed in RAM while it isn't used.
+		/// @param[in] value Whether the texture's raw image data is kept compressed in RAM while it isn't used.
+		/// @note Only Type::Managed textures keep their image data in RAM, so this has no effect on other types.
+		/// @note The data is decompressed transparently whenever it's read, modified or uploaded again (e.g. after the device was lost).
+		/// @note This is useful for large textures that are rarely modified. Frequently accessed textures only lose time on decompression.
+		/// @see getCurrentRamSize
+		void setDataPacking(bool value);
 		/// @brief Gets the width of the texture in pixels.
 		/// @return Width of the texture in pixels.
+		/// @note If the texture is downscaled while loading, this is the downscaled width, even before the texture is loaded.
 		int getWidth() const;
 		/// @brief Gets the height of the texture in pixels.
 		/// @return Height of the texture in pixels.
+		/// @note If the texture is downscaled while loading, this is the downscaled height, even before the texture is loaded.
 		int getHeight() const;
 		/// @brief Gets the byte-per-pixel value.
 		/// @return The byte-per-pixel value.
@@ -156,6 +234,10 @@ namespace april
 		/// @brief Checks whether the texture has been uploaded to the GPU.
 		/// @return True if the texture has been uploaded to the GPU.
 		bool isUploaded();
+		/// @brief Checks whether the texture on the GPU currently uses block compressed data.
+		/// @return True if the texture on the GPU currently uses block compressed data.
+		/// @see setCompressible
+		bool isBlockCompressed() const;
 		/// @brief Checks whether the texture is ready to be uploaded to the GPU.
 		/// @return True if the texture is ready to be uploaded to the GPU.
 		bool isReadyForUpload();
@@ -176,9 +258,27 @@ namespace april
 		virtual void* getBackendId() const = 0;
 
 		/// @brief Loads the texture asynchronously.
+		/// @param[in] priority The priority class of the load request.
+		/// @param[in] deadline In how many seconds the texture is needed. Within the same priority class, textures with earlier deadlines are loaded first.
 		/// @return True if queueing was successful.
 		/// @note Using a texture before it is uploaded to the GPU will cause undefined behavior. Always call load() before using it, because this ensures that it's loaded.
-		bool loadAsync();
+		/// @note A deadline value of 0.0 or less means that there is no deadline.
+		/// @note Calling this on a texture that is already queued can only raise its priority or move its deadline closer.
+		bool loadAsync(LoadPriority priority = LoadPriority::Normal, float deadline = 0.0f);
+		/// @brief Loads the texture asynchronously and calls a function once it finished loading.
+		/// @param[in] callback Function that is called once the texture finished loading. The success parameter is true if the texture was uploaded to the GPU.
+		/// @param[in] userData Custom data that is passed to the callback.
+		/// @param[in] priority The priority class of the load request.
+		/// @param[in] deadline In how many seconds the texture is needed. Within the same priority class, textures with earlier deadlines are loaded first.
+		/// @return True if queueing was successful.
+		/// @note The callback is called from the thread that updates asynchronous textures, same as where they are uploaded to the GPU.
+		/// @note The callback is called even if queueing wasn't necessary, e.g. when the texture is already loaded.
+		/// @see TextureLoadGroup
+		bool loadAsync(void (*callback)(Texture* texture, bool success, void* userData), void* userData = NULL, LoadPriority priority = LoadPriority::Normal, float deadline = 0.0f);
+		/// @brief Cancels asynchronous loading of the texture.
+		/// @return True if asynchronous loading was queued.
+		/// @note If the texture is already being read or decoded, the loaded data is discarded.
+		bool cancelAsyncLoad();
 		/// @brief Loads the texture's meta data only.
 		/// @return True if successful or already loaded.
 		bool loadMetaData();
@@ -187,10 +287,11 @@ namespace april
 		void unload();
 		/// @brief Waits for the texture to load asynchronously.
 		/// @param[in] timeout How long to wait maximally in seconds.
+		/// @return True if the texture finished loading.
 		/// @note A timeout value of 0.0 means indefinitely.
 		/// @note This should usually not be used externally. load() uses this internally when the texture was already queued to be loaded asynchronously.
 		/// @see loadAsync
-		void waitForAsyncLoad(float timeout = 0.0f);
+		bool waitForAsyncLoad(float timeout = 0.0f);
 
 		/// @brief Clears the entire image and sets all image data to zeroes.
 		/// @return True if successful.
@@ -721,8 +822,21 @@ namespace april
 		bool locked;
 		/// @brief Whether the texture is dirty and needs to be reuploaded to the GPU.
 		bool dirty;
+		/// @brief The changed regions of the raw image data that need to be uploaded to the GPU.
+		harray<grecti> dirtyRects;
 		/// @brief The raw image data.
+		/// @note This is NULL while the data is packed.
 		unsigned char* data;
+		/// @brief Whether the raw image data is kept compressed in RAM while it isn't used.
+		bool dataPacking;
+		/// @brief The compressed raw image data.
+		unsigned char* packedData;
+		/// @brief The byte size of the compressed raw image data.
+		int packedDataSize;
+		/// @brief The RenderSystem frame in which the raw image data was last accessed.
+		int64_t lastDataAccessFrame;
+		/// @brief Incremented whenever the raw image data is accessed or replaced so outdated packing results can be discarded.
+		int dataVersion;
 		/// @brief Mutex used for thread synchronization when using asynchronous loading.
 		hmutex asyncDataMutex;
 		/// @brief The raw image data that was loaded asynchronously and is waiting to be uploaded to the GPU.
@@ -741,6 +855,54 @@ namespace april
 		/// @brief Whether a first upload to the GPU already happened.
 		/// @note Required because of how some RenderSystem implementations work (e.g. OpenGL and OpenGLES).
 		bool firstUpload;
+		/// @brief How many rows of the asynchronously loaded data were already uploaded to the GPU.
+		/// @note Large textures are uploaded in tiles over several frames to stay within the per-frame upload limits.
+		/// @note A value of 0 means that no tiled upload is in progress.
+		int asyncUploadRow;
+		/// @brief Whether the asynchronously loaded data is being uploaded to the GPU on a background thread.
+		/// @note The texture only counts as uploaded after the render thread took over the finished upload.
+		bool asyncUploadBackground;
+		/// @brief Max width and height of the image data when loaded from a file.
+		/// @note A value of 0 or less indicates no limit.
+		int loadMaxDimension;
+		/// @brief Scale factor of the image data when loaded from a file.
+		float loadScale;
+		/// @brief Whether the texture's image data is encoded into a GPU block compression format in the background.
+		bool compressible;
+		/// @brief The block compressed image data.
+		/// @note This is used on the GPU instead of the raw image data, but only as long as the raw image data doesn't change.
+		unsigned char* blockData;
+		/// @brief The byte size of the block compressed image data.
+		int blockDataSize;
+		/// @brief The format of the block compressed image data.
+		Image::BlockFormat blockFormat;
+		/// @brief Whether the texture on the GPU currently uses the block compressed image data.
+		bool blockDataUploaded;
+		/// @brief Incremented whenever the raw image data changes so outdated compression results can be discarded.
+		int compressionVersion;
+		/// @brief The texture's anisotropic filtering level.
+		float anisotropy;
+		/// @brief How many mipmap levels the texture currently has on the GPU, including the base level.
+		int mipmapLevels;
+		/// @brief Whether the mipmaps have to be created again before the texture is used.
+		bool mipmapsOutdated;
+		/// @brief The RenderSystem frame in which the texture was last bound for rendering.
+		int64_t lastUsedFrame;
+		/// @brief Whether the texture was unloaded by the RenderSystem to stay within the texture memory budgets.
+		/// @note Evicted textures are reloaded asynchronously when they are used again.
+		bool evicted;
+		/// @brief Whether the texture on the GPU was changed directly, e.g. by a texture copy, so it doesn't match the CPU-side data anymore.
+		/// @note Such textures aren't evicted and only changed areas of the CPU-side data are uploaded to them.
+		bool deviceDataModified;
+		/// @brief The filename of the low resolution proxy image that is shown while the texture is streamed in.
+		hstr proxyFilename;
+		/// @brief The largest width or height in screen pixels at which the texture is currently displayed.
+		int visibleDimension;
+		/// @brief The low resolution proxy texture.
+		/// @note This texture isn't registered in the RenderSystem and is owned by this texture.
+		Texture* proxyTexture;
+		/// @brief The asynchronously decoded proxy image that is waiting to be uploaded.
+		Image* proxyImageAsync;
 
 		/// @brief Constructor.
 		/// @param[in] fromResource Whether the texture was loaded from a resource file or a normal file.
@@ -754,6 +916,12 @@ namespace april
 		/// @param[in] loadMode The texture load mode.
 		/// @return True if successful.
 		virtual bool _create(chstr filename, Type type, LoadMode loadMode);
+		/// @brief Gets by how much the image data is reduced when loaded from a file.
+		/// @param[in] w Original width of the image data.
+		/// @param[in] h Original height of the image data.
+		/// @return The power-of-two divisor of the image dimensions.
+		/// @see Image::calcDownscaleDivisor
+		int _getLoadDownscaleDivisor(int w, int h) const;
 		/// @brief Creates and sets up all of the texture's internal data.
 		/// @param[in] filename Filename of the source file.
 		/// @param[in] format Pixel format of the image data.
@@ -802,6 +970,16 @@ namespace april
 		/// @brief Decodes loaded image data.
 		/// @param[in] stream The stream object where the loaded data is.
 		void _decodeFromAsyncStream(hstream* stream);
+		/// @brief Reads the whole image file into a stream. Used internally only.
+		/// @param[in] stream The stream where the file data is written.
+		/// @note Plain files are memory mapped where supported, packed resources are read normally.
+		void _readSource(hstream& stream);
+		/// @brief Decodes the image file data the same way for synchronous and asynchronous loading. Used internally only.
+		/// @param[in] stream The stream with the image file data.
+		/// @return The decoded Image or NULL if decoding failed.
+		/// @note If the decoded texture cache is enabled, it is checked before decoding and the result is stored in it afterwards.
+		/// @see april::setTextureCachePath
+		Image* _decodeImage(hstream& stream);
 		/// @brief If necessary, converts to image the a format supported by the RenderSystem.
 		/// @param[in] image The loaded Image.
 		/// @return The final Image. This may be the same as the same image as the parameter image or can be a new image.
@@ -829,20 +1007,85 @@ namespace april
 		/// @brief Checks whether TextureAsync needs to upload this texture to the GPU.
 		/// @return True if TextureAsync needs to upload this texture to the GPU.
 		bool _isAsyncUploadQueued();
+		/// @brief Checks whether asynchronous loading finished and nothing is waiting to be uploaded anymore.
+		/// @return True if asynchronous loading finished and nothing is waiting to be uploaded anymore.
+		/// @note A texture that failed to load counts as finished as well.
+		bool _isAsyncLoadFinished();
+		/// @brief Checks whether the raw image data is available in RAM, either directly or packed.
+		/// @return True if the raw image data is available in RAM.
+		/// @note This expects asyncDataMutex to be locked.
+		bool _hasData() const;
+		/// @brief Replaces the raw image data with data that was packed in the background. Used internally only.
+		/// @param[in] version The data version at the time the packing was queued.
+		/// @param[in] packedData The compressed raw image data. The texture takes over ownership.
+		/// @param[in] packedDataSize The byte size of the compressed raw image data.
+		/// @return True if the packed data was applied.
+		/// @note The packed data is discarded if the raw image data was accessed in the meantime.
+		bool _applyPackedData(int version, unsigned char* packedData, int packedDataSize);
+		/// @brief Decompresses the raw image data in RAM if it's packed. Used internally only.
+		/// @return True if the raw image data is available afterwards.
+		/// @note This expects asyncDataMutex to be locked and has to be called before the raw image data is accessed.
+		bool _unpackData();
+		/// @brief Queues packing of the raw image data if it hasn't been accessed for a while. Used internally only. Called from main thread only.
+		/// @return True if packing of the raw image data was queued.
+		/// @note The data is compressed on a worker thread and only replaced once that is done.
+		bool _tryPackData();
 
 		/// @brief Loads the texture asynchronously. Used internally only.
+		/// @param[in] priority The priority class of the load request.
+		/// @param[in] deadline In how many seconds the texture is needed.
 		/// @return True if queueing was successful.
 		/// @note Using a texture before it is uploaded to the GPU will cause undefined behavior. Always call load() before using it, because this ensures that it's loaded.
-		bool _loadAsync();
+		bool _loadAsync(LoadPriority priority = LoadPriority::Normal, float deadline = 0.0f);
+		/// @brief Cancels asynchronous loading of the texture. Used internally only.
+		/// @return True if asynchronous loading was queued.
+		bool _cancelAsyncLoad();
 		/// @brief Loads the texture's meta data only. Used internally only.
 		/// @return True if successful or already loaded.
 		bool _loadMetaData();
 		/// @brief Uploads the texture data to the GPU. Used internally only.
+		/// @param[in] maxBytes If larger than 0, large textures are uploaded in tiles of up to this many bytes.
 		/// @return True if can be uploaded and successful.
-		bool _tryAsyncFinalUpload();
+		/// @note The texture only counts as uploaded after all tiles were uploaded.
+		bool _tryAsyncFinalUpload(int64_t maxBytes = 0);
 		/// @brief Makes sure that the texture has been uploaded to the GPU. Used internally only.
+		/// @param[in] maxBytes If larger than 0, large textures are uploaded in tiles of up to this many bytes.
 		/// @return True if successful or already loaded.
-		bool _upload(hmutex::ScopeLock& lock);
+		bool _upload(hmutex::ScopeLock& lock, int64_t maxBytes = 0);
+		/// @brief Checks whether the asynchronously loaded data can be uploaded in tiles. Used internally only.
+		/// @param[in] currentData The data that is about to be uploaded.
+		/// @param[in] maxBytes The max number of bytes per tile.
+		/// @return True if the data can be uploaded in tiles.
+		bool _canUploadAsyncTiles(unsigned char* currentData, int64_t maxBytes);
+		/// @brief Uploads the next tile of the asynchronously loaded data to the GPU. Used internally only.
+		/// @param[in] lock A scope lock that has the async load mutex acquired.
+		/// @param[in] maxBytes The max number of bytes to upload. A value of 0 or less uploads all remaining tiles.
+		/// @return True if successful.
+		bool _uploadAsyncTiles(hmutex::ScopeLock& lock, int64_t maxBytes);
+		/// @brief Takes over uploaded image data as the texture's raw image data. Used internally only.
+		/// @param[in] lock A scope lock that has the async data mutex acquired. It's released afterwards.
+		/// @param[in] currentData The image data that was uploaded.
+		void _applyUploadedData(hmutex::ScopeLock& lock, unsigned char* currentData);
+		/// @brief Checks whether the asynchronously loaded data can be uploaded on a background thread. Used internally only.
+		/// @param[in] currentData The data that is about to be uploaded.
+		/// @return True if the data can be uploaded on a background thread.
+		bool _canUploadInBackground(unsigned char* currentData);
+		/// @brief Takes over a finished background upload. Used internally only.
+		/// @param[in] lock A scope lock that has the async load mutex acquired.
+		/// @param[in] wait Whether to block until the background upload is finished.
+		/// @return True if the background upload was taken over.
+		/// @note If the background upload failed, the texture is uploaded normally instead.
+		bool _finishBackgroundUpload(hmutex::ScopeLock& lock, bool wait);
+		/// @brief Starts uploading the asynchronously loaded data to the GPU on a background thread.
+		/// @param[in] data The raw image data.
+		/// @return True if the upload was started.
+		/// @note The data must stay valid until the upload is finished or the device texture is destroyed.
+		virtual bool _deviceUploadInBackground(unsigned char* data);
+		/// @brief Takes over the device texture from a background upload.
+		/// @param[in] wait Whether to block until the background upload is finished.
+		/// @param[out] success Whether the device texture was uploaded successfully.
+		/// @return True if the background upload is finished.
+		virtual bool _deviceTryFinishBackgroundUpload(bool wait, bool* success);
 		/// @brief Waits for the texture to be ready for upload. Used internally only. Called from main thread only.
 		/// @see loadAsync
 		/// @see _upload
@@ -850,6 +1093,29 @@ namespace april
 		/// @brief Uploads the texture data to the GPU. Used internally only. Called from main thread only.
 		/// @return True if successful or already loaded.
 		bool _ensureUploaded();
+		/// @brief Checks whether the texture can be evicted and loaded again later. Used internally only.
+		/// @return True if the texture can be evicted.
+		bool _isEvictable();
+		/// @brief Makes an evicted texture available again without blocking. Used internally only. Called from main thread only.
+		/// @return True if the texture is uploaded and can be used.
+		/// @note If the data isn't available in RAM, it is queued to be loaded asynchronously.
+		bool _tryReload();
+		/// @brief Checks whether the proxy image still has to be loaded asynchronously. Used internally only.
+		/// @return True if the proxy image still has to be loaded.
+		bool _needsAsyncProxy();
+		/// @brief Loads the proxy image. Used internally only. Called from the loader thread only.
+		/// @return True if the full resolution image should be loaded as well.
+		bool _loadAsyncProxy();
+		/// @brief Checks whether the proxy is large enough for how the texture is currently displayed. Used internally only.
+		/// @return True if the full resolution image isn't needed.
+		bool _isProxySufficient() const;
+		/// @brief Uploads the asynchronously loaded proxy image to the GPU. Used internally only. Called from main thread only.
+		/// @return True if the proxy was uploaded.
+		bool _tryAsyncProxyUpload();
+		/// @brief Gets the proxy texture if it should be used instead of this texture. Used internally only. Called from main thread only.
+		/// @return The proxy texture or NULL if this texture should be used.
+		/// @note This keeps the full resolution image loading in the background if it's needed.
+		Texture* _useProxyTexture();
 
 		/// @brief Clears the entire image and sets all image data to zeroes without safety checks. Used internally only.
 		/// @return True if successful.
@@ -1003,10 +1269,62 @@ namespace april
 		/// @param[in] update True if the image data should be reuploaded to the GPU.
 		/// @return True if successful.
 		virtual bool _unlockSystem(Lock& lock, bool update) = 0;
+		/// @brief Finds the block compression format that the texture can be encoded into.
+		/// @param[out] blockFormat The block compression format.
+		/// @return True if the texture can be compressed.
+		bool _findCompressionBlockFormat(Image::BlockFormat& blockFormat) const;
+		/// @brief Queues the raw image data for block compression if possible.
+		/// @return True if compression was queued.
+		bool _queueCompression();
+		/// @brief Discards the block compressed image data and any pending compression.
+		void _discardBlockData();
+		/// @brief Uses finished block compressed image data. Called from main thread only.
+		/// @param[in] version The value of compressionVersion when compression was queued.
+		/// @param[in] blockFormat The format of the block compressed image data.
+		/// @param[in] blockData The block compressed image data. The texture takes over ownership.
+		/// @param[in] blockDataSize The byte size of the block compressed image data.
+		/// @return True if the data was used.
+		bool _applyBlockData(int version, Image::BlockFormat blockFormat, unsigned char* blockData, int blockDataSize);
+		/// @brief Uploads the block compressed image data to the GPU, replacing the current texture data.
+		/// @return True if successful.
+		/// @note Render systems without block compression support don't need to implement this.
+		virtual bool _uploadBlockDataToGpu();
+		/// @brief Checks whether the texture's filter requires mipmaps.
+		/// @return True if the texture's filter requires mipmaps.
+		bool _isMipmapFilter() const;
+		/// @brief Removes the texture from the texture atlas so it's uploaded again on its next use.
+		/// @note Used when the texture's properties change in a way that might make it ineligible for the texture atlas.
+		void _removeFromAtlas();
+		/// @brief Gets the filter that can actually be used for rendering.
+		/// @return The filter that can actually be used for rendering.
+		/// @note Mipmap filters fall back to Filter::Linear if the texture doesn't have mipmaps on the GPU.
+		Filter _getRenderFilter() const;
+		/// @brief Creates the mipmaps again if the texture's filter requires them.
+		/// @param[in] data The raw image data of the base level. Can be NULL if the render system can create mipmaps on the GPU.
+		/// @param[in] format The pixel format of the raw image data.
+		/// @note This should be called by render systems after the base level was uploaded.
+		void _updateMipmaps(unsigned char* data, Image::Format format);
+		/// @brief Creates the mipmaps again from the CPU-side data or from the GPU content if it was changed directly.
+		/// @note This should be called with asyncDataMutex locked.
+		void _updateDeviceMipmaps();
+		/// @brief Creates the mipmaps on the GPU.
+		/// @param[in] data The raw image data of the base level. Can be NULL.
+		/// @param[in] format The pixel format of the raw image data.
+		/// @return True if successful.
+		/// @note Implementations have to set mipmapLevels. Render systems without mipmap support don't need to implement this.
+		virtual bool _deviceCreateMipmaps(unsigned char* data, Image::Format format);
 		/// @brief Attempts to upload changed texture data to the GPU.
 		/// @return True if successful.
 		/// @note No upload will happen if no changes have been made or the texture is currently not loaded.
+		/// @note Only the dirty rectangles are uploaded unless they cover a large part of the texture.
 		bool _tryUploadDataToGpu();
+		/// @brief Marks a region of the raw image data as changed and merges it with nearby dirty rectangles.
+		/// @param[in] x X-coordinate of the rectangle.
+		/// @param[in] y Y-coordinate of the rectangle.
+		/// @param[in] w Width of the rectangle.
+		/// @param[in] h Height of the rectangle.
+		/// @note The region is clipped to the texture. The caller has to lock asyncDataMutex.
+		void _addDirtyRect(int x, int y, int w, int h);
 		/// @brief Uploads local image data directly to the GPU.
 		/// @param[in] x X-coordinate of the rectangle.
 		/// @param[in] y Y-coordinate of the rectangle.
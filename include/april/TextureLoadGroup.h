@@ -0,0 +1,94 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a group of textures that are loaded asynchronously together.
+
+#ifndef APRIL_TEXTURE_LOAD_GROUP_H
+#define APRIL_TEXTURE_LOAD_GROUP_H
+
+#include <hltypes/harray.h>
+
+#include "aprilExport.h"
+#include "Texture.h"
+
+namespace april
+{
+	/// @brief Defines a group of textures that are loaded asynchronously together.
+	/// @note This can be used as a waitable handle for a single texture as well.
+	class aprilExport TextureLoadGroup
+	{
+	public:
+		friend class TextureAsync;
+
+		/// @brief Basic constructor.
+		/// @param[in] callback Function that is called once all textures in the group finished loading.
+		/// @param[in] userData Custom data that is passed to the callback.
+		/// @note The callback is called from the thread that updates asynchronous textures, same as where they are uploaded to the GPU.
+		TextureLoadGroup(void (*callback)(TextureLoadGroup* group, bool success, void* userData) = NULL, void* userData = NULL);
+		/// @brief Destructor.
+		/// @note Destroying the group doesn't cancel loading of its textures.
+		~TextureLoadGroup();
+
+		/// @brief Gets the textures in this group.
+		/// @return The textures in this group.
+		harray<Texture*> getTextures();
+		/// @brief Gets how many textures still have to finish loading.
+		/// @return How many textures still have to finish loading.
+		int getPendingCount();
+		/// @brief Checks whether all textures in the group finished loading.
+		/// @return True if all textures in the group finished loading.
+		bool isCompleted();
+		/// @brief Checks whether all textures in the group were uploaded to the GPU successfully.
+		/// @return True if all textures in the group were uploaded to the GPU successfully.
+		/// @note This is only valid after the group completed.
+		bool isSuccessful();
+
+		/// @brief Adds a texture to the group.
+		/// @param[in] texture The texture to add.
+		/// @note Adding a texture to a completed group makes it pending again and the callback will be called once more.
+		void add(Texture* texture);
+		/// @brief Adds textures to the group.
+		/// @param[in] textures The textures to add.
+		/// @note Adding textures to a completed group makes it pending again and the callback will be called once more.
+		void add(const harray<Texture*>& textures);
+		/// @brief Loads all textures in the group asynchronously.
+		/// @param[in] priority The priority class of the load requests.
+		/// @param[in] deadline In how many seconds the textures are needed.
+		/// @return True if at least one texture was queued.
+		/// @see Texture::loadAsync
+		bool loadAsync(Texture::LoadPriority priority = Texture::LoadPriority::Normal, float deadline = 0.0f);
+		/// @brief Waits for all textures in the group to finish loading.
+		/// @param[in] timeout How long to wait maximally in seconds.
+		/// @return True if all textures finished loading.
+		/// @note A timeout value of 0.0 means indefinitely.
+		/// @note Textures are uploaded to the GPU during RenderSystem updates so this must not be called from the thread that updates asynchronous textures.
+		bool wait(float timeout = 0.0f);
+
+	protected:
+		/// @brief The textures in this group.
+		harray<Texture*> textures;
+		/// @brief The textures that still have to finish loading.
+		harray<Texture*> pendingTextures;
+		/// @brief Function that is called once all textures in the group finished loading.
+		void (*callback)(TextureLoadGroup* group, bool success, void* userData);
+		/// @brief Custom data that is passed to the callback.
+		void* userData;
+		/// @brief Whether all textures in the group finished loading.
+		bool completed;
+		/// @brief Whether all textures in the group were uploaded to the GPU successfully.
+		bool successful;
+		/// @brief Whether the callback still has to be called.
+		bool callbackQueued;
+
+	};
+
+}
+
+#endif
@@ -203,6 +203,41 @@ namespace april
 	/// @param[in] value The max number of async textures uploaded to the GPU per frame.
 	/// @note A value of 0 or less indicates all currently loaded textures.
 	aprilFnExport void setMaxAsyncTextureUploadsPerFrame(int value);
+	/// @brief Gets the max number of bytes of async textures uploaded to the GPU per frame.
+	/// @return The max number of bytes of async textures uploaded to the GPU per frame.
+	aprilFnExport int64_t getAsyncTextureUploadBytesPerFrame();
+	/// @brief Sets the max number of bytes of async textures uploaded to the GPU per frame.
+	/// @param[in] value The max number of bytes of async textures uploaded to the GPU per frame.
+	/// @note A value of 0 or less indicates no limit.
+	/// @note Textures larger than the tile size are uploaded in tiles over several frames.
+	/// @note At least one tile is uploaded every frame so loading always progresses.
+	/// @see setAsyncTextureUploadTileSize
+	aprilFnExport void setAsyncTextureUploadBytesPerFrame(int64_t value);
+	/// @brief Gets the max time in seconds spent on uploading async textures to the GPU per frame.
+	/// @return The max time in seconds spent on uploading async textures to the GPU per frame.
+	aprilFnExport float getAsyncTextureUploadTimePerFrame();
+	/// @brief Sets the max time in seconds spent on uploading async textures to the GPU per frame.
+	/// @param[in] value The max time in seconds spent on uploading async textures to the GPU per frame.
+	/// @note A value of 0 or less indicates no limit.
+	/// @note The time is checked after every uploaded tile so the limit can be exceeded by the time of one tile.
+	/// @see setAsyncTextureUploadTileSize
+	aprilFnExport void setAsyncTextureUploadTimePerFrame(float value);
+	/// @brief Gets the max size in bytes of one tile when async textures are uploaded in tiles.
+	/// @return The max size in bytes of one tile when async textures are uploaded in tiles.
+	aprilFnExport int getAsyncTextureUploadTileSize();
+	/// @brief Sets the max size in bytes of one tile when async textures are uploaded in tiles.
+	/// @param[in] value The max size in bytes of one tile when async textures are uploaded in tiles.
+	/// @note Tiles always cover the whole width of the texture and at least one row.
+	/// @note Tiled uploads are only used when a per-frame byte or time limit is set.
+	aprilFnExport void setAsyncTextureUploadTileSize(int value);
+	/// @brief Checks whether async textures are uploaded to the GPU on a dedicated upload thread where supported.
+	/// @return True if async textures are uploaded to the GPU on a dedicated upload thread where supported.
+	aprilFnExport bool isAsyncTextureUploadThreadEnabled();
+	/// @brief Sets whether async textures are uploaded to the GPU on a dedicated upload thread where supported.
+	/// @param[in] value Whether async textures are uploaded to the GPU on a dedicated upload thread where supported.
+	/// @note This requires an OpenGL render system that can create a shared context, otherwise textures are uploaded on the render thread.
+	/// @note Textures uploaded on the upload thread don't count towards the per-frame upload limits.
+	aprilFnExport void setAsyncTextureUploadThreadEnabled(bool value);
 	/// @brief Gets the max number of async textures concurrently loaded in RAM and waiting for upload.
 	/// @return The max number of async textures concurrently loaded in RAM and waiting for upload.
 	aprilFnExport int getMaxWaitingAsyncTextures();
@@ -210,6 +245,117 @@ namespace april
 	/// @param[in] value The max number of async textures concurrently loaded in RAM and waiting for upload.
 	/// @note A value of 0 or less indicates no limit.
 	aprilFnExport void setMaxWaitingAsyncTextures(int value);
+	/// @brief Gets the number of threads that read async texture files.
+	/// @return The number of threads that read async texture files.
+	aprilFnExport int getAsyncTextureReaderThreads();
+	/// @brief Sets the number of threads that read async texture files.
+	/// @param[in] value The number of threads that read async texture files.
+	/// @note Several reads in flight keep fast storage busy. A value of 1 reads files strictly one after another. Values less than 1 are treated as 1.
+	aprilFnExport void setAsyncTextureReaderThreads(int value);
+	/// @brief Gets the number of threads that decode async textures.
+	/// @return The number of threads that decode async textures.
+	aprilFnExport int getAsyncTextureDecoderThreads();
+	/// @brief Sets the number of threads that decode async textures.
+	/// @param[in] value The number of threads that decode async textures.
+	/// @note A value of 0 or less uses one thread per CPU core. The threads are kept alive and wait for work instead of being recreated for every texture.
+	aprilFnExport void setAsyncTextureDecoderThreads(int value);
+	/// @brief Gets the max width and height of textures loaded from files.
+	/// @return The max width and height of textures loaded from files.
+	aprilFnExport int getMaxTextureLoadDimension();
+	/// @brief Sets the max width and height of textures loaded from files.
+	/// @param[in] value The max width and height of textures loaded from files.
+	/// @note A value of 0 or less indicates no limit.
+	/// @note Larger images are downscaled by a power of two while decoding. This only affects textures created afterwards.
+	aprilFnExport void setMaxTextureLoadDimension(int value);
+	/// @brief Gets the scale factor of textures loaded from files.
+	/// @return The scale factor of textures loaded from files.
+	aprilFnExport float getTextureLoadScale();
+	/// @brief Sets the scale factor of textures loaded from files.
+	/// @param[in] value The scale factor of textures loaded from files.
+	/// @note Images are downscaled by a power of two while decoding so the scale is rounded to the nearest reduction that isn't smaller than requested. This only affects textures created afterwards.
+	aprilFnExport void setTextureLoadScale(float value);
+	/// @brief Gets the directory where block compressed texture data is cached.
+	/// @return The directory where block compressed texture data is cached.
+	aprilFnExport hstr getTextureCompressionCachePath();
+	/// @brief Sets the directory where block compressed texture data is cached.
+	/// @param[in] value The directory where block compressed texture data is cached.
+	/// @note An empty string disables the cache so compressible textures are encoded every time they are loaded.
+	/// @see Texture::setCompressible
+	aprilFnExport void setTextureCompressionCachePath(chstr value);
+	/// @brief Gets the directory where decoded texture data is cached.
+	/// @return The directory where decoded texture data is cached.
+	aprilFnExport hstr getTextureCachePath();
+	/// @brief Sets the directory where decoded texture data is cached.
+	/// @param[in] value The directory where decoded texture data is cached.
+	/// @note Textures loaded from files are stored after decoding, downscaling and format conversion so later loads of the same image data can skip all of it.
+	/// @note Entries are looked up by the content of the image file and the load settings so changed files are never loaded from outdated cache entries.
+	/// @note An empty string disables the cache.
+	aprilFnExport void setTextureCachePath(chstr value);
+	/// @brief Gets the max size of the decoded texture cache in bytes.
+	/// @return The max size of the decoded texture cache in bytes.
+	aprilFnExport int64_t getTextureCacheMaxSize();
+	/// @brief Sets the max size of the decoded texture cache in bytes.
+	/// @param[in] value The max size of the decoded texture cache in bytes.
+	/// @note When the size is exceeded, the least recently used entries are removed. A value of 0 or less means no limit.
+	/// @see setTextureCachePath
+	aprilFnExport void setTextureCacheMaxSize(int64_t value);
+	/// @brief Gets the filename suffix of low resolution proxy images for streamed textures.
+	/// @return The filename suffix of low resolution proxy images for streamed textures.
+	aprilFnExport hstr getTextureProxySuffix();
+	/// @brief Sets the filename suffix of low resolution proxy images for streamed textures.
+	/// @param[in] value The filename suffix of low resolution proxy images for streamed textures.
+	/// @note e.g. with the suffix "@low", "images/bg.png" uses "images/bg@low" with any of the supported texture extensions as proxy if it exists.
+	/// @note Asynchronously loaded textures with a proxy show the proxy while the full resolution image is being loaded. This only affects textures created afterwards.
+	/// @note An empty string disables proxies.
+	/// @see Texture::setVisibleDimension
+	aprilFnExport void setTextureProxySuffix(chstr value);
+	/// @brief Gets the VRAM budget for textures in bytes.
+	/// @return The VRAM budget for textures in bytes.
+	aprilFnExport int64_t getTextureVRamBudget();
+	/// @brief Sets the VRAM budget for textures in bytes.
+	/// @param[in] value The VRAM budget for textures in bytes.
+	/// @note When the budget is exceeded, the least recently used textures that can be reloaded are unloaded from the GPU after a frame was presented.
+	/// @note Evicted textures are reloaded asynchronously when they are used again. A value of 0 or less means no limit.
+	/// @see RenderSystem::setResidencyPlaceholderTexture
+	aprilFnExport void setTextureVRamBudget(int64_t value);
+	/// @brief Gets the RAM budget for texture data that waits to be uploaded in bytes.
+	/// @return The RAM budget for texture data that waits to be uploaded in bytes.
+	aprilFnExport int64_t getTextureRamBudget();
+	/// @brief Sets the RAM budget for texture data that waits to be uploaded in bytes.
+	/// @param[in] value The RAM budget for texture data that waits to be uploaded in bytes.
+	/// @note When the budget is exceeded, the least recently used asynchronously loaded data is discarded and loaded again when needed. A value of 0 or less means no limit.
+	aprilFnExport void setTextureRamBudget(int64_t value);
+	/// @brief Gets the max width and height of textures that are packed into shared atlas pages.
+	/// @return The max width and height of textures that are packed into shared atlas pages.
+	aprilFnExport int getTextureAtlasMaxDimension();
+	/// @brief Sets the max width and height of textures that are packed into shared atlas pages.
+	/// @param[in] value The max width and height of textures that are packed into shared atlas pages.
+	/// @note Packed textures are rendered from a shared page so consecutive render calls with different small textures can be batched.
+	/// @note Only Type::Immutable textures with AddressMode::Clamp and without mipmap filters or compression are packed. A value of 0 or less disables packing.
+	/// @see RenderSystem::getTextureAtlasPageCount
+	aprilFnExport void setTextureAtlasMaxDimension(int value);
+	/// @brief Gets the width and height of shared texture atlas pages.
+	/// @return The width and height of shared texture atlas pages.
+	aprilFnExport int getTextureAtlasPageSize();
+	/// @brief Sets the width and height of shared texture atlas pages.
+	/// @param[in] value The width and height of shared texture atlas pages.
+	/// @note This only affects pages created afterwards.
+	aprilFnExport void setTextureAtlasPageSize(int value);
+	/// @brief Gets the padding around textures in shared texture atlas pages.
+	/// @return The padding around textures in shared texture atlas pages.
+	aprilFnExport int getTextureAtlasPadding();
+	/// @brief Sets the padding around textures in shared texture atlas pages.
+	/// @param[in] value The padding around textures in shared texture atlas pages.
+	/// @note The padding is filled with the texture's edge pixels so filtering doesn't bleed in neighboring textures.
+	/// @note This only affects pages created afterwards.
+	aprilFnExport void setTextureAtlasPadding(int value);
+	/// @brief Gets after how many frames unused render targets in the render target pool are destroyed.
+	/// @return After how many frames unused render targets in the render target pool are destroyed.
+	aprilFnExport int getRenderTargetPoolMaxIdleFrames();
+	/// @brief Sets after how many frames unused render targets in the render target pool are destroyed.
+	/// @param[in] value After how many frames unused render targets in the render target pool are destroyed.
+	/// @note A value of 0 keeps released render targets only until the end of the next frame.
+	aprilFnExport void setRenderTargetPoolMaxIdleFrames(int value);
 	/// @brief Gets the exit code that should be used when exiting the application.
 	/// @return The exit code that should be used when exiting the application.
 	aprilFnExport int getExitCode();
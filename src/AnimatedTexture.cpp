@@ -0,0 +1,465 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <condition_variable>
+#include <mutex>
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include "AnimatedTexture.h"
+#include "april.h"
+#include "Color.h"
+#include "Image.h"
+#include "RenderSystem.h"
+#include "Texture.h"
+
+#define MIN_RING_SIZE 2
+
+namespace april
+{
+	AnimatedTexture::FrameSource::FrameSource()
+	{
+	}
+
+	AnimatedTexture::FrameSource::~FrameSource()
+	{
+	}
+
+	float AnimatedTexture::FrameSource::getFrameRate() const
+	{
+		return 0.0f;
+	}
+
+	AnimatedTexture::FileSequence::FileSequence(const harray<hstr>& filenames, bool fromResource) : FrameSource()
+	{
+		this->filenames = filenames;
+		this->fromResource = fromResource;
+	}
+
+	int AnimatedTexture::FileSequence::getFrameCount() const
+	{
+		return this->filenames.size();
+	}
+
+	Image* AnimatedTexture::FileSequence::readMetaData()
+	{
+		// all frames are expected to have the same size and format as the first one
+		return (this->fromResource ? Image::readMetaDataFromResource(this->filenames.first()) : Image::readMetaDataFromFile(this->filenames.first()));
+	}
+
+	Image* AnimatedTexture::FileSequence::decodeFrame(int index, Image::Format format)
+	{
+		hstr filename = this->filenames[index];
+		return (this->fromResource ? Image::createFromResource(filename, format) : Image::createFromFile(filename, format));
+	}
+
+	harray<AnimatedTexture*> AnimatedTexture::animatedTextures;
+	std::mutex AnimatedTexture::animatedTexturesMutex;
+	std::condition_variable AnimatedTexture::decodeCondition;
+	std::condition_variable AnimatedTexture::decodedCondition;
+	hmap<hstr, AnimatedTexture::FrameSource* (*)(chstr, bool)> AnimatedTexture::customFrameSources;
+	hthread AnimatedTexture::decoderThread(&AnimatedTexture::_decode, "APRIL animated texture decoder");
+	bool AnimatedTexture::decoderRunning = false;
+
+	AnimatedTexture::AnimatedTexture(bool fromResource)
+	{
+		this->fromResource = fromResource;
+		this->frameSource = NULL;
+		this->frameCount = 0;
+		this->frameRate = 0.0f;
+		this->looping = true;
+		this->playing = false;
+		this->width = 0;
+		this->height = 0;
+		this->format = Image::Format::Invalid;
+		this->droppedFrameCount = 0;
+		this->lateFrameCount = 0;
+		this->frameTime = 0.0f;
+		this->targetSequence = 0;
+		this->displayedSequence = -1;
+		this->lateSequence = -1;
+		this->textureIndex = 0;
+		this->decodeAheadCount = MIN_RING_SIZE;
+		this->decodeSequence = 0;
+		this->decodeGeneration = 0;
+		this->decoding = false;
+	}
+
+	AnimatedTexture::~AnimatedTexture()
+	{
+		this->_destroy();
+	}
+
+	int AnimatedTexture::getFrameCount() const
+	{
+		return this->frameCount;
+	}
+
+	int AnimatedTexture::getCurrentFrame() const
+	{
+		return (this->displayedSequence >= 0 ? this->displayedSequence % this->frameCount : -1);
+	}
+
+	Texture* AnimatedTexture::getTexture() const
+	{
+		return (this->textures.size() > 0 ? this->textures[this->textureIndex] : NULL);
+	}
+
+	bool AnimatedTexture::_create(const harray<hstr>& filenames, float frameRate, bool looping, int ringSize)
+	{
+		if (filenames.size() == 0)
+		{
+			hlog::error(logTag, "Cannot create animated texture without frames!");
+			return false;
+		}
+		if (filenames.size() == 1)
+		{
+			hstr extension = filenames.first().lowered();
+			foreach_m (FrameSource* (*)(chstr, bool), it, AnimatedTexture::customFrameSources)
+			{
+				if (extension.endsWith(it->first.lowered()))
+				{
+					this->frameSource = (*it->second)(filenames.first(), this->fromResource);
+					if (this->frameSource == NULL)
+					{
+						hlog::error(logTag, "Failed to load animated texture: " + filenames.first());
+						return false;
+					}
+					break;
+				}
+			}
+		}
+		if (this->frameSource == NULL)
+		{
+			this->frameSource = new FileSequence(filenames, this->fromResource);
+		}
+		Image* image = this->frameSource->readMetaData();
+		if (image == NULL || this->frameSource->getFrameCount() == 0)
+		{
+			hlog::error(logTag, "Failed to load animated texture: " + filenames.first());
+			if (image != NULL)
+			{
+				delete image;
+			}
+			delete this->frameSource;
+			this->frameSource = NULL;
+			return false;
+		}
+		this->filenames = filenames;
+		this->frameCount = this->frameSource->getFrameCount();
+		this->frameRate = (frameRate > 0.0f ? frameRate : this->frameSource->getFrameRate());
+		this->looping = looping;
+		this->width = image->w;
+		this->height = image->h;
+		this->format = april::rendersys->getNativeTextureFormat(image->format);
+		delete image;
+		ringSize = hmax(ringSize, MIN_RING_SIZE);
+		Texture* texture = NULL;
+		for_iter (i, 0, ringSize)
+		{
+			texture = april::rendersys->createTexture(this->width, this->height, Color::Clear, this->format, Texture::Type::Managed);
+			if (texture == NULL)
+			{
+				this->_destroy();
+				return false;
+			}
+			this->textures += texture;
+			this->textureSequences += -1;
+		}
+		this->decodeAheadCount = ringSize;
+		std::unique_lock<std::mutex> lock(AnimatedTexture::animatedTexturesMutex);
+		AnimatedTexture::animatedTextures += this;
+		if (!AnimatedTexture::decoderRunning)
+		{
+			AnimatedTexture::decoderThread.join(); // the previous decoder thread could still be finishing
+			AnimatedTexture::decoderRunning = true;
+			AnimatedTexture::decoderThread.start();
+		}
+		lock.unlock();
+		AnimatedTexture::decodeCondition.notify_one();
+		return true;
+	}
+
+	void AnimatedTexture::_destroy()
+	{
+		std::unique_lock<std::mutex> lock(AnimatedTexture::animatedTexturesMutex);
+		AnimatedTexture::animatedTextures -= this;
+		// after this the decoder thread can't access this object anymore
+		while (this->decoding)
+		{
+			AnimatedTexture::decodedCondition.wait(lock);
+		}
+		lock.unlock();
+		AnimatedTexture::decodeCondition.notify_one(); // the decoder thread exits when no animated textures are left
+		hmutex::ScopeLock lockDecode(&this->decodeMutex);
+		this->_clearDecodedImages();
+		lockDecode.release();
+		foreach (Texture*, it, this->textures)
+		{
+			april::rendersys->destroyTexture(*it);
+		}
+		this->textures.clear();
+		this->textureSequences.clear();
+		this->textureIndex = 0;
+		if (this->frameSource != NULL)
+		{
+			delete this->frameSource;
+			this->frameSource = NULL;
+		}
+	}
+
+	void AnimatedTexture::_clearDecodedImages()
+	{
+		foreach (Image*, it, this->decodedImages)
+		{
+			delete (*it);
+		}
+		this->decodedImages.clear();
+		this->decodedSequences.clear();
+	}
+
+	void AnimatedTexture::play()
+	{
+		this->playing = true;
+	}
+
+	void AnimatedTexture::pause()
+	{
+		this->playing = false;
+	}
+
+	void AnimatedTexture::stop()
+	{
+		hmutex::ScopeLock lock(&this->decodeMutex);
+		this->playing = false;
+		this->frameTime = 0.0f;
+		this->targetSequence = 0;
+		this->displayedSequence = -1;
+		this->lateSequence = -1;
+		this->decodeSequence = 0;
+		++this->decodeGeneration; // frames currently being decoded are discarded
+		this->_clearDecodedImages();
+		lock.release();
+		AnimatedTexture::_notifyDecoder();
+		for_iter (i, 0, this->textureSequences.size())
+		{
+			this->textureSequences[i] = -1;
+		}
+	}
+
+	void AnimatedTexture::resetStatistics()
+	{
+		this->droppedFrameCount = 0;
+		this->lateFrameCount = 0;
+	}
+
+	void AnimatedTexture::update(float timeDelta)
+	{
+		if (this->textures.size() == 0)
+		{
+			return;
+		}
+		int frameCount = this->frameCount;
+		hmutex::ScopeLock lock(&this->decodeMutex);
+		if (this->playing && this->frameRate > 0.0f)
+		{
+			float frameDuration = 1.0f / this->frameRate;
+			this->frameTime += timeDelta;
+			while (this->frameTime >= frameDuration)
+			{
+				this->frameTime -= frameDuration;
+				++this->targetSequence;
+			}
+			if (!this->looping && this->targetSequence >= frameCount - 1)
+			{
+				this->targetSequence = frameCount - 1;
+				this->frameTime = 0.0f;
+			}
+		}
+		// decoded frames that the playback clock already passed are skipped if a newer frame is available
+		while (this->decodedSequences.size() >= 2 && this->decodedSequences[1] <= this->targetSequence)
+		{
+			delete this->decodedImages.removeFirst();
+			this->decodedSequences.removeFirst();
+		}
+		lock.release();
+		this->_uploadDecodedFrames();
+		// only wakes up the decoder thread when there is work for it, so paused animations with a full ring don't cause wakeups
+		if (this->_canDecodeNextFrame())
+		{
+			AnimatedTexture::_notifyDecoder();
+		}
+		// the newest uploaded frame that isn't ahead of the playback clock is displayed
+		int index = -1;
+		int sequence = this->displayedSequence;
+		for_iter (i, 0, this->textureSequences.size())
+		{
+			if (this->textureSequences[i] > sequence && this->textureSequences[i] <= this->targetSequence)
+			{
+				sequence = this->textureSequences[i];
+				index = i;
+			}
+		}
+		if (index >= 0)
+		{
+			this->droppedFrameCount += sequence - this->displayedSequence - 1;
+			this->displayedSequence = sequence;
+			this->textureIndex = index;
+		}
+		if (this->playing && this->displayedSequence < this->targetSequence && this->lateSequence != this->targetSequence)
+		{
+			++this->lateFrameCount;
+			this->lateSequence = this->targetSequence;
+		}
+		if (this->playing && !this->looping && this->displayedSequence >= frameCount - 1)
+		{
+			this->playing = false;
+		}
+	}
+
+	void AnimatedTexture::_uploadDecodedFrames()
+	{
+		hmutex::ScopeLock lock;
+		Image* image = NULL;
+		int sequence = 0;
+		for_iter (i, 0, this->textures.size())
+		{
+			// the displayed frame and frames ahead of it must not be overwritten
+			if (this->textureSequences[i] >= 0 && this->textureSequences[i] >= this->displayedSequence)
+			{
+				continue;
+			}
+			lock.acquire(&this->decodeMutex);
+			if (this->decodedImages.size() == 0)
+			{
+				break;
+			}
+			image = this->decodedImages.removeFirst();
+			sequence = this->decodedSequences.removeFirst();
+			lock.release();
+			if (this->textures[i]->write(0, 0, this->width, this->height, 0, 0, image))
+			{
+				this->textureSequences[i] = sequence;
+				// upload right away instead of on first use so the frame is ready when the playback clock gets to it
+				if (april::rendersys->canUseLowLevelCalls())
+				{
+					this->textures[i]->_ensureUploaded();
+				}
+			}
+			delete image;
+		}
+	}
+
+	bool AnimatedTexture::_canDecodeNextFrame()
+	{
+		hmutex::ScopeLock lock(&this->decodeMutex);
+		int sequence = hmax(this->decodeSequence, this->targetSequence);
+		return (this->decodedImages.size() < this->decodeAheadCount && (this->looping || sequence < this->frameCount));
+	}
+
+	bool AnimatedTexture::_decodeNextFrame()
+	{
+		hmutex::ScopeLock lock(&this->decodeMutex);
+		int frameCount = this->frameCount;
+		// frames that the playback clock already passed don't need to be decoded anymore
+		if (this->decodeSequence < this->targetSequence)
+		{
+			this->decodeSequence = this->targetSequence;
+		}
+		if (this->decodedImages.size() >= this->decodeAheadCount || (!this->looping && this->decodeSequence >= frameCount))
+		{
+			return false;
+		}
+		int sequence = this->decodeSequence;
+		++this->decodeSequence;
+		int generation = this->decodeGeneration;
+		int index = sequence % frameCount;
+		lock.release();
+		Image* image = this->frameSource->decodeFrame(index, this->format);
+		if (image == NULL)
+		{
+			hlog::errorf(logTag, "Failed to load animated texture frame %d: %s", index, this->filenames.first().cStr());
+			return true;
+		}
+		if (image->w != this->width || image->h != this->height)
+		{
+			hlog::errorf(logTag, "Animated texture frame %d of '%s' is %dx%d, but %dx%d is required!", index, this->filenames.first().cStr(), image->w, image->h, this->width, this->height);
+			delete image;
+			return true;
+		}
+		lock.acquire(&this->decodeMutex);
+		if (generation != this->decodeGeneration) // playback was reset in the meantime
+		{
+			delete image;
+			return true;
+		}
+		this->decodedImages += image;
+		this->decodedSequences += sequence;
+		return true;
+	}
+
+	void AnimatedTexture::registerCustomFrameSource(chstr extension, FrameSource* (*createFunction)(chstr filename, bool fromResource))
+	{
+		AnimatedTexture::customFrameSources[extension] = createFunction;
+	}
+
+	void AnimatedTexture::_notifyDecoder()
+	{
+		// locking makes sure the decoder thread is either already waiting or will see the change before it waits
+		std::unique_lock<std::mutex> lock(AnimatedTexture::animatedTexturesMutex);
+		lock.unlock();
+		AnimatedTexture::decodeCondition.notify_one();
+	}
+
+	void AnimatedTexture::_decode(hthread* thread)
+	{
+		AnimatedTexture* animatedTexture = NULL;
+		int nextIndex = 0;
+		int size = 0;
+		std::unique_lock<std::mutex> lock(AnimatedTexture::animatedTexturesMutex);
+		while (true)
+		{
+			size = AnimatedTexture::animatedTextures.size();
+			if (size == 0)
+			{
+				AnimatedTexture::decoderRunning = false;
+				break;
+			}
+			// round robin so one animated texture can't starve the others
+			animatedTexture = NULL;
+			for_iter (i, 0, size)
+			{
+				if (AnimatedTexture::animatedTextures[(nextIndex + i) % size]->_canDecodeNextFrame())
+				{
+					animatedTexture = AnimatedTexture::animatedTextures[(nextIndex + i) % size];
+					nextIndex = (nextIndex + i + 1) % size;
+					break;
+				}
+			}
+			if (animatedTexture == NULL)
+			{
+				AnimatedTexture::decodeCondition.wait(lock);
+				continue;
+			}
+			// the list isn't locked while decoding, the flag keeps the animated texture from being destroyed instead
+			animatedTexture->decoding = true;
+			lock.unlock();
+			animatedTexture->_decodeNextFrame();
+			lock.lock();
+			animatedTexture->decoding = false;
+			AnimatedTexture::decodedCondition.notify_all();
+		}
+	}
+
+}
@@ -20,6 +20,7 @@
 #include <hltypes/hstring.h>
 #include <hltypes/hthread.h>
 
+#include "AnimatedTexture.h"
 #include "april.h"
 #include "aprilUtil.h"
 #include "AsyncCommands.h"
@@ -31,6 +32,9 @@
 #include "Platform.h"
 #include "Texture.h"
 #include "TextureAsync.h"
+#include "TextureAtlas.h"
+#include "TextureCache.h"
+#include "TextureManifest.h"
 #include "VertexShader.h"
 #include "Window.h"
 
@@ -45,6 +49,28 @@ namespace april
 	// optimizations, but they are not thread-safe
 	static PlainVertex pv[5];
 	static TexturedVertex tv[5];
+	static harray<TexturedVertex> atlasTv;
+	static harray<ColoredTexturedVertex> atlasCtv;
+	static harray<TexturedVertex> deviceAtlasTv;
+	static harray<ColoredTexturedVertex> deviceAtlasCtv;
+
+	template <typename T>
+	static T* _remapAtlasVertices(const T* vertices, int count, cgrectf uvRect, harray<T>& result)
+	{
+		result.clear();
+		result.add(vertices, count);
+		for_iter (i, 0, count)
+		{
+			result[i].u = uvRect.x + result[i].u * uvRect.w;
+			result[i].v = uvRect.y + result[i].v * uvRect.h;
+		}
+		return (T*)result;
+	}
+
+	static grectf _remapAtlasRect(cgrectf src, cgrectf uvRect)
+	{
+		return grectf(uvRect.x + src.x * uvRect.w, uvRect.y + src.y * uvRect.h, src.w * uvRect.w, src.h * uvRect.h);
+	}
 	
 	RenderSystem* rendersys = NULL;
 
@@ -86,16 +112,20 @@ namespace april
 		this->intermediateRenderTexture = true;
 #endif
 		this->debugInfo = false;
+		this->paletteTextures = false;
 	}
 
 	RenderSystem::Caps::Caps() :
 		maxTextureSize(0),
+		maxAnisotropy(1.0f),
 		npotTexturesLimited(false),
 		npotTextures(false),
 		externalTextures(false),
 		textureFormats(Image::Format::getValues()),
 		renderTarget(false)
 	{
+		// palette textures have to be explicitly supported by the render system
+		this->textureFormats /= Image::Format::Palette;
 	}
 
 	hstr RenderSystem::Options::toString()
@@ -121,6 +151,10 @@ namespace april
 		{
 			options += "Debug Info";
 		}
+		if (this->paletteTextures)
+		{
+			options += "Palette Textures";
+		}
 		if (options.size() == 0)
 		{
 			options += "None";
@@ -151,6 +185,18 @@ namespace april
 		this->statLastFrameTriangleCount = 0;
 		this->statCurrentFrameLineCount = 0;
 		this->statLastFrameLineCount = 0;
+		this->statCurrentFrameTextureUploadBytes = 0LL;
+		this->statLastFrameTextureUploadBytes = 0LL;
+		this->statTextureResidencyHits = 0LL;
+		this->statTextureEvictions = 0LL;
+		this->statTextureReloads = 0LL;
+		this->statTextureProxyUses = 0LL;
+		this->statRenderTargetPoolHits = 0LL;
+		this->statRenderTargetPoolMisses = 0LL;
+		this->renderTargetPoolFrame = 0LL;
+		this->residencyPlaceholderTexture = NULL;
+		this->residencyFrame = 0LL;
+		this->deviceAtlasUsed = false;
 		this->_queuedFrameDuplicates = -1;
 		this->_renderTargetDuplicatesCount = 0;
 		this->_currentIntermediateRenderTexture = NULL;
@@ -227,6 +273,8 @@ namespace april
 		this->statLastFrameTriangleCount = 0;
 		this->statCurrentFrameLineCount = 0;
 		this->statLastFrameLineCount = 0;
+		this->statCurrentFrameTextureUploadBytes = 0LL;
+		this->statLastFrameTextureUploadBytes = 0LL;
 		this->_renderTargetDuplicatesCount = 0;
 		// create the actual device
 		this->_deviceInit();
@@ -259,11 +307,22 @@ namespace april
 			this->renderHelper = NULL;
 		}
 		// deleting all textures safely
+		std::unique_lock<std::mutex> lockSharedTextures(this->sharedTexturesMutex);
+		this->sharedTextures.clear();
+		this->sharedTextureReferences.clear();
+		lockSharedTextures.unlock();
+		hmutex::ScopeLock lockRenderTargetPool(&this->renderTargetPoolMutex);
+		this->pooledRenderTargets.clear();
+		this->transientRenderTargets.clear();
+		this->freeRenderTargets.clear();
+		this->freeRenderTargetFrames.clear();
+		lockRenderTargetPool.release();
 		hmutex::ScopeLock lockTextures(&this->texturesMutex);
 		harray<Texture*> textures = this->textures;
 		this->textures.clear();
 		this->_currentIntermediateRenderTexture = NULL;
 		this->_lastIntermediateRenderTexture = NULL;
+		this->residencyPlaceholderTexture = NULL;
 		textures += this->_intermediateRenderTextures;
 		this->_intermediateRenderTextures.clear();
 		lockTextures.release();
@@ -274,6 +333,10 @@ namespace april
 			(*it)->_ensureAsyncCompleted(); // waiting for all async stuff to finish
 			delete (*it);
 		}
+		TextureAsync::destroy(); // loader threads are started again on demand
+		TextureAtlas::destroy();
+		TextureCache::destroy(); // saves the index so the access order is kept for the next run
+		this->deviceAtlasUsed = false;
 		// misc
 		this->state->reset();
 		this->deviceState->reset();
@@ -297,6 +360,8 @@ namespace april
 		this->statLastFrameTriangleCount = 0;
 		this->statCurrentFrameLineCount = 0;
 		this->statLastFrameLineCount = 0;
+		this->statCurrentFrameTextureUploadBytes = 0LL;
+		this->statLastFrameTextureUploadBytes = 0LL;
 		this->_renderTargetDuplicatesCount = 0;
 		this->_deviceDestroy();
 		this->_deviceInit();
@@ -339,6 +404,8 @@ namespace april
 		this->statLastFrameTriangleCount = 0;
 		this->statCurrentFrameLineCount = 0;
 		this->statLastFrameLineCount = 0;
+		this->statCurrentFrameTextureUploadBytes = 0LL;
+		this->statLastFrameTextureUploadBytes = 0LL;
 	}
 
 	void RenderSystem::suspend()
@@ -401,6 +468,16 @@ namespace april
 		return hmax(this->asyncCommandQueues.size() - 1, 0);
 	}
 
+	int RenderSystem::getTextureAtlasPageCount()
+	{
+		return TextureAtlas::getPageCount();
+	}
+
+	float RenderSystem::getTextureAtlasOccupancy()
+	{
+		return TextureAtlas::getOccupancy();
+	}
+
 	harray<Texture*> RenderSystem::getTextures()
 	{
 		hmutex::ScopeLock lock(&this->texturesMutex);
@@ -429,6 +506,7 @@ namespace april
 		{
 			result += (int64_t)(*it)->getCurrentVRamSize();
 		}
+		result += TextureAtlas::getVRamSize();
 		return result;
 	}
 
@@ -454,6 +532,31 @@ namespace april
 		return result;
 	}
 
+	int64_t RenderSystem::getStatTextureCacheHits() const
+	{
+		return TextureCache::getHits();
+	}
+
+	int64_t RenderSystem::getStatTextureCacheMisses() const
+	{
+		return TextureCache::getMisses();
+	}
+
+	int64_t RenderSystem::getStatTextureCacheWrites() const
+	{
+		return TextureCache::getWrites();
+	}
+
+	int64_t RenderSystem::getStatTextureCacheEvictions() const
+	{
+		return TextureCache::getEvictions();
+	}
+
+	int64_t RenderSystem::getStatTextureCacheSize() const
+	{
+		return TextureCache::getSize();
+	}
+
 	bool RenderSystem::hasAsyncTexturesQueued() const
 	{
 		return TextureAsync::isRunning();
@@ -601,6 +704,11 @@ namespace april
 				(*it)->execute();
 			}
 			delete queue;
+			// only fresh frames count, repeated frames keep using the same pages
+			if (TextureAtlas::update()) // destroyed atlas pages must not stay bound
+			{
+				this->deviceState->texture = NULL;
+			}
 		}
 		else
 		{
@@ -636,6 +744,11 @@ namespace april
 		return this->_createTextureFromSource(true, filename, type, loadMode, format);
 	}
 
+	Texture* RenderSystem::createTextureFromResource(chstr filename, int maxDimension, float scale, Texture::Type type, Texture::LoadMode loadMode)
+	{
+		return this->_createTextureFromSource(true, filename, type, loadMode, Image::Format::Invalid, hmax(maxDimension, 0), hmax(scale, 0.0f));
+	}
+
 	Texture* RenderSystem::createTextureFromFile(chstr filename, Texture::Type type, Texture::LoadMode loadMode)
 	{
 		return this->_createTextureFromSource(false, filename, type, loadMode);
@@ -646,13 +759,19 @@ namespace april
 		return this->_createTextureFromSource(false, filename, type, loadMode, format);
 	}
 
-	Texture* RenderSystem::_createTextureFromSource(bool fromResource, chstr filename, Texture::Type type, Texture::LoadMode loadMode, Image::Format format)
+	Texture* RenderSystem::createTextureFromFile(chstr filename, int maxDimension, float scale, Texture::Type type, Texture::LoadMode loadMode)
+	{
+		return this->_createTextureFromSource(false, filename, type, loadMode, Image::Format::Invalid, hmax(maxDimension, 0), hmax(scale, 0.0f));
+	}
+
+	Texture* RenderSystem::_createTextureFromSource(bool fromResource, chstr filename, Texture::Type type, Texture::LoadMode loadMode, Image::Format format, int maxDimension, float scale)
 	{
 		if (!this->caps.externalTextures && type == Texture::Type::External)
 		{
 			type = Texture::Type::Managed;
 		}
-		if (format != Image::Format::Invalid && !this->getCaps().textureFormats.has(format))
+		// unsupported palette data is expanded through a lookup table when decoded
+		if (format != Image::Format::Invalid && format != Image::Format::Palette && !this->getCaps().textureFormats.has(format))
 		{
 			hlog::errorf(logTag, "Cannot create texture '%s', the texture format '%s' is not supported!", filename.cStr(), format.getName().cStr());
 			return NULL;
@@ -663,6 +782,20 @@ namespace april
 			return NULL;
 		}
 		Texture* texture = this->_deviceCreateTexture(fromResource);
+		if (maxDimension >= 0)
+		{
+			texture->loadMaxDimension = maxDimension;
+		}
+		if (scale >= 0.0f)
+		{
+			texture->loadScale = scale;
+		}
+		hstr proxySuffix = april::getTextureProxySuffix();
+		if (proxySuffix != "")
+		{
+			hstr proxyName = hfile::withoutExtension(name) + proxySuffix;
+			texture->proxyFilename = (fromResource ? this->findTextureResource(proxyName, true) : this->findTextureFile(proxyName, true));
+		}
 		bool result = (format == Image::Format::Invalid ? texture->_create(name, type, loadMode) : texture->_create(name, format, type, loadMode));
 		if (result)
 		{
@@ -765,7 +898,13 @@ namespace april
 		{
 			this->renderHelper->flush();
 		}
-		hmutex::ScopeLock lock(&this->texturesMutex);
+		std::unique_lock<std::mutex> lockSharedTextures(this->sharedTexturesMutex);
+		this->_removeSharedTexture(texture);
+		lockSharedTextures.unlock();
+		hmutex::ScopeLock lock(&this->renderTargetPoolMutex);
+		this->_removePooledRenderTarget(texture);
+		lock.release();
+		lock.acquire(&this->texturesMutex);
 		this->textures -= texture;
 		lock.release();
 		if (this->state->texture == texture)
@@ -775,6 +914,276 @@ namespace april
 		this->_addUnloadTextureCommand(new DestroyTextureCommand(texture));
 	}
 
+	Texture* RenderSystem::acquireSharedTextureFromResource(chstr filename, Texture::Type type, Texture::LoadMode loadMode)
+	{
+		return this->_acquireSharedTextureFromSource(true, filename, type, loadMode);
+	}
+
+	Texture* RenderSystem::acquireSharedTextureFromResource(chstr filename, Image::Format format, Texture::Type type, Texture::LoadMode loadMode)
+	{
+		return this->_acquireSharedTextureFromSource(true, filename, type, loadMode, format);
+	}
+
+	Texture* RenderSystem::acquireSharedTextureFromFile(chstr filename, Texture::Type type, Texture::LoadMode loadMode)
+	{
+		return this->_acquireSharedTextureFromSource(false, filename, type, loadMode);
+	}
+
+	Texture* RenderSystem::acquireSharedTextureFromFile(chstr filename, Image::Format format, Texture::Type type, Texture::LoadMode loadMode)
+	{
+		return this->_acquireSharedTextureFromSource(false, filename, type, loadMode, format);
+	}
+
+	Texture* RenderSystem::_acquireSharedTextureFromSource(bool fromResource, chstr filename, Texture::Type type, Texture::LoadMode loadMode, Image::Format format)
+	{
+		if (!this->caps.externalTextures && type == Texture::Type::External)
+		{
+			type = Texture::Type::Managed; // same as in _createTextureFromSource() so both requests share the texture
+		}
+		hstr name = (fromResource ? this->findTextureResource(filename, true) : this->findTextureFile(filename, true));
+		if (name == "")
+		{
+			return NULL;
+		}
+		hstr key = hsprintf("%s:%s:%s:%s:", (fromResource ? "resource" : "file"), type.getName().cStr(), format.getName().cStr(), loadMode.getName().cStr()) + name;
+		std::unique_lock<std::mutex> lock(this->sharedTexturesMutex);
+		Texture* texture = NULL;
+		while (this->sharedTextures.hasKey(key))
+		{
+			texture = this->sharedTextures[key];
+			if (texture != NULL)
+			{
+				++this->sharedTextureReferences[texture];
+				// the texture might have been unloaded in the meantime, an already queued load is only raised in priority
+				if ((loadMode == Texture::LoadMode::Async || loadMode == Texture::LoadMode::AsyncDeferredUpload) && texture->isUnloaded())
+				{
+					texture->loadAsync();
+				}
+				return texture;
+			}
+			// another thread is creating this texture, if that fails the placeholder is removed and this thread tries it instead
+			this->sharedTextureCreatedCondition.wait(lock);
+		}
+		// the placeholder keeps other requests for this key waiting, while requests for other textures don't have to wait for a synchronous load
+		this->sharedTextures[key] = NULL;
+		lock.unlock();
+		texture = this->_createTextureFromSource(fromResource, name, type, loadMode, format);
+		lock.lock();
+		if (texture != NULL)
+		{
+			this->sharedTextures[key] = texture;
+			this->sharedTextureReferences[texture] = 1;
+		}
+		else
+		{
+			this->sharedTextures.removeKey(key);
+		}
+		lock.unlock();
+		this->sharedTextureCreatedCondition.notify_all();
+		return texture;
+	}
+
+	void RenderSystem::releaseSharedTexture(Texture* texture)
+	{
+		if (texture == NULL)
+		{
+			throw Exception("Cannot call releaseSharedTexture(), texture is NULL!");
+		}
+		std::unique_lock<std::mutex> lock(this->sharedTexturesMutex);
+		if (!this->sharedTextureReferences.hasKey(texture))
+		{
+			hlog::warn(logTag, "Cannot release texture, it's not a shared texture: " + texture->_getInternalName());
+			return;
+		}
+		int references = this->sharedTextureReferences[texture] - 1;
+		if (references > 0)
+		{
+			this->sharedTextureReferences[texture] = references;
+			return;
+		}
+		this->_removeSharedTexture(texture);
+		lock.unlock();
+		this->destroyTexture(texture); // the last reference is gone, so the GPU memory can be released
+	}
+
+	int RenderSystem::getSharedTextureReferenceCount(Texture* texture)
+	{
+		std::unique_lock<std::mutex> lock(this->sharedTexturesMutex);
+		return this->sharedTextureReferences.tryGet(texture, 0);
+	}
+
+	void RenderSystem::_removeSharedTexture(Texture* texture)
+	{
+		if (!this->sharedTextureReferences.hasKey(texture))
+		{
+			return;
+		}
+		this->sharedTextureReferences.removeKey(texture);
+		foreach_m (Texture*, it, this->sharedTextures)
+		{
+			if (it->second == texture)
+			{
+				this->sharedTextures.removeKey(it->first);
+				break;
+			}
+		}
+	}
+
+	Texture* RenderSystem::acquireRenderTarget(int width, int height)
+	{
+		return this->_acquireRenderTarget(width, height, false);
+	}
+
+	Texture* RenderSystem::acquireTransientRenderTarget(int width, int height)
+	{
+		return this->_acquireRenderTarget(width, height, true);
+	}
+
+	Texture* RenderSystem::_acquireRenderTarget(int width, int height, bool transient)
+	{
+		// render targets always use the native format, so the size is enough to find a matching one
+		hmutex::ScopeLock lock(&this->renderTargetPoolMutex);
+		Texture* texture = NULL;
+		for_iter (i, 0, this->freeRenderTargets.size())
+		{
+			// a target released in this frame could still be referenced by rendering that wasn't flushed yet
+			if (this->freeRenderTargets[i]->getWidth() == width && this->freeRenderTargets[i]->getHeight() == height &&
+				this->freeRenderTargetFrames[this->freeRenderTargets[i]] < this->renderTargetPoolFrame)
+			{
+				texture = this->freeRenderTargets.removeAt(i);
+				this->freeRenderTargetFrames.removeKey(texture);
+				++this->statRenderTargetPoolHits;
+				break;
+			}
+		}
+		if (texture == NULL)
+		{
+			++this->statRenderTargetPoolMisses;
+			lock.release();
+			texture = this->createRenderTarget(width, height);
+			if (texture == NULL)
+			{
+				return NULL;
+			}
+			lock.acquire(&this->renderTargetPoolMutex);
+		}
+		this->pooledRenderTargets += texture;
+		if (transient)
+		{
+			this->transientRenderTargets += texture;
+		}
+		return texture;
+	}
+
+	void RenderSystem::releaseRenderTarget(Texture* texture)
+	{
+		if (texture == NULL)
+		{
+			throw Exception("Cannot call releaseRenderTarget(), texture is NULL!");
+		}
+		hmutex::ScopeLock lock(&this->renderTargetPoolMutex);
+		if (!this->pooledRenderTargets.has(texture))
+		{
+			hlog::warn(logTag, "Cannot release texture, it's not an acquired pooled render target: " + texture->_getInternalName());
+			return;
+		}
+		this->pooledRenderTargets -= texture;
+		if (this->transientRenderTargets.has(texture))
+		{
+			this->transientRenderTargets -= texture;
+		}
+		this->freeRenderTargets += texture;
+		this->freeRenderTargetFrames[texture] = this->renderTargetPoolFrame;
+	}
+
+	void RenderSystem::_removePooledRenderTarget(Texture* texture)
+	{
+		if (this->pooledRenderTargets.has(texture))
+		{
+			this->pooledRenderTargets -= texture;
+		}
+		if (this->transientRenderTargets.has(texture))
+		{
+			this->transientRenderTargets -= texture;
+		}
+		if (this->freeRenderTargets.has(texture))
+		{
+			this->freeRenderTargets -= texture;
+			this->freeRenderTargetFrames.removeKey(texture);
+		}
+	}
+
+	void RenderSystem::_updateRenderTargetPool()
+	{
+		hmutex::ScopeLock lock(&this->renderTargetPoolMutex);
+		foreach (Texture*, it, this->transientRenderTargets)
+		{
+			this->pooledRenderTargets -= (*it);
+			this->freeRenderTargets += (*it);
+			this->freeRenderTargetFrames[*it] = this->renderTargetPoolFrame;
+		}
+		this->transientRenderTargets.clear();
+		++this->renderTargetPoolFrame;
+		int maxIdleFrames = april::getRenderTargetPoolMaxIdleFrames();
+		harray<Texture*> idleTextures;
+		for_iter (i, 0, this->freeRenderTargets.size())
+		{
+			if (this->renderTargetPoolFrame - this->freeRenderTargetFrames[this->freeRenderTargets[i]] > maxIdleFrames)
+			{
+				idleTextures += this->freeRenderTargets.removeAt(i);
+				this->freeRenderTargetFrames.removeKey(idleTextures.last());
+				--i;
+			}
+		}
+		lock.release();
+		foreach (Texture*, it, idleTextures)
+		{
+			this->destroyTexture(*it);
+		}
+	}
+
+	AnimatedTexture* RenderSystem::createAnimatedTextureFromResource(const harray<hstr>& filenames, float frameRate, bool looping, int ringSize)
+	{
+		return this->_createAnimatedTextureFromSource(true, filenames, frameRate, looping, ringSize);
+	}
+
+	AnimatedTexture* RenderSystem::createAnimatedTextureFromFile(const harray<hstr>& filenames, float frameRate, bool looping, int ringSize)
+	{
+		return this->_createAnimatedTextureFromSource(false, filenames, frameRate, looping, ringSize);
+	}
+
+	AnimatedTexture* RenderSystem::_createAnimatedTextureFromSource(bool fromResource, const harray<hstr>& filenames, float frameRate, bool looping, int ringSize)
+	{
+		harray<hstr> names;
+		hstr name;
+		foreach (hstr, it, filenames)
+		{
+			name = (fromResource ? this->findTextureResource((*it), true) : this->findTextureFile((*it), true));
+			if (name == "")
+			{
+				hlog::error(logTag, "Cannot create animated texture, frame not found: " + (*it));
+				return NULL;
+			}
+			names += name;
+		}
+		AnimatedTexture* animatedTexture = new AnimatedTexture(fromResource);
+		if (!animatedTexture->_create(names, frameRate, looping, ringSize))
+		{
+			delete animatedTexture;
+			return NULL;
+		}
+		return animatedTexture;
+	}
+
+	void RenderSystem::destroyAnimatedTexture(AnimatedTexture* animatedTexture)
+	{
+		if (animatedTexture == NULL)
+		{
+			throw Exception("Cannot call destroyAnimatedTexture(), animatedTexture is NULL!");
+		}
+		delete animatedTexture;
+	}
+
 	PixelShader* RenderSystem::createPixelShaderFromResource(chstr filename)
 	{
 		return this->_createPixelShaderFromSource(true, filename);
@@ -1075,15 +1484,26 @@ namespace april
 		// texture
 		if (forceUpdate || this->deviceState->texture != state->texture || this->deviceState->useTexture != state->useTexture)
 		{
-			if (state->texture != NULL && state->useTexture)
+			Texture* texture = (state->useTexture ? state->texture : NULL);
+			Texture* pageTexture = NULL;
+			this->deviceAtlasUsed = false;
+			if (texture != NULL)
 			{
 				++this->statCurrentFrameTextureSwitches;
-				state->texture->_ensureAsyncCompleted();
-				state->texture->_ensureUploaded();
+				texture = this->_useResidentTexture(texture);
+				// commands queued before the texture was packed still use it directly and are redirected to its atlas page
+				if (texture != NULL && TextureAtlas::getRegion(texture, &pageTexture, &this->deviceAtlasUvRect))
+				{
+					texture = this->_useResidentTexture(pageTexture);
+					this->deviceAtlasUsed = (texture == pageTexture);
+				}
+			}
+			if (texture != NULL)
+			{
 				// do not change this order, it can cause heavy issues with render targets
-				this->_setDeviceTexture(state->texture);
-				this->_setDeviceTextureFilter(state->texture->getFilter());
-				this->_setDeviceTextureAddressMode(state->texture->getAddressMode());
+				this->_setDeviceTexture(texture);
+				this->_setDeviceTextureFilter(texture->_getRenderFilter());
+				this->_setDeviceTextureAddressMode(texture->getAddressMode());
 			}
 			else
 			{
@@ -1113,6 +1533,232 @@ namespace april
 		this->deviceState->useColor = state->useColor;
 	}
 
+	void RenderSystem::_copyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect)
+	{
+		if (TextureAtlas::has(destination))
+		{
+			hlog::error(logTag, "Cannot copy into texture, it's packed into a texture atlas: " + destination->_getInternalName());
+			return;
+		}
+		// an async load that finishes later would overwrite the copied data
+		destination->_ensureAsyncCompleted();
+		if (!destination->_ensureUploaded())
+		{
+			hlog::error(logTag, "Cannot copy into texture, it couldn't be uploaded: " + destination->_getInternalName());
+			return;
+		}
+		hmutex::ScopeLock lockData(&destination->asyncDataMutex);
+		bool blockDataUploaded = destination->blockDataUploaded;
+		destination->_discardBlockData(); // block data created from the CPU-side data would replace the copied content
+		if (blockDataUploaded)
+		{
+			// pixels can't be copied into block compressed storage so it's specified again with the raw data
+			destination->firstUpload = true;
+			if (!destination->_unpackData() || !destination->_uploadDataToGpu(0, 0, destination->width, destination->height))
+			{
+				hlog::error(logTag, "Cannot copy into texture, its block compressed data couldn't be replaced: " + destination->_getInternalName());
+				return;
+			}
+		}
+		lockData.release();
+		// the source is bound directly, because a streaming proxy or the residency placeholder would be copied into the destination permanently
+		Texture* pageTexture = NULL;
+		grectf uvRect;
+		bool packed = TextureAtlas::getRegion(source, &pageTexture, &uvRect);
+		if (!packed)
+		{
+			source->_ensureAsyncCompleted();
+		}
+		if (!(packed ? pageTexture : source)->_ensureUploaded())
+		{
+			hlog::error(logTag, "Cannot copy texture, it couldn't be loaded: " + source->_getInternalName());
+			return;
+		}
+		source->lastUsedFrame = this->residencyFrame;
+		source->evicted = false;
+		destination->lastUsedFrame = this->residencyFrame;
+		// packed sources are bound through their atlas page, which only the quad of a blit can handle
+		if (sourceRect.w == destinationRect.w && sourceRect.h == destinationRect.h && !packed)
+		{
+			this->_deviceCopyTexture(source, destination, sourceRect, gvec2i(destinationRect.x, destinationRect.y));
+		}
+		else
+		{
+			this->_deviceBlitTexture(source, destination, sourceRect, destinationRect);
+		}
+		lockData.acquire(&destination->asyncDataMutex);
+		// the copied content only exists on the GPU now, so the destination can't be evicted and CPU-side changes don't replace it
+		destination->deviceDataModified = true;
+		lockData.release();
+		hmutex::ScopeLock lock(&destination->asyncLoadMutex);
+		if (destination->mipmapLevels > 1) // only the base level was changed
+		{
+			destination->_updateMipmaps(NULL, destination->format);
+		}
+	}
+
+	void RenderSystem::_renderTextureQuad(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect, bool flipped)
+	{
+		float width = (float)destination->getWidth();
+		float height = (float)destination->getHeight();
+		float sourceWidth = (float)source->getWidth();
+		float sourceHeight = (float)source->getHeight();
+		float left = (float)destinationRect.x;
+		float right = (float)(destinationRect.x + destinationRect.w);
+		float top = (float)destinationRect.y;
+		float bottom = (float)(destinationRect.y + destinationRect.h);
+		if (flipped)
+		{
+			top = height - top;
+			bottom = height - bottom;
+		}
+		TexturedVertex v[APRIL_INTERMEDIATE_TEXTURE_VERTICES_COUNT];
+		v[0].x = left;	v[0].y = top;		v[0].z = 0.0f;	v[0].u = sourceRect.x / sourceWidth;					v[0].v = sourceRect.y / sourceHeight;
+		v[1].x = right;	v[1].y = top;		v[1].z = 0.0f;	v[1].u = (sourceRect.x + sourceRect.w) / sourceWidth;	v[1].v = v[0].v;
+		v[2].x = left;	v[2].y = bottom;	v[2].z = 0.0f;	v[2].u = v[0].u;										v[2].v = (sourceRect.y + sourceRect.h) / sourceHeight;
+		v[3] = v[1];
+		v[4] = v[2];
+		v[5].x = right;	v[5].y = bottom;	v[5].z = 0.0f;	v[5].u = v[1].u;										v[5].v = v[2].v;
+		RenderState deviceState(*this->deviceState);
+		RenderState state(*this->_intermediateState);
+		state.viewport.set(0, 0, destination->getWidth(), destination->getHeight());
+		state.modelviewMatrix.setIdentity();
+		state.projectionMatrix.setOrthoProjection(grectf(-this->pixelOffset, -this->pixelOffset, width, height));
+		state.texture = NULL;
+		state.useTexture = true;
+		state.renderTarget = destination;
+		this->_updateDeviceState(&state, true);
+		// bound directly instead of through _useResidentTexture(), the caller already made sure that the source is loaded
+		Texture* pageTexture = NULL;
+		this->deviceAtlasUsed = TextureAtlas::getRegion(source, &pageTexture, &this->deviceAtlasUvRect);
+		Texture* texture = (this->deviceAtlasUsed ? pageTexture : source);
+		this->_setDeviceTexture(texture);
+		this->_setDeviceTextureFilter(texture->_getRenderFilter());
+		this->_setDeviceTextureAddressMode(texture->getAddressMode());
+		this->_deviceRender(RenderOperation::TriangleList, this->_useDeviceAtlasVertices(v, APRIL_INTERMEDIATE_TEXTURE_VERTICES_COUNT), APRIL_INTERMEDIATE_TEXTURE_VERTICES_COUNT);
+		this->_updateDeviceState(&deviceState, true);
+	}
+
+	Texture* RenderSystem::_useResidentTexture(Texture* texture)
+	{
+		texture->lastUsedFrame = this->residencyFrame;
+		// streamed textures show their proxy instead of blocking while the full resolution image is being loaded
+		Texture* proxyTexture = texture->_useProxyTexture();
+		if (proxyTexture != NULL)
+		{
+			++this->statTextureProxyUses;
+			return proxyTexture;
+		}
+		if (!texture->evicted)
+		{
+			++this->statTextureResidencyHits;
+			texture->_ensureAsyncCompleted();
+			texture->_ensureUploaded();
+			return texture;
+		}
+		// evicted textures are loaded again in the background so rendering doesn't stall
+		if (texture->_tryReload())
+		{
+			++this->statTextureReloads;
+			return texture;
+		}
+		texture = this->residencyPlaceholderTexture;
+		if (texture != NULL)
+		{
+			texture->lastUsedFrame = this->residencyFrame;
+			texture->_ensureAsyncCompleted();
+			texture->_ensureUploaded();
+		}
+		return texture;
+	}
+
+	void RenderSystem::_updateTextureResidency()
+	{
+		++this->residencyFrame;
+		if (this->deviceState->texture != NULL) // a texture that stays bound is still in use
+		{
+			this->deviceState->texture->lastUsedFrame = this->residencyFrame;
+		}
+		harray<Texture*> textures = this->getTextures();
+		// the data is copied for the packer on this thread, so only one texture is queued per frame to avoid spikes
+		foreach (Texture*, it, textures)
+		{
+			if ((*it)->_tryPackData())
+			{
+				break;
+			}
+		}
+		int64_t vramBudget = april::getTextureVRamBudget();
+		int64_t ramBudget = april::getTextureRamBudget();
+		if (vramBudget <= 0LL && ramBudget <= 0LL)
+		{
+			return;
+		}
+		int64_t vramSize = TextureAtlas::getVRamSize();
+		int64_t ramSize = 0LL;
+		foreach (Texture*, it, textures)
+		{
+			vramSize += (int64_t)(*it)->getCurrentVRamSize();
+			ramSize += (int64_t)(*it)->getCurrentAsyncRamSize();
+		}
+		bool vramExceeded = (vramBudget > 0LL && vramSize > vramBudget);
+		bool ramExceeded = (ramBudget > 0LL && ramSize > ramBudget);
+		if (!vramExceeded && !ramExceeded)
+		{
+			return;
+		}
+		HL_LAMBDA_CLASS(_sortLeastRecentlyUsed, bool, ((Texture* const& a, Texture* const& b) { return (a->lastUsedFrame < b->lastUsedFrame); }));
+		textures.sort(&_sortLeastRecentlyUsed::lambda);
+		int vramTextureSize = 0;
+		int ramTextureSize = 0;
+		foreach (Texture*, it, textures)
+		{
+			if (!vramExceeded && !ramExceeded)
+			{
+				break;
+			}
+			// textures used in the last frame would have to be loaded again right away
+			if ((*it)->lastUsedFrame >= this->residencyFrame - 1 || (*it) == this->residencyPlaceholderTexture || !(*it)->_isEvictable())
+			{
+				continue;
+			}
+			vramTextureSize = (*it)->getCurrentVRamSize();
+			ramTextureSize = (*it)->getCurrentAsyncRamSize();
+			if ((vramExceeded && vramTextureSize > 0) || (ramExceeded && ramTextureSize > 0))
+			{
+				hlog::write(logTag, "Evicting texture: " + (*it)->_getInternalName());
+				(*it)->_deviceUnloadTexture();
+				(*it)->evicted = true;
+				++this->statTextureEvictions;
+				vramSize -= vramTextureSize;
+				ramSize -= ramTextureSize;
+				vramExceeded = (vramBudget > 0LL && vramSize > vramBudget);
+				ramExceeded = (ramBudget > 0LL && ramSize > ramBudget);
+			}
+		}
+	}
+
+	PlainVertex* RenderSystem::_useDeviceAtlasVertices(PlainVertex* vertices, int count)
+	{
+		return vertices;
+	}
+
+	TexturedVertex* RenderSystem::_useDeviceAtlasVertices(TexturedVertex* vertices, int count)
+	{
+		// the command's own vertices must stay unchanged, because frames can be repeated
+		return (this->deviceAtlasUsed ? _remapAtlasVertices(vertices, count, this->deviceAtlasUvRect, deviceAtlasTv) : vertices);
+	}
+
+	ColoredVertex* RenderSystem::_useDeviceAtlasVertices(ColoredVertex* vertices, int count)
+	{
+		return vertices;
+	}
+
+	ColoredTexturedVertex* RenderSystem::_useDeviceAtlasVertices(ColoredTexturedVertex* vertices, int count)
+	{
+		return (this->deviceAtlasUsed ? _remapAtlasVertices(vertices, count, this->deviceAtlasUvRect, deviceAtlasCtv) : vertices);
+	}
+
 	void RenderSystem::_addAsyncCommand(AsyncCommand* command)
 	{
 		if (command->isUseState())
@@ -1242,10 +1888,18 @@ namespace april
 
 	void RenderSystem::render(const RenderOperation& renderOperation, const TexturedVertex* vertices, int count)
 	{
+		// packed textures are replaced by their atlas page so render calls with different textures on the same page can be batched
+		Texture* texture = this->state->texture;
+		grectf uvRect;
+		if (texture != NULL && TextureAtlas::getRegion(texture, &this->state->texture, &uvRect))
+		{
+			vertices = _remapAtlasVertices(vertices, count, uvRect, atlasTv);
+		}
 		if (this->renderHelper == NULL || !this->renderHelper->render(renderOperation, vertices, count))
 		{
 			this->_renderInternal(renderOperation, vertices, count);
 		}
+		this->state->texture = texture;
 	}
 
 	void RenderSystem::render(const RenderOperation& renderOperation, const TexturedVertex* vertices, int count, const Color& color)
@@ -1254,10 +1908,17 @@ namespace april
 		{
 			return;
 		}
+		Texture* texture = this->state->texture;
+		grectf uvRect;
+		if (texture != NULL && TextureAtlas::getRegion(texture, &this->state->texture, &uvRect))
+		{
+			vertices = _remapAtlasVertices(vertices, count, uvRect, atlasTv);
+		}
 		if (this->renderHelper == NULL || !this->renderHelper->render(renderOperation, vertices, count, color))
 		{
 			this->_renderInternal(renderOperation, vertices, count, color);
 		}
+		this->state->texture = texture;
 	}
 
 	void RenderSystem::render(const RenderOperation& renderOperation, const ColoredVertex* vertices, int count)
@@ -1270,10 +1931,17 @@ namespace april
 
 	void RenderSystem::render(const RenderOperation& renderOperation, const ColoredTexturedVertex* vertices, int count)
 	{
+		Texture* texture = this->state->texture;
+		grectf uvRect;
+		if (texture != NULL && TextureAtlas::getRegion(texture, &this->state->texture, &uvRect))
+		{
+			vertices = _remapAtlasVertices(vertices, count, uvRect, atlasCtv);
+		}
 		if (this->renderHelper == NULL || !this->renderHelper->render(renderOperation, vertices, count))
 		{
 			this->_renderInternal(renderOperation, vertices, count);
 		}
+		this->state->texture = texture;
 	}
 
 	void RenderSystem::drawRect(cgrectf rect, const Color& color)
@@ -1302,10 +1970,18 @@ namespace april
 
 	void RenderSystem::drawTexturedRect(cgrectf rect, cgrectf src)
 	{
-		if (this->renderHelper == NULL || !this->renderHelper->drawTexturedRect(rect, src))
+		Texture* texture = this->state->texture;
+		grectf uvRect;
+		grectf uvSrc = src;
+		if (texture != NULL && TextureAtlas::getRegion(texture, &this->state->texture, &uvRect))
+		{
+			uvSrc = _remapAtlasRect(src, uvRect);
+		}
+		if (this->renderHelper == NULL || !this->renderHelper->drawTexturedRect(rect, uvSrc))
 		{
-			this->_drawTexturedRectInternal(rect, src);
+			this->_drawTexturedRectInternal(rect, uvSrc);
 		}
+		this->state->texture = texture;
 	}
 
 	void RenderSystem::drawTexturedRect(cgrectf rect, cgrectf src, const Color& color)
@@ -1314,10 +1990,18 @@ namespace april
 		{
 			return;
 		}
-		if (this->renderHelper == NULL || !this->renderHelper->drawTexturedRect(rect, src, color))
+		Texture* texture = this->state->texture;
+		grectf uvRect;
+		grectf uvSrc = src;
+		if (texture != NULL && TextureAtlas::getRegion(texture, &this->state->texture, &uvRect))
 		{
-			this->_drawTexturedRectInternal(rect, src, color);
+			uvSrc = _remapAtlasRect(src, uvRect);
 		}
+		if (this->renderHelper == NULL || !this->renderHelper->drawTexturedRect(rect, uvSrc, color))
+		{
+			this->_drawTexturedRectInternal(rect, uvSrc, color);
+		}
+		this->state->texture = texture;
 	}
 
 	void RenderSystem::_renderInternal(const RenderOperation& renderOperation, const PlainVertex* vertices, int count)
@@ -1459,64 +2143,24 @@ namespace april
 
 	hstr RenderSystem::findTextureResource(chstr filename, bool includeExtension) const
 	{
-		if (hresource::exists(filename))
-		{
-			return filename;
-		}
-		hstr name;
-		harray<hstr> extensions = april::getTextureExtensions();
-		foreach (hstr, it, extensions)
-		{
-			name = filename + (*it);
-			if (hresource::exists(name))
-			{
-				return (includeExtension ? name : filename);
-			}
-		}
-		hstr noExtensionName = hfile::withoutExtension(filename);
-		if (noExtensionName != filename)
-		{
-			foreach (hstr, it, extensions)
-			{
-				name = noExtensionName + (*it);
-				if (hresource::exists(name))
-				{
-					return (includeExtension ? name : noExtensionName);
-				}
-			}
-		}
-		return "";
+		return TextureManifest::find(filename, true, includeExtension);
 	}
 	
 	hstr RenderSystem::findTextureFile(chstr filename, bool includeExtension) const
 	{
-		if (hfile::exists(filename))
-		{
-			return filename;
-		}
-		hstr name;
-		harray<hstr> extensions = april::getTextureExtensions();
-		foreach (hstr, it, extensions)
+		return TextureManifest::find(filename, false, includeExtension);
+	}
+
+	void RenderSystem::invalidateTextureLookups(chstr path)
+	{
+		if (path == "")
 		{
-			name = filename + (*it);
-			if (hfile::exists(name))
-			{
-				return (includeExtension ? name : filename);
-			}
+			TextureManifest::clear();
 		}
-		hstr noExtensionName = hfile::withoutExtension(filename);
-		if (noExtensionName != filename)
+		else
 		{
-			foreach (hstr, it, extensions)
-			{
-				name = noExtensionName + (*it);
-				if (hfile::exists(name))
-				{
-					return (includeExtension ? name : noExtensionName);
-				}
-			}
+			TextureManifest::invalidate(path);
 		}
-		return "";
 	}
 	
 	void RenderSystem::unloadTextures()
@@ -1539,12 +2183,7 @@ namespace april
 
 	void RenderSystem::waitForAsyncTextures(float timeout) const
 	{
-		float time = timeout;
-		while ((time > 0.0f || timeout <= 0.0f) && this->hasAsyncTexturesQueued())
-		{
-			hthread::sleep(0.1f);
-			time -= 0.0001f;
-		}
+		TextureAsync::waitForIdle(timeout);
 	}
 
 	void RenderSystem::flushFrame(bool updateStats)
@@ -1565,6 +2204,8 @@ namespace april
 			this->statCurrentFrameTriangleCount = 0;
 			this->statLastFrameLineCount = this->statCurrentFrameLineCount;
 			this->statCurrentFrameLineCount = 0;
+			this->statLastFrameTextureUploadBytes = this->statCurrentFrameTextureUploadBytes;
+			this->statCurrentFrameTextureUploadBytes = 0LL;
 		}
 	}
 
@@ -1573,9 +2214,75 @@ namespace april
 		this->_addAsyncCommand(new TakeScreenshotCommand(*this->state, format, backBufferOnly));
 	}
 
+	void RenderSystem::copyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgvec2i destinationPosition)
+	{
+		if (source == NULL)
+		{
+			throw Exception("Cannot call copyTexture(), source is NULL!");
+		}
+		if (destination == NULL)
+		{
+			throw Exception("Cannot call copyTexture(), destination is NULL!");
+		}
+		if (source == destination)
+		{
+			hlog::error(logTag, "Cannot copy texture into itself: " + source->_getInternalName());
+			return;
+		}
+		int sx = sourceRect.x;
+		int sy = sourceRect.y;
+		int sw = sourceRect.w;
+		int sh = sourceRect.h;
+		int dx = destinationPosition.x;
+		int dy = destinationPosition.y;
+		if (Image::correctRect(sx, sy, sw, sh, source->getWidth(), source->getHeight(), dx, dy, destination->getWidth(), destination->getHeight()))
+		{
+			this->_addAsyncCommand(new CopyTextureCommand(source, destination, grecti(sx, sy, sw, sh), grecti(dx, dy, sw, sh)));
+		}
+	}
+
+	void RenderSystem::copyTexture(Texture* source, Texture* destination)
+	{
+		if (source == NULL)
+		{
+			throw Exception("Cannot call copyTexture(), source is NULL!");
+		}
+		this->copyTexture(source, destination, grecti(0, 0, source->getWidth(), source->getHeight()), gvec2i(0, 0));
+	}
+
+	void RenderSystem::blitTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect)
+	{
+		if (source == NULL)
+		{
+			throw Exception("Cannot call blitTexture(), source is NULL!");
+		}
+		if (destination == NULL)
+		{
+			throw Exception("Cannot call blitTexture(), destination is NULL!");
+		}
+		if (source == destination)
+		{
+			hlog::error(logTag, "Cannot blit texture into itself: " + source->_getInternalName());
+			return;
+		}
+		int sx = sourceRect.x;
+		int sy = sourceRect.y;
+		int sw = sourceRect.w;
+		int sh = sourceRect.h;
+		int dx = destinationRect.x;
+		int dy = destinationRect.y;
+		int dw = destinationRect.w;
+		int dh = destinationRect.h;
+		if (Image::correctRect(sx, sy, sw, sh, source->getWidth(), source->getHeight(), dx, dy, dw, dh, destination->getWidth(), destination->getHeight()))
+		{
+			this->_addAsyncCommand(new CopyTextureCommand(source, destination, grecti(sx, sy, sw, sh), grecti(dx, dy, dw, dh)));
+		}
+	}
+
 	void RenderSystem::presentFrame()
 	{
 		this->_addAsyncCommand(new PresentFrameCommand(*this->state, april::window->isPresentFrameEnabled()));
+		this->_updateRenderTargetPool();
 	}
 
 	void RenderSystem::_devicePresentFrame(bool systemEnabled)
@@ -1602,6 +2309,26 @@ namespace april
 		hlog::warnf(logTag, "Render targets are not implemented in render system '%s'!", this->name.cStr());
 	}
 
+	void RenderSystem::_deviceCopyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgvec2i destinationPosition)
+	{
+		this->_deviceBlitTexture(source, destination, sourceRect, grecti(destinationPosition.x, destinationPosition.y, sourceRect.w, sourceRect.h));
+	}
+
+	void RenderSystem::_deviceBlitTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect)
+	{
+		if (!this->caps.renderTarget)
+		{
+			hlog::warnf(logTag, "Render targets are not implemented in render system '%s'!", this->name.cStr());
+			return;
+		}
+		if (destination->getType() != Texture::Type::RenderTarget)
+		{
+			hlog::errorf(logTag, "Cannot blit texture, render system '%s' can only blit into render targets: %s", this->name.cStr(), destination->_getInternalName().cStr());
+			return;
+		}
+		this->_renderTextureQuad(source, destination, sourceRect, destinationRect, false);
+	}
+
 	void RenderSystem::_deviceTakeScreenshot(Image::Format format, bool backBufferOnly)
 	{
 		hlog::warnf(logTag, "Taking screenshots is not implemented in render system '%s'!", this->name.cStr());
@@ -10,16 +10,27 @@
 #include <hltypes/hfile.h>
 #include <hltypes/hlog.h>
 #include <hltypes/hltypesUtil.h>
+#include <hltypes/hrdir.h>
 #include <hltypes/hresource.h>
 #include <hltypes/hstring.h>
 
 #include "april.h"
 #include "Color.h"
+#include "fileUtil.h"
 #include "Image.h"
 #include "RenderSystem.h"
 #include "Texture.h"
 #include "TextureAsync.h"
+#include "TextureAtlas.h"
+#include "TextureCache.h"
+#include "TextureCompressor.h"
+#include "TextureDataPacker.h"
 #include "UnloadTextureCommand.h"
+#include "zlibUtil.h"
+
+// more separate uploads cost more than uploading some unchanged pixels
+#define MAX_DIRTY_RECTS 16
+#define DATA_PACKING_DELAY_FRAMES 60
 
 namespace april
 {
@@ -35,6 +46,8 @@ namespace april
 	(
 		HL_ENUM_DEFINE(Texture::Filter, Nearest);
 		HL_ENUM_DEFINE(Texture::Filter, Linear);
+		HL_ENUM_DEFINE(Texture::Filter, MipNearest);
+		HL_ENUM_DEFINE(Texture::Filter, MipLinear);
 	));
 
 	HL_ENUM_CLASS_DEFINE(Texture::AddressMode,
@@ -50,6 +63,13 @@ namespace april
 		HL_ENUM_DEFINE(Texture::LoadMode, OnDemand);
 	));
 
+	HL_ENUM_CLASS_DEFINE(Texture::LoadPriority,
+	(
+		HL_ENUM_DEFINE(Texture::LoadPriority, Prefetch);
+		HL_ENUM_DEFINE(Texture::LoadPriority, Normal);
+		HL_ENUM_DEFINE(Texture::LoadPriority, Visible);
+	));
+
 	Texture::Lock::Lock()
 	{
 		this->systemBuffer = NULL;
@@ -110,11 +130,35 @@ namespace april
 		this->locked = false;
 		this->dirty = false;
 		this->data = NULL;
+		this->dataPacking = false;
+		this->packedData = NULL;
+		this->packedDataSize = 0;
+		this->lastDataAccessFrame = 0LL;
+		this->dataVersion = 0;
 		this->dataAsync = NULL;
 		this->asyncLoadQueued = false;
 		this->asyncLoadDiscarded = false;
 		this->fromResource = fromResource;
 		this->firstUpload = true;
+		this->asyncUploadRow = 0;
+		this->asyncUploadBackground = false;
+		this->loadMaxDimension = april::getMaxTextureLoadDimension();
+		this->loadScale = april::getTextureLoadScale();
+		this->compressible = false;
+		this->blockData = NULL;
+		this->blockDataSize = 0;
+		this->blockFormat = Image::BlockFormat::Etc2Rgb;
+		this->blockDataUploaded = false;
+		this->compressionVersion = 0;
+		this->anisotropy = 1.0f;
+		this->mipmapLevels = 1;
+		this->mipmapsOutdated = false;
+		this->lastUsedFrame = 0LL;
+		this->evicted = false;
+		this->deviceDataModified = false;
+		this->visibleDimension = 0;
+		this->proxyTexture = NULL;
+		this->proxyImageAsync = NULL;
 	}
 
 	bool Texture::_create(chstr filename, Texture::Type type, Texture::LoadMode loadMode)
@@ -126,6 +170,11 @@ namespace april
 		return true;
 	}
 
+	int Texture::_getLoadDownscaleDivisor(int w, int h) const
+	{
+		return Image::calcDownscaleDivisor(w, h, this->loadMaxDimension, this->loadScale);
+	}
+
 	bool Texture::_create(chstr filename, Image::Format format, Texture::Type type, Texture::LoadMode loadMode)
 	{
 		this->filename = filename;
@@ -147,9 +196,20 @@ namespace april
 		this->height = height;
 		this->type = type;
 		this->format = format;
+		if (this->format == Image::Format::Palette)
+		{
+			this->compressedSize = APRIL_IMAGE_PALETTE_BYTE_SIZE + this->width * this->height;
+		}
 		this->data = new unsigned char[this->getByteSize()];
 		hlog::write(logTag, "Registering manual texture: " + this->_getInternalName()); // print here because type and format need to be assigned first
-		Image::write(0, 0, this->width, this->height, 0, 0, data, this->width, this->height, format, this->data, this->width, this->height, this->format);
+		if (this->format == Image::Format::Palette)
+		{
+			memcpy(this->data, data, this->compressedSize);
+		}
+		else
+		{
+			Image::write(0, 0, this->width, this->height, 0, 0, data, this->width, this->height, format, this->data, this->width, this->height, this->format);
+		}
 		this->_checkMaxTextureSize();
 		this->_assignFormat();
 		return true;
@@ -202,6 +262,21 @@ namespace april
 
 	Texture::~Texture()
 	{
+		TextureCompressor::dequeue(this);
+		TextureDataPacker::dequeue(this);
+		TextureAsync::removeCallbacks(this);
+		if (this->blockData != NULL)
+		{
+			delete[] this->blockData;
+		}
+		// the loader threads must not keep a pointer to this texture
+		TextureAsync::cancelLoad(this);
+		TextureAsync::waitForLoad(this);
+		if (this->proxyTexture != NULL)
+		{
+			this->proxyTexture->_deviceUnloadTexture();
+			delete this->proxyTexture;
+		}
 		// this mutex order must remain the same, because of the order of locking in other places
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
 		this->asyncLoadQueued = false;
@@ -210,28 +285,44 @@ namespace april
 		{
 			delete[] this->dataAsync;
 		}
+		if (this->proxyImageAsync != NULL)
+		{
+			delete this->proxyImageAsync;
+		}
 		hmutex::ScopeLock lockData(&this->asyncDataMutex);
 		if (this->data != NULL)
 		{
 			delete[] this->data;
 		}
+		if (this->packedData != NULL)
+		{
+			delete[] this->packedData;
+		}
 	}
 
 	void Texture::_deviceUnloadTexture()
 	{
+		TextureAtlas::remove(this);
 		this->_deviceDestroyTexture();
-		hmutex::ScopeLock lock(&this->asyncLoadMutex);
-		this->uploaded = false;
-		if (this->asyncLoadQueued)
+		if (this->proxyTexture != NULL) // it keeps its data in RAM and is uploaded again when needed
 		{
-			this->asyncLoadDiscarded = true;
+			this->proxyTexture->_deviceUnloadTexture();
 		}
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		this->uploaded = false;
+		this->_cancelAsyncLoad();
 		if (this->dataAsync != NULL)
 		{
 			delete[] this->dataAsync;
 			this->dataAsync = NULL;
 		}
 		this->firstUpload = true;
+		this->asyncUploadRow = 0;
+		this->asyncUploadBackground = false;
+		this->blockDataUploaded = false; // the block data stays in RAM so it can be used again on the next upload
+		this->deviceDataModified = false; // anything changed directly on the GPU is lost
+		this->mipmapLevels = 1;
+		this->mipmapsOutdated = this->_isMipmapFilter();
 	}
 
 	int Texture::getWidth() const
@@ -287,7 +378,14 @@ namespace april
 		// VRAM
 		if (this->width > 0 && this->height > 0 && this->format != Image::Format::Invalid && this->uploaded)
 		{
-			result += byteSize;
+			if (this->blockDataUploaded)
+			{
+				result += this->blockDataSize;
+			}
+			else
+			{
+				result += (this->mipmapLevels > 1 ? Image::calcMipmapChainSize(this->width, this->height, this->format.getBpp(), this->mipmapLevels) : byteSize);
+			}
 		}
 		// async RAM
 		bool asyncRamUsed = (!this->asyncLoadQueued && this->dataAsync != NULL && !this->uploaded);
@@ -299,37 +397,58 @@ namespace april
 		// RAM
 		if (this->type != Type::Immutable && this->type != Type::RenderTarget)
 		{
-			result += byteSize;
+			result += (this->packedData != NULL ? this->packedDataSize : byteSize);
+		}
+		if (this->blockData != NULL)
+		{
+			result += this->blockDataSize;
 		}
 		return result;
 	}
 
 	int Texture::getCurrentVRamSize()
 	{
+		if (TextureAtlas::has(this)) // the shared atlas page is counted instead
+		{
+			return 0;
+		}
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
 		if (this->width == 0 || this->height == 0 || this->format == Image::Format::Invalid || !this->uploaded)
 		{
 			return 0;
 		}
 		lock.release();
+		if (this->blockDataUploaded)
+		{
+			return this->blockDataSize;
+		}
 		if (this->compressedSize > 0)
 		{
 			return this->compressedSize;
 		}
+		if (this->mipmapLevels > 1)
+		{
+			return Image::calcMipmapChainSize(this->width, this->height, this->format.getBpp(), this->mipmapLevels);
+		}
 		return (this->width * this->height * this->format.getBpp());
 	}
 
 	int Texture::getCurrentRamSize()
 	{
+		int blockDataRamSize = (this->blockData != NULL ? this->blockDataSize : 0);
 		if (this->type == Type::Immutable || this->type == Type::RenderTarget)
 		{
-			return 0;
+			return blockDataRamSize;
+		}
+		if (this->packedData != NULL)
+		{
+			return (this->packedDataSize + blockDataRamSize);
 		}
 		if (this->compressedSize > 0)
 		{
-			return this->compressedSize;
+			return (this->compressedSize + blockDataRamSize);
 		}
-		return (this->width * this->height * this->format.getBpp());
+		return (this->width * this->height * this->format.getBpp() + blockDataRamSize);
 	}
 
 	int Texture::getCurrentAsyncRamSize()
@@ -357,6 +476,11 @@ namespace april
 		return this->uploaded;
 	}
 
+	bool Texture::isBlockCompressed() const
+	{
+		return this->blockDataUploaded;
+	}
+
 	bool Texture::isReadyForUpload()
 	{
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
@@ -432,13 +556,32 @@ namespace april
 		return (!this->asyncLoadQueued && (this->filename == "" || this->dataAsync != NULL) && !this->uploaded);
 	}
 
-	bool Texture::loadAsync()
+	bool Texture::_isAsyncLoadFinished()
 	{
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
-		return this->_loadAsync();
+		if (this->asyncLoadQueued)
+		{
+			return false;
+		}
+		// textures created from memory and asynchronously loaded data still have to be uploaded
+		return (this->uploaded || (this->filename != "" && this->dataAsync == NULL));
+	}
+
+	bool Texture::loadAsync(LoadPriority priority, float deadline)
+	{
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		return this->_loadAsync(priority, deadline);
+	}
+
+	bool Texture::loadAsync(void (*callback)(Texture* texture, bool success, void* userData), void* userData, LoadPriority priority, float deadline)
+	{
+		bool result = this->loadAsync(priority, deadline);
+		// registered after queueing so the texture can't be mistaken for an already finished one
+		TextureAsync::addCallback(this, callback, userData);
+		return result;
 	}
 
-	bool Texture::_loadAsync()
+	bool Texture::_loadAsync(LoadPriority priority, float deadline)
 	{
 		if (this->dataAsync != NULL || this->uploaded || this->filename == "")
 		{
@@ -446,13 +589,44 @@ namespace april
 		}
 		this->_loadMetaData();
 		this->asyncLoadDiscarded = false;
-		if (!this->asyncLoadQueued && this->type != Type::RenderTarget)
+		if (this->type != Type::RenderTarget)
 		{
-			this->asyncLoadQueued = TextureAsync::queueLoad(this);
+			if (!this->asyncLoadQueued)
+			{
+				this->asyncLoadQueued = TextureAsync::queueLoad(this, priority, deadline, this->_needsAsyncProxy());
+			}
+			else
+			{
+				TextureAsync::updateLoad(this, priority, deadline);
+			}
 		}
 		return this->asyncLoadQueued;
 	}
 
+	bool Texture::cancelAsyncLoad()
+	{
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		return this->_cancelAsyncLoad();
+	}
+
+	bool Texture::_cancelAsyncLoad()
+	{
+		if (!this->asyncLoadQueued)
+		{
+			return false;
+		}
+		if (TextureAsync::cancelLoad(this))
+		{
+			this->asyncLoadQueued = false;
+			this->asyncLoadDiscarded = false;
+		}
+		else // it's already being read or decoded so the result has to be discarded
+		{
+			this->asyncLoadDiscarded = true;
+		}
+		return true;
+	}
+
 	bool Texture::loadMetaData()
 	{
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
@@ -461,7 +635,7 @@ namespace april
 			return true;
 		}
 		hmutex::ScopeLock lockData(&this->asyncDataMutex);
-		if (this->data != NULL)
+		if (this->_hasData())
 		{
 			return true;
 		}
@@ -490,7 +664,18 @@ namespace april
 			}
 			this->width = image->w;
 			this->height = image->h;
-			this->format = image->format;
+			// compressed data can't be downscaled, otherwise the size has to match the one after decoding
+			if (image->internalFormat == 0 && image->format != Image::Format::Compressed)
+			{
+				int divisor = this->_getLoadDownscaleDivisor(image->w, image->h);
+				this->width = (image->w + divisor - 1) / divisor;
+				this->height = (image->h + divisor - 1) / divisor;
+			}
+			// meta data always reports expanded formats, whether palette data is actually available is only known after decoding
+			if (this->format != Image::Format::Palette || !april::rendersys->getCaps().textureFormats.has(Image::Format::Palette))
+			{
+				this->format = image->format;
+			}
 			this->dataFormat = image->internalFormat;
 			if (this->dataFormat != 0)
 			{
@@ -501,7 +686,7 @@ namespace april
 		return true;
 	}
 
-	bool Texture::_tryAsyncFinalUpload()
+	bool Texture::_tryAsyncFinalUpload(int64_t maxBytes)
 	{
 		if (!april::rendersys->canUseLowLevelCalls())
 		{
@@ -512,19 +697,34 @@ namespace april
 		{
 			return false;
 		}
-		this->_upload(lock);
+		if (this->asyncUploadBackground) // only counts as an upload once it can be taken over
+		{
+			return this->_finishBackgroundUpload(lock, false);
+		}
+		this->_upload(lock, maxBytes);
 		return true;
 	}
 
-	bool Texture::_upload(hmutex::ScopeLock& lock)
+	bool Texture::_upload(hmutex::ScopeLock& lock, int64_t maxBytes)
 	{
 		if (!april::rendersys->canUseLowLevelCalls())
 		{
 			return false;
 		}
+		if (this->asyncUploadRow > 0) // the device texture already exists and only the remaining tiles are missing
+		{
+			return this->_uploadAsyncTiles(lock, maxBytes);
+		}
+		if (this->asyncUploadBackground) // the data is needed right now so the background upload has to be waited for
+		{
+			return this->_finishBackgroundUpload(lock, true);
+		}
 		this->asyncLoadDiscarded = false; // a possible previous unload call must be canceled
 		int size = 0;
 		unsigned char* currentData = NULL;
+		hmutex::ScopeLock lockData(&this->asyncDataMutex);
+		this->_unpackData(); // e.g. restoring a lost device needs the data again
+		lockData.release();
 		// no lock required since it only checks for existence, not for manipulation of data
 		if (this->data != NULL) // reload from memory
 		{
@@ -551,22 +751,10 @@ namespace april
 				hlog::error(logTag, "No filename for texture specified!");
 				return false;
 			}
-			// must not call createFromResource() or createFromFile() that converts automatically, because _processImageFormatSupport() needs to be called first
-			Image* image = (this->fromResource ? Image::createFromResource(this->filename) : Image::createFromFile(this->filename));
-			if (image != NULL)
-			{
-				image = this->_processImageFormatSupport(image);
-			}
-			if (image != NULL && this->format != Image::Format::Invalid && Image::needsConversion(image->format, this->format))
-			{
-				unsigned char* data = NULL;
-				if (Image::convertToFormat(image->w, image->h, image->data, image->format, &data, this->format))
-				{
-					delete[] image->data;
-					image->format = this->format;
-					image->data = data;
-				}
-			}
+			// the whole file is read first so the decoded texture cache can be checked before decoding
+			hstream stream;
+			this->_readSource(stream);
+			Image* image = this->_decodeImage(stream);
 			if (image == NULL)
 			{
 				hlog::error(logTag, "Failed to load texture: " + this->_getInternalName());
@@ -576,7 +764,7 @@ namespace april
 			this->height = image->h;
 			this->format = image->format;
 			this->dataFormat = image->internalFormat;
-			if (this->dataFormat != 0)
+			if (this->dataFormat != 0 || this->format == Image::Format::Palette)
 			{
 				size = image->compressedSize;
 				this->compressedSize = size;
@@ -591,6 +779,43 @@ namespace april
 			delete image;
 		}
 		this->_assignFormat();
+		// small textures are rendered from a shared atlas page instead of their own GPU texture
+		if (currentData != NULL && TextureAtlas::add(this, currentData, this->format))
+		{
+			lock.acquire(&this->asyncDataMutex);
+			this->dirty = false;
+			this->dirtyRects.clear();
+			if (this->filename == "")
+			{
+				if (this->data != currentData)
+				{
+					if (this->data != NULL)
+					{
+						delete[] this->data;
+					}
+					this->data = currentData;
+					++this->dataVersion;
+				}
+				lock.release();
+			}
+			else
+			{
+				lock.release();
+				delete[] currentData;
+				this->format = april::rendersys->getNativeTextureFormat(this->format);
+			}
+			lock.acquire(&this->asyncLoadMutex);
+			this->dataAsync = NULL; // not needed anymore and makes isReadyForUpload() return false now
+			this->uploaded = true;
+			return true;
+		}
+		// the render thread only has to take over the device texture once the background upload is done
+		if (this->_canUploadInBackground(currentData) && this->_deviceUploadInBackground(currentData))
+		{
+			lock.acquire(&this->asyncLoadMutex);
+			this->asyncUploadBackground = true;
+			return true;
+		}
 		bool result = this->_deviceCreateTexture(currentData, size);
 		if (!result)
 		{
@@ -609,8 +834,15 @@ namespace april
 		{
 			lock.acquire(&this->asyncDataMutex);
 			this->dirty = false;
-			if (this->firstUpload)
+			this->dirtyRects.clear();
+			if (this->firstUpload && !this->_uploadBlockDataToGpu()) // previously compressed data is still valid if the raw data didn't change
 			{
+				if (maxBytes > 0 && this->_canUploadAsyncTiles(currentData, maxBytes))
+				{
+					lock.release();
+					lock.acquire(&this->asyncLoadMutex);
+					return this->_uploadAsyncTiles(lock, maxBytes);
+				}
 				if (Image::needsConversion(this->format, april::rendersys->getNativeTextureFormat(this->format)) ||
 					!this->_uploadToGpu(0, 0, this->width, this->height, 0, 0, currentData, this->width, this->height, format))
 				{
@@ -622,60 +854,178 @@ namespace april
 					}
 				}
 			}
-			if (this->type != Type::Immutable || this->filename == "")
-			{
-				if (this->data != currentData)
-				{
-					if (this->data != NULL)
-					{
-						delete[] this->data;
-					}
-					this->data = currentData;
-				}
-				lock.release();
-			}
-			else
+			april::rendersys->statCurrentFrameTextureUploadBytes += (int64_t)(this->blockDataUploaded ? this->blockDataSize : this->_getByteSize());
+			this->_applyUploadedData(lock, currentData);
+		}
+		this->_tryUploadDataToGpu(); // upload any additional changes
+		if (!this->blockDataUploaded)
+		{
+			this->_queueCompression();
+		}
+		lock.acquire(&this->asyncLoadMutex);
+		this->dataAsync = NULL; // not needed anymore and makes isReadyForUpload() return false now
+		this->uploaded = result;
+		return true;
+	}
+
+	bool Texture::_canUploadAsyncTiles(unsigned char* currentData, int64_t maxBytes)
+	{
+		if (currentData == NULL || currentData != this->dataAsync || this->type == Type::RenderTarget || this->type == Type::External)
+		{
+			return false;
+		}
+		if (this->format == Image::Format::Compressed || this->format == Image::Format::Palette || this->dataFormat != 0)
+		{
+			return false;
+		}
+		// tiles are uploaded from the async data directly, any conversion would need a full copy anyway
+		if (Image::needsConversion(this->format, april::rendersys->getNativeTextureFormat(this->format)))
+		{
+			return false;
+		}
+		return ((int64_t)this->_getByteSize() > maxBytes);
+	}
+
+	bool Texture::_uploadAsyncTiles(hmutex::ScopeLock& lock, int64_t maxBytes)
+	{
+		unsigned char* currentData = this->dataAsync;
+		lock.release();
+		if (currentData == NULL)
+		{
+			this->asyncUploadRow = 0;
+			return false;
+		}
+		int rowSize = this->width * this->format.getBpp();
+		int y = this->asyncUploadRow;
+		int h = this->height - y;
+		if (maxBytes > 0)
+		{
+			h = (int)hclamp(maxBytes / rowSize, (int64_t)1, (int64_t)h);
+		}
+		lock.acquire(&this->asyncDataMutex);
+		if (!this->_uploadToGpu(0, y, this->width, h, 0, y, currentData, this->width, this->height, this->format))
+		{
+			Lock systemLock = this->_tryLockSystem(0, y, this->width, h);
+			if (!systemLock.failed)
 			{
-				lock.release();
-				delete[] currentData;
-				// the used format will be the native format, because there is no intermediate data
-				this->format = april::rendersys->getNativeTextureFormat(this->format);
+				Image::write(0, y, this->width, h, systemLock.x, systemLock.y, currentData, this->width, this->height, this->format, systemLock.data, systemLock.dataWidth, systemLock.dataHeight, systemLock.format);
+				this->_unlockSystem(systemLock, true);
 			}
 		}
+		april::rendersys->statCurrentFrameTextureUploadBytes += (int64_t)h * rowSize;
+		this->asyncUploadRow = y + h;
+		if (this->asyncUploadRow < this->height)
+		{
+			lock.release();
+			lock.acquire(&this->asyncLoadMutex);
+			return true;
+		}
+		// all tiles are in, the texture can be finalized like a normal upload
+		this->asyncUploadRow = 0;
+		this->_updateMipmaps(currentData, this->format);
+		this->_applyUploadedData(lock, currentData);
 		this->_tryUploadDataToGpu(); // upload any additional changes
+		this->_queueCompression();
 		lock.acquire(&this->asyncLoadMutex);
 		this->dataAsync = NULL; // not needed anymore and makes isReadyForUpload() return false now
-		this->uploaded = result;
+		this->uploaded = true;
 		return true;
 	}
 
-	void Texture::unload()
+	bool Texture::_canUploadInBackground(unsigned char* currentData)
 	{
-		if (!this->isUnloaded())
+		if (currentData == NULL || currentData != this->dataAsync || this->type == Type::RenderTarget || this->type == Type::External)
 		{
-			hlog::write(logTag, "Unloading texture: " + this->_getInternalName());
+			return false;
 		}
-		april::rendersys->_addUnloadTextureCommand(new UnloadTextureCommand(this));
+		if (this->format == Image::Format::Compressed || this->format == Image::Format::Palette || this->dataFormat != 0 || this->blockData != NULL)
+		{
+			return false;
+		}
+		// the upload thread only passes the data on, any conversion would have to happen on the render thread anyway
+		return !Image::needsConversion(this->format, april::rendersys->getNativeTextureFormat(this->format));
 	}
 
-	void Texture::waitForAsyncLoad(float timeout)
+	bool Texture::_finishBackgroundUpload(hmutex::ScopeLock& lock, bool wait)
 	{
-		TextureAsync::prioritizeLoad(this);
-		float time = timeout;
-		hmutex::ScopeLock lock;
-		while (time > 0.0f || timeout <= 0.0f)
+		unsigned char* currentData = this->dataAsync;
+		lock.release();
+		bool success = false;
+		if (!this->_deviceTryFinishBackgroundUpload(wait, &success))
 		{
 			lock.acquire(&this->asyncLoadMutex);
-			if (!this->asyncLoadQueued && this->uploaded)
+			return false;
+		}
+		lock.acquire(&this->asyncLoadMutex);
+		this->asyncUploadBackground = false;
+		if (!success) // the data is still there so it's simply uploaded on this thread
+		{
+			return this->_upload(lock);
+		}
+		lock.release();
+		lock.acquire(&this->asyncDataMutex);
+		this->dirty = false;
+		this->dirtyRects.clear();
+		this->_updateMipmaps(currentData, this->format);
+		this->_applyUploadedData(lock, currentData);
+		this->_tryUploadDataToGpu(); // upload any additional changes
+		this->_queueCompression();
+		lock.acquire(&this->asyncLoadMutex);
+		this->dataAsync = NULL; // not needed anymore and makes isReadyForUpload() return false now
+		this->uploaded = true;
+		return true;
+	}
+
+	bool Texture::_deviceUploadInBackground(unsigned char* data)
+	{
+		return false;
+	}
+
+	bool Texture::_deviceTryFinishBackgroundUpload(bool wait, bool* success)
+	{
+		*success = false;
+		return true;
+	}
+
+	void Texture::_applyUploadedData(hmutex::ScopeLock& lock, unsigned char* currentData)
+	{
+		if (this->type != Type::Immutable || this->filename == "")
+		{
+			if (this->data != currentData)
 			{
-				break;
+				if (this->data != NULL)
+				{
+					delete[] this->data;
+				}
+				this->data = currentData;
+				++this->dataVersion;
 			}
 			lock.release();
-			hthread::sleep(0.1f);
-			time -= 0.0001f;
+		}
+		else
+		{
+			lock.release();
+			delete[] currentData;
+			// the used format will be the native format, because there is no intermediate data
+			this->format = april::rendersys->getNativeTextureFormat(this->format);
 		}
 	}
 
+	void Texture::unload()
+	{
+		if (!this->isUnloaded())
+		{
+			hlog::write(logTag, "Unloading texture: " + this->_getInternalName());
+		}
+		april::rendersys->_addUnloadTextureCommand(new UnloadTextureCommand(this));
+	}
+
+	bool Texture::waitForAsyncLoad(float timeout)
+	{
+		TextureAsync::prioritizeLoad(this);
+		return TextureAsync::waitForUpload(this, timeout);
+	}
+
 	void Texture::_ensureAsyncCompleted()
 	{
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
@@ -685,28 +1035,198 @@ namespace april
 		}
 		lock.release();
 		TextureAsync::prioritizeLoad(this);
-		while (true)
+		// blocks until the loader threads signal that this texture was decoded instead of polling
+		TextureAsync::waitForLoad(this);
+		TextureAsync::updateSingleTexture(this);
+	}
+
+	bool Texture::_ensureUploaded()
+	{
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		if (this->uploaded)
 		{
-			TextureAsync::updateSingleTexture(this);
-			lock.acquire(&this->asyncLoadMutex);
-			if (!this->asyncLoadQueued && this->uploaded)
+			this->_tryUploadDataToGpu(); // upload any additional changes
+			if (this->mipmapsOutdated) // the filter was changed after the texture was uploaded
 			{
-				break;
+				hmutex::ScopeLock lockData(&this->asyncDataMutex);
+				this->_updateDeviceMipmaps();
 			}
-			lock.release();
-			hthread::sleep(0.001f);
+			return true;
 		}
+		return this->_upload(lock);
 	}
 
-	bool Texture::_ensureUploaded()
+	bool Texture::_isEvictable()
+	{
+		if (this->type == Type::RenderTarget || this->type == Type::External || this->locked)
+		{
+			return false;
+		}
+		if (TextureAtlas::has(this)) // the shared atlas page stays in VRAM anyway
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		if (this->deviceDataModified) // neither the file nor the CPU-side data contain what was changed on the GPU
+		{
+			return false;
+		}
+		if (this->filename != "")
+		{
+			return true;
+		}
+		return this->_hasData(); // textures created from memory can be uploaded again only if they keep their data
+	}
+
+	bool Texture::_tryReload()
 	{
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
 		if (this->uploaded)
 		{
-			this->_tryUploadDataToGpu(); // upload any additional changes
+			this->evicted = false;
 			return true;
 		}
-		return this->_upload(lock);
+		bool dataAvailable = (!this->asyncLoadQueued && this->dataAsync != NULL);
+		lock.release();
+		if (!dataAvailable)
+		{
+			lock.acquire(&this->asyncDataMutex);
+			dataAvailable = this->_hasData();
+			lock.release();
+		}
+		if (!dataAvailable)
+		{
+			this->loadAsync(LoadPriority::Visible);
+			return false;
+		}
+		if (!this->_ensureUploaded())
+		{
+			return false;
+		}
+		this->evicted = false;
+		return true;
+	}
+
+	bool Texture::_needsAsyncProxy()
+	{
+		return (this->proxyFilename != "" && this->proxyTexture == NULL && this->proxyImageAsync == NULL);
+	}
+
+	bool Texture::_loadAsyncProxy()
+	{
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		if (!this->asyncLoadQueued || this->asyncLoadDiscarded || this->uploaded || this->proxyFilename == "")
+		{
+			return true; // the full resolution load takes care of the state
+		}
+		hstr proxyFilename = this->proxyFilename;
+		lock.release();
+		hlog::write(logTag, "Loading async texture proxy: " + this->_getInternalName());
+		// proxies are tiny so they are decoded right away and always use a format that every render system supports
+		Image::Format nativeFormat = april::rendersys->getNativeTextureFormat(Image::Format::RGBA);
+		Image* image = (this->fromResource ? Image::createFromResource(proxyFilename, nativeFormat) : Image::createFromFile(proxyFilename, nativeFormat));
+		lock.acquire(&this->asyncLoadMutex);
+		if (image == NULL)
+		{
+			hlog::warn(logTag, "Failed to load async texture proxy: " + this->_getInternalName());
+			this->proxyFilename = ""; // prevents trying again
+			return true;
+		}
+		if (this->proxyImageAsync != NULL)
+		{
+			delete this->proxyImageAsync;
+		}
+		this->proxyImageAsync = image;
+		if (!this->asyncLoadQueued || this->asyncLoadDiscarded || !this->_isProxySufficient())
+		{
+			return true;
+		}
+		// the full resolution image is loaded once the texture is displayed larger
+		this->asyncLoadQueued = false;
+		return false;
+	}
+
+	bool Texture::_isProxySufficient() const
+	{
+		if (this->visibleDimension <= 0)
+		{
+			return false;
+		}
+		int dimension = 0;
+		if (this->proxyTexture != NULL)
+		{
+			dimension = hmax(this->proxyTexture->width, this->proxyTexture->height);
+		}
+		else if (this->proxyImageAsync != NULL)
+		{
+			dimension = hmax(this->proxyImageAsync->w, this->proxyImageAsync->h);
+		}
+		return (dimension > 0 && this->visibleDimension <= dimension);
+	}
+
+	bool Texture::_tryAsyncProxyUpload()
+	{
+		if (!april::rendersys->canUseLowLevelCalls())
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		if (this->proxyImageAsync == NULL)
+		{
+			return false;
+		}
+		Image* image = this->proxyImageAsync;
+		this->proxyImageAsync = NULL;
+		lock.release();
+		hlog::write(logTag, "Uploading async texture proxy: " + this->_getInternalName());
+		Texture* proxyTexture = april::rendersys->_deviceCreateTexture(this->fromResource);
+		if (!proxyTexture->_create(image->w, image->h, image->data, image->format, Type::Immutable))
+		{
+			delete proxyTexture;
+			delete image;
+			return false;
+		}
+		delete image;
+		proxyTexture->name = this->proxyFilename;
+		proxyTexture->filter = (this->_isMipmapFilter() ? Filter::Linear : this->filter);
+		proxyTexture->addressMode = this->addressMode;
+		proxyTexture->_ensureUploaded();
+		lock.acquire(&this->asyncLoadMutex);
+		if (this->proxyTexture != NULL)
+		{
+			this->proxyTexture->_deviceUnloadTexture();
+			delete this->proxyTexture;
+		}
+		this->proxyTexture = proxyTexture;
+		return true;
+	}
+
+	Texture* Texture::_useProxyTexture()
+	{
+		this->_tryAsyncProxyUpload(); // a proxy that was just loaded doesn't have to wait for TextureAsync::update()
+		if (this->proxyTexture == NULL)
+		{
+			return NULL;
+		}
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		// the full resolution data can be used right away, unless it's still being uploaded in tiles
+		if (this->uploaded || (!this->asyncLoadQueued && this->dataAsync != NULL && this->asyncUploadRow == 0 && !this->asyncUploadBackground))
+		{
+			return NULL;
+		}
+		hmutex::ScopeLock lockData(&this->asyncDataMutex);
+		if (this->_hasData())
+		{
+			return NULL;
+		}
+		lockData.release();
+		if (!this->_isProxySufficient())
+		{
+			this->_loadAsync(LoadPriority::Visible); // raises the priority if it's already queued
+		}
+		lock.release();
+		this->proxyTexture->_ensureUploaded();
+		return this->proxyTexture;
 	}
 
 	hstream* Texture::_prepareAsyncStream()
@@ -720,19 +1240,7 @@ namespace april
 		}
 		lock.release();
 		hstream* stream = new hstream();
-		if (this->fromResource)
-		{
-			hresource file;
-			file.open(this->filename);
-			stream->writeRaw(file);
-		}
-		else
-		{
-			hfile file;
-			file.open(this->filename);
-			stream->writeRaw(file);
-		}
-		stream->rewind();
+		this->_readSource(*stream);
 		lock.acquire(&this->asyncLoadMutex);
 		if (!this->asyncLoadQueued || this->asyncLoadDiscarded)
 		{
@@ -755,22 +1263,7 @@ namespace april
 		}
 		lock.release();
 		hlog::write(logTag, "Loading async texture: " + this->_getInternalName());
-		// must not call createFromStream() that converts automatically, because _processImageFormatSupport() needs to be called first
-		Image* image = Image::createFromStream(*(hsbase*)stream, "." + hfile::extensionOf(this->filename));
-		if (image != NULL)
-		{
-			image = this->_processImageFormatSupport(image);
-		}
-		if (image != NULL && this->format != Image::Format::Invalid && Image::needsConversion(image->format, this->format))
-		{
-			unsigned char* data = NULL;
-			if (Image::convertToFormat(image->w, image->h, image->data, image->format, &data, this->format))
-			{
-				delete[] image->data;
-				image->format = this->format;
-				image->data = data;
-			}
-		}
+		Image* image = this->_decodeImage(*stream);
 		if (image == NULL)
 		{
 			hlog::error(logTag, "Failed to load async texture: " + this->_getInternalName());
@@ -783,25 +1276,125 @@ namespace april
 		this->height = image->h;
 		this->format = image->format;
 		this->dataFormat = image->internalFormat;
-		if (this->dataFormat != 0)
+		if (this->dataFormat != 0 || this->format == Image::Format::Palette)
 		{
 			this->compressedSize = image->compressedSize;
 		}
 		int maxTextureSize = april::rendersys->getCaps().maxTextureSize;
 		if (maxTextureSize > 0 && (this->width > maxTextureSize || this->height > maxTextureSize))
 		{
-			hlog::warnf(logTag, "Texture size for '%s' is %d,%d while the reported system max texture size is %d!", this->_getInternalName().cStr(), this->width, this->height, maxTextureSize);
+			hlog::warnf(logTag, "Texture size for '%s' is %d,%d while the reported system max texture size is %d!", this->_getInternalName().cStr(), this->width, this->height, maxTextureSize);
+		}
+		lock.acquire(&this->asyncLoadMutex);
+		if (this->asyncLoadQueued && !this->asyncLoadDiscarded)
+		{
+			this->_assignFormat();
+			this->dataAsync = image->data;
+			image->data = NULL;
+		}
+		this->asyncLoadQueued = false;
+		this->asyncLoadDiscarded = false;
+		delete image;
+	}
+
+	void Texture::_readSource(hstream& stream)
+	{
+		// resources can only be mapped directly when they aren't packed into an archive
+		if (!this->fromResource || !hresource::hasZip())
+		{
+			hstr path = this->filename;
+			hstr archivePath = hresource::getMountedArchives().tryGet("", "");
+			if (this->fromResource && archivePath != "")
+			{
+				path = hrdir::joinPath(archivePath, this->filename);
+			}
+			if (readMappedFile(path, stream))
+			{
+				stream.rewind();
+				return;
+			}
+			stream.clear(); // a copy that was interrupted by a truncation can leave partial data
+		}
+		if (this->fromResource)
+		{
+			hresource file;
+			file.open(this->filename);
+			stream.writeRaw(file);
+		}
+		else
+		{
+			hfile file;
+			file.open(this->filename);
+			stream.writeRaw(file);
+		}
+		stream.rewind();
+	}
+
+	Image* Texture::_decodeImage(hstream& stream)
+	{
+		hstr extension = "." + hfile::extensionOf(this->filename);
+		unsigned long long hash = 0ULL;
+		int64_t sourceSize = 0LL;
+		int64_t sourceTime = 0LL;
+		// palette data is kept unexpanded so there's nothing to gain from caching it
+		bool cacheable = (april::getTextureCachePath() != "" && this->format != Image::Format::Palette);
+		if (cacheable)
+		{
+			// everything that changes the decoded result has to be part of the key
+			hstr key = april::rendersys->getName() + " " + this->format.getName() + " " + extension + hsprintf(" %d %g", this->loadMaxDimension, this->loadScale);
+			hash = TextureCache::calcHash(stream, key);
+			sourceSize = (int64_t)stream.size();
+			// resources don't have a modification time, their size and hash are checked only
+			sourceTime = (this->fromResource ? 0LL : getFileModificationTime(this->filename));
+			int width = 0;
+			int height = 0;
+			Image::Format format = Image::Format::Invalid;
+			unsigned char* data = NULL;
+			if (TextureCache::read(hash, sourceSize, sourceTime, &width, &height, &format, &data))
+			{
+				Image* image = Image::create(width, height, NULL, format);
+				image->data = data;
+				return image;
+			}
+		}
+		// must not call createFromStream() that converts automatically, because _processImageFormatSupport() needs to be called first
+		Image* image = NULL;
+		if (this->format == Image::Format::Palette) // palette data is never converted, it's only kept unexpanded
+		{
+			image = Image::createFromStream(stream, extension, this->format);
+			if (image != NULL)
+			{
+				image->downscale(this->_getLoadDownscaleDivisor(image->w, image->h));
+			}
+		}
+		else if (this->loadMaxDimension > 0 || this->loadScale < 1.0f)
+		{
+			image = Image::createFromStream(stream, extension, this->loadMaxDimension, this->loadScale);
+		}
+		else
+		{
+			image = Image::createFromStream(stream, extension);
+		}
+		if (image != NULL)
+		{
+			image = this->_processImageFormatSupport(image);
+		}
+		if (image != NULL && this->format != Image::Format::Invalid && Image::needsConversion(image->format, this->format))
+		{
+			unsigned char* data = NULL;
+			if (Image::convertToFormat(image->w, image->h, image->data, image->format, &data, this->format))
+			{
+				delete[] image->data;
+				image->format = this->format;
+				image->data = data;
+			}
 		}
-		lock.acquire(&this->asyncLoadMutex);
-		if (this->asyncLoadQueued && !this->asyncLoadDiscarded)
+		// compressed data is uploaded as it is, so caching it wouldn't skip any work
+		if (cacheable && image != NULL && image->data != NULL && image->internalFormat == 0 && image->format != Image::Format::Compressed && image->format != Image::Format::Palette)
 		{
-			this->_assignFormat();
-			this->dataAsync = image->data;
-			image->data = NULL;
+			TextureCache::write(hash, sourceSize, sourceTime, image->w, image->h, image->format, image->data);
 		}
-		this->asyncLoadQueued = false;
-		this->asyncLoadDiscarded = false;
-		delete image;
+		return image;
 	}
 
 	Image* Texture::_processImageFormatSupport(Image* image)
@@ -819,6 +1412,11 @@ namespace april
 					newImage = Image::create(image->w, image->h, april::Color::White, nativeFormat);
 					result = newImage->insertAlphaMap(image);
 				}
+				else if (image->format == Image::Format::Palette)
+				{
+					newImage = Image::create(image->w, image->h, NULL, nativeFormat);
+					result = Image::convertToFormat(image->w, image->h, image->data, image->format, &newImage->data, nativeFormat);
+				}
 				else
 				{
 					newImage = Image::create(image->w, image->h, april::Color::Clear, nativeFormat);
@@ -855,8 +1453,9 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		memset(this->data, 0, this->getByteSize());
-		this->dirty = true;
+		this->_addDirtyRect(0, 0, this->width, this->height);
 		return true;
 	}
 
@@ -870,6 +1469,7 @@ namespace april
 		}
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		if (this->data != NULL)
 		{
 			color = Image::getPixel(x, y, this->data, this->width, this->height, this->format);
@@ -891,8 +1491,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::setPixel(x, y, color, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(x, y, 1, 1);
+		}
 		return result;
 	}
 
@@ -906,6 +1510,7 @@ namespace april
 		}
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		if (this->data != NULL)
 		{
 			color = Image::getInterpolatedPixel(x, y, this->data, this->width, this->height, this->format);
@@ -931,8 +1536,12 @@ namespace april
 		}
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::fillRect(x, y, w, h, color, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(x, y, w, h);
+		}
 		return result;
 	}
 
@@ -950,8 +1559,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::blitRect(x, y, w, h, color, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(x, y, w, h);
+		}
 		return result;
 	}
 
@@ -964,6 +1577,7 @@ namespace april
 		}
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		return Image::convertToFormat(this->width, this->height, this->data, this->format, output, format, false);
 	}
 
@@ -976,6 +1590,7 @@ namespace april
 		}
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		unsigned char* data = NULL;
 		Image* image = NULL;
 		if (Image::convertToFormat(this->width, this->height, this->data, this->format, &data, format, false))
@@ -1000,8 +1615,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::write(sx, sy, sw, sh, dx, dy, srcData, srcWidth, srcHeight, srcFormat, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(dx, dy, sw, sh);
+		}
 		return result;
 	}
 
@@ -1024,6 +1643,7 @@ namespace april
 		}
 		texture->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&texture->asyncDataMutex);
+		texture->_unpackData();
 		return this->write(sx, sy, sw, sh, dx, dy, texture->data, texture->width, texture->height, texture->format);
 	}
 
@@ -1041,8 +1661,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::writeStretch(sx, sy, sw, sh, dx, dy, dw, dh, srcData, srcWidth, srcHeight, srcFormat, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(dx, dy, dw, dh);
+		}
 		return result;
 	}
 
@@ -1065,6 +1689,7 @@ namespace april
 		}
 		texture->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&texture->asyncDataMutex);
+		texture->_unpackData();
 		return this->writeStretch(sx, sy, sw, sh, dx, dy, dw, dh, texture->data, texture->width, texture->height, texture->format);
 	}
 
@@ -1082,8 +1707,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::blit(sx, sy, sw, sh, dx, dy, srcData, srcWidth, srcHeight, srcFormat, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(dx, dy, sw, sh);
+		}
 		return result;
 	}
 
@@ -1106,6 +1735,7 @@ namespace april
 		}
 		texture->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&texture->asyncDataMutex);
+		texture->_unpackData();
 		return this->blit(sx, sy, sw, sh, dx, dy, texture->data, texture->width, texture->height, texture->format);
 	}
 
@@ -1123,8 +1753,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::blitStretch(sx, sy, sw, sh, dx, dy, dw, dh, srcData, srcWidth, srcHeight, srcFormat, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(dx, dy, dw, dh);
+		}
 		return result;
 	}
 
@@ -1147,6 +1781,7 @@ namespace april
 		}
 		texture->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&texture->asyncDataMutex);
+		texture->_unpackData();
 		return this->blitStretch(sx, sy, sw, sh, dx, dy, dw, dh, texture->data, texture->width, texture->height, texture->format);
 	}
 
@@ -1164,8 +1799,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::rotateHue(x, y, w, h, degrees, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(x, y, w, h);
+		}
 		return result;
 	}
 
@@ -1183,8 +1822,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::saturate(x, y, w, h, factor, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(x, y, w, h);
+		}
 		return result;
 	}
 
@@ -1202,8 +1845,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::invert(x, y, w, h, this->data, this->width, this->height, this->format);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(x, y, w, h);
+		}
 		return result;
 	}
 
@@ -1221,8 +1868,12 @@ namespace april
 	{
 		this->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		this->_unpackData();
 		bool result = Image::insertAlphaMap(this->width, this->height, srcData, srcFormat, this->data, this->format, median, ambiguity);
-		this->dirty |= result;
+		if (result)
+		{
+			this->_addDirtyRect(0, 0, this->width, this->height);
+		}
 		return result;
 	}
 
@@ -1251,6 +1902,7 @@ namespace april
 		}
 		texture->waitForAsyncLoad();
 		hmutex::ScopeLock lock(&texture->asyncDataMutex);
+		texture->_unpackData();
 		return this->insertAlphaMap(texture->data, texture->format, median, ambiguity);
 	}
 
@@ -1441,16 +2093,417 @@ namespace april
 		if (this->dirty)
 		{
 			this->dirty = false;
-			this->_uploadDataToGpu(0, 0, this->width, this->height);
+			bool blockDataWasUploaded = this->blockDataUploaded;
+			this->_discardBlockData(); // the compressed data is outdated now
+			if (blockDataWasUploaded)
+			{
+				// the device storage is still in the compressed format and has to be specified again before raw data can be written into it
+				this->firstUpload = true;
+			}
+			int area = 0;
+			foreach (grecti, it, this->dirtyRects)
+			{
+				area += (*it).w * (*it).h;
+			}
+			// many separate uploads of a large area are slower than a single upload of the whole texture
+			bool fullUpload = (blockDataWasUploaded || this->dirtyRects.size() == 0 || area * 2 >= this->width * this->height);
+			if (this->deviceDataModified)
+			{
+				// the CPU-side data doesn't contain what was changed on the GPU, so only a change of the whole texture can replace it
+				fullUpload = (this->dirtyRects.size() == 1 && this->dirtyRects.first().w == this->width && this->dirtyRects.first().h == this->height);
+				if (fullUpload)
+				{
+					this->deviceDataModified = false;
+				}
+			}
+			if (fullUpload)
+			{
+				this->_uploadDataToGpu(0, 0, this->width, this->height);
+			}
+			else
+			{
+				foreach (grecti, it, this->dirtyRects)
+				{
+					this->_uploadDataToGpu((*it).x, (*it).y, (*it).w, (*it).h);
+				}
+			}
+			this->dirtyRects.clear();
+			if (this->mipmapsOutdated) // sub-rectangle uploads only mark the mipmaps as outdated
+			{
+				this->_updateDeviceMipmaps();
+			}
+			lock.release();
+			this->_queueCompression();
 			return true;
 		}
 		return false;
 	}
 
+	void Texture::_addDirtyRect(int x, int y, int w, int h)
+	{
+		int left = hmax(x, 0);
+		int top = hmax(y, 0);
+		int right = hmin(x + w, this->width);
+		int bottom = hmin(y + h, this->height);
+		if (left >= right || top >= bottom)
+		{
+			return;
+		}
+		this->dirty = true;
+		grecti rect(left, top, right - left, bottom - top);
+		grecti other;
+		int area = 0;
+		// rectangles are merged when their bounding rectangle doesn't add much unchanged area, e.g. pixels set next to each other
+		for_iter (i, 0, this->dirtyRects.size())
+		{
+			other = this->dirtyRects[i];
+			left = hmin(rect.x, other.x);
+			top = hmin(rect.y, other.y);
+			right = hmax(rect.x + rect.w, other.x + other.w);
+			bottom = hmax(rect.y + rect.h, other.y + other.h);
+			area = (right - left) * (bottom - top);
+			if (area * 4 <= (rect.w * rect.h + other.w * other.h) * 5)
+			{
+				rect = grecti(left, top, right - left, bottom - top);
+				this->dirtyRects.removeAt(i);
+				i = -1; // the merged rectangle could now be merged with previously checked ones
+			}
+		}
+		this->dirtyRects += rect;
+		if (this->dirtyRects.size() > MAX_DIRTY_RECTS)
+		{
+			left = this->width;
+			top = this->height;
+			right = 0;
+			bottom = 0;
+			foreach (grecti, it, this->dirtyRects)
+			{
+				left = hmin(left, (*it).x);
+				top = hmin(top, (*it).y);
+				right = hmax(right, (*it).x + (*it).w);
+				bottom = hmax(bottom, (*it).y + (*it).h);
+			}
+			this->dirtyRects.clear();
+			this->dirtyRects += grecti(left, top, right - left, bottom - top);
+		}
+	}
+
+	void Texture::setCompressible(bool value)
+	{
+		if (this->compressible == value)
+		{
+			return;
+		}
+		this->compressible = value;
+		if (!value)
+		{
+			TextureCompressor::dequeue(this);
+			return;
+		}
+		if (this->blockData == NULL && this->isUploaded())
+		{
+			this->_queueCompression();
+		}
+	}
+
+	void Texture::setDataPacking(bool value)
+	{
+		if (this->dataPacking == value)
+		{
+			return;
+		}
+		this->dataPacking = value;
+		if (!value)
+		{
+			TextureDataPacker::dequeue(this);
+			hmutex::ScopeLock lock(&this->asyncDataMutex);
+			this->_unpackData();
+		}
+	}
+
+	bool Texture::_hasData() const
+	{
+		return (this->data != NULL || this->packedData != NULL);
+	}
+
+	bool Texture::_applyPackedData(int version, unsigned char* packedData, int packedDataSize)
+	{
+		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		if (version != this->dataVersion || !this->dataPacking || this->locked || this->dirty || this->data == NULL || this->packedData != NULL)
+		{
+			lock.release();
+			delete[] packedData;
+			return false;
+		}
+		delete[] this->data;
+		this->data = NULL;
+		this->packedData = packedData;
+		this->packedDataSize = packedDataSize;
+		return true;
+	}
+
+	bool Texture::_unpackData()
+	{
+		if (april::rendersys != NULL)
+		{
+			this->lastDataAccessFrame = april::rendersys->residencyFrame;
+		}
+		++this->dataVersion; // the data could be changed after this
+		if (this->packedData == NULL)
+		{
+			return (this->data != NULL);
+		}
+		unsigned char* data = zlibDecompress(this->getByteSize(), this->packedDataSize, this->packedData);
+		if (data == NULL)
+		{
+			hlog::error(logTag, "Could not unpack texture data: " + this->_getInternalName());
+			return false;
+		}
+		delete[] this->packedData;
+		this->packedData = NULL;
+		this->packedDataSize = 0;
+		this->data = data;
+		return true;
+	}
+
+	bool Texture::_tryPackData()
+	{
+		if (!this->dataPacking || this->type != Type::Managed || this->locked || this->format == Image::Format::Compressed || this->format == Image::Format::Palette)
+		{
+			return false;
+		}
+		if (april::rendersys->residencyFrame - this->lastDataAccessFrame < DATA_PACKING_DELAY_FRAMES)
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		bool uploaded = this->uploaded;
+		lock.release();
+		if (!uploaded) // the data would have to be unpacked right away for the upload
+		{
+			return false;
+		}
+		lock.acquire(&this->asyncDataMutex);
+		if (this->data == NULL || this->dirty)
+		{
+			return false;
+		}
+		if (this->packedData != NULL)
+		{
+			return false;
+		}
+		this->lastDataAccessFrame = april::rendersys->residencyFrame; // a failed attempt isn't repeated right away
+		// deflate is too slow for the render thread, only the copy for the worker thread is made here
+		return TextureDataPacker::queue(this);
+	}
+
+	bool Texture::_findCompressionBlockFormat(Image::BlockFormat& blockFormat) const
+	{
+		if (this->width <= 0 || this->height <= 0 || this->format == Image::Format::Invalid ||
+			this->format == Image::Format::Compressed || this->format == Image::Format::Palette || this->_isMipmapFilter())
+		{
+			return false;
+		}
+		RenderSystem::Caps caps = april::rendersys->getCaps();
+		// compressed data can't be padded to power-of-two sizes like raw data
+		if (!caps.npotTextures && !caps.npotTexturesLimited && (hpotCeil(this->width) != this->width || hpotCeil(this->height) != this->height))
+		{
+			return false;
+		}
+		Image::Format nativeFormat = april::rendersys->getNativeTextureFormat(this->format);
+		bool alpha = (nativeFormat == Image::Format::RGBA || nativeFormat == Image::Format::ARGB || nativeFormat == Image::Format::BGRA ||
+			nativeFormat == Image::Format::ABGR || nativeFormat == Image::Format::Alpha);
+		harray<Image::BlockFormat> candidates;
+		if (alpha)
+		{
+			candidates += Image::BlockFormat::Etc2Rgba;
+			candidates += Image::BlockFormat::Bc3;
+		}
+		else
+		{
+			candidates += Image::BlockFormat::Etc2Rgb;
+			candidates += Image::BlockFormat::Bc1;
+		}
+		foreach (Image::BlockFormat, it, candidates)
+		{
+			if (caps.blockFormats.has(*it))
+			{
+				blockFormat = (*it);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool Texture::_queueCompression()
+	{
+		// only textures that keep their raw data in RAM can be compressed, because the data has to remain available for the encoder
+		if (!this->compressible || this->type == Type::RenderTarget || this->type == Type::External || this->data == NULL)
+		{
+			return false;
+		}
+		Image::BlockFormat blockFormat;
+		if (!this->_findCompressionBlockFormat(blockFormat))
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		if (this->data == NULL || this->dirty || this->deviceDataModified) // block data is created from the CPU-side data
+		{
+			return false;
+		}
+		return TextureCompressor::queue(this, blockFormat);
+	}
+
+	void Texture::_discardBlockData()
+	{
+		++this->compressionVersion; // pending compression results are outdated now
+		TextureCompressor::dequeue(this);
+		if (this->blockData != NULL)
+		{
+			delete[] this->blockData;
+			this->blockData = NULL;
+		}
+		this->blockDataSize = 0;
+		this->blockDataUploaded = false;
+	}
+
+	bool Texture::_applyBlockData(int version, Image::BlockFormat blockFormat, unsigned char* blockData, int blockDataSize)
+	{
+		hmutex::ScopeLock lock(&this->asyncDataMutex);
+		if (version != this->compressionVersion || this->dirty || !this->compressible)
+		{
+			lock.release();
+			delete[] blockData;
+			return false;
+		}
+		if (this->blockData != NULL)
+		{
+			delete[] this->blockData;
+		}
+		this->blockData = blockData;
+		this->blockDataSize = blockDataSize;
+		this->blockFormat = blockFormat;
+		lock.release();
+		if (this->isUploaded())
+		{
+			if (!this->_uploadBlockDataToGpu())
+			{
+				hlog::warn(logTag, "Could not upload block compressed data, using uncompressed data: " + this->_getInternalName());
+				delete[] this->blockData;
+				this->blockData = NULL;
+				this->blockDataSize = 0;
+				return false;
+			}
+			april::rendersys->statCurrentFrameTextureUploadBytes += (int64_t)this->blockDataSize;
+		}
+		return true;
+	}
+
+	bool Texture::_uploadBlockDataToGpu()
+	{
+		return false;
+	}
+
+	void Texture::setFilter(Filter value)
+	{
+		if (this->filter != value)
+		{
+			this->filter = value;
+			if (this->_isMipmapFilter() && this->mipmapLevels <= 1)
+			{
+				this->mipmapsOutdated = true; // mipmaps are only created once they are needed
+			}
+			this->_removeFromAtlas(); // the page's filter doesn't apply anymore
+		}
+	}
+
+	void Texture::setAddressMode(AddressMode value)
+	{
+		if (this->addressMode != value)
+		{
+			this->addressMode = value;
+			this->_removeFromAtlas(); // pages always clamp to the texture's region
+		}
+	}
+
+	void Texture::_removeFromAtlas()
+	{
+		if (!TextureAtlas::has(this))
+		{
+			return;
+		}
+		TextureAtlas::remove(this);
+		// a packed texture doesn't have a device texture, so it's simply uploaded again on its next use and packed only if it's still eligible
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		this->uploaded = false;
+	}
+
+	void Texture::setVisibleDimension(int value)
+	{
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		this->visibleDimension = value;
+	}
+
+	void Texture::setAnisotropy(float value)
+	{
+		this->anisotropy = hmax(value, 1.0f);
+	}
+
+	bool Texture::_isMipmapFilter() const
+	{
+		return (this->filter == Filter::MipNearest || this->filter == Filter::MipLinear);
+	}
+
+	Texture::Filter Texture::_getRenderFilter() const
+	{
+		if (this->_isMipmapFilter() && this->mipmapLevels <= 1)
+		{
+			return Filter::Linear;
+		}
+		return this->filter;
+	}
+
+	void Texture::_updateMipmaps(unsigned char* data, Image::Format format)
+	{
+		this->mipmapsOutdated = false;
+		if (!this->_isMipmapFilter() || this->type == Type::RenderTarget || this->type == Type::External || this->blockDataUploaded ||
+			this->format == Image::Format::Compressed || this->format == Image::Format::Palette)
+		{
+			this->mipmapLevels = 1;
+			return;
+		}
+		if (!this->_deviceCreateMipmaps(data, format))
+		{
+			this->mipmapLevels = 1;
+		}
+	}
+
+	void Texture::_updateDeviceMipmaps()
+	{
+		if (this->deviceDataModified) // the mipmaps have to be created from the GPU content
+		{
+			this->_updateMipmaps(NULL, this->format);
+			return;
+		}
+		this->_unpackData();
+		this->_updateMipmaps(this->data, this->format);
+	}
+
+	bool Texture::_deviceCreateMipmaps(unsigned char* data, Image::Format format)
+	{
+		return false;
+	}
+
 	bool Texture::_uploadDataToGpu(int x, int y, int w, int h)
 	{
-		if ((!Image::needsConversion(this->format, april::rendersys->getNativeTextureFormat(this->format)) &&
-			this->_uploadToGpu(x, y, w, h, x, y, this->data, this->width, this->height, this->format)) || this->dirty)
+		if (!Image::needsConversion(this->format, april::rendersys->getNativeTextureFormat(this->format)) &&
+			this->_uploadToGpu(x, y, w, h, x, y, this->data, this->width, this->height, this->format))
+		{
+			april::rendersys->statCurrentFrameTextureUploadBytes += (int64_t)w * h * this->format.getBpp();
+			return true;
+		}
+		if (this->dirty)
 		{
 			return true;
 		}
@@ -1461,6 +2514,10 @@ namespace april
 		}
 		bool result = Image::write(x, y, w, h, lock.x, lock.y, this->data, this->width, this->height, this->format, lock.data, lock.dataWidth, lock.dataHeight, lock.format);
 		this->_unlockSystem(lock, true);
+		if (result)
+		{
+			april::rendersys->statCurrentFrameTextureUploadBytes += (int64_t)w * h * lock.format.getBpp();
+		}
 		return result;
 	}
 
@@ -6,32 +6,253 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 #include <gtypes/Rectangle.h>
 #include <gtypes/Vector2.h>
 #include <hltypes/harray.h>
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hmap.h>
-#include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
 #include "april.h"
 #include "Platform.h"
+#include "RenderSystem.h"
 #include "Texture.h"
 #include "TextureAsync.h"
+#include "TextureCompressor.h"
+#include "TextureDataPacker.h"
+#include "TextureLoadGroup.h"
+#include "Timer.h"
+
+#define PRIORITY_IMMEDIATE 3
 
 namespace april
 {
 	extern SystemInfo info;
 
-	harray<Texture*> TextureAsync::textures;
-	harray<hstream*> TextureAsync::streams;
-	hmutex TextureAsync::queueMutex;
+	TextureAsync::Entry::Entry()
+	{
+		this->texture = NULL;
+		this->stream = NULL;
+		this->priority = 0;
+		this->deadline = 0LL;
+		this->order = 0LL;
+		this->proxy = false;
+	}
+
+	TextureAsync::Entry::Entry(Texture* texture, int priority, int64_t deadline)
+	{
+		this->texture = texture;
+		this->stream = NULL;
+		this->priority = priority;
+		this->deadline = deadline;
+		this->order = 0LL;
+		this->proxy = false;
+	}
+
+	bool TextureAsync::Entry::isBefore(const Entry& other) const
+	{
+		if (this->proxy != other.proxy) // low resolution proxies of all textures are loaded before any full resolution image
+		{
+			return this->proxy;
+		}
+		if (this->priority != other.priority)
+		{
+			return (this->priority > other.priority);
+		}
+		if (this->deadline != other.deadline)
+		{
+			// entries without a deadline come after all entries with a deadline
+			if (this->deadline <= 0LL || other.deadline <= 0LL)
+			{
+				return (this->deadline > 0LL);
+			}
+			return (this->deadline < other.deadline);
+		}
+		return (this->order < other.order);
+	}
+
+	bool TextureAsync::Entry::raise(int priority, int64_t deadline)
+	{
+		bool result = false;
+		if (priority > this->priority)
+		{
+			this->priority = priority;
+			result = true;
+		}
+		if (deadline > 0LL && (this->deadline <= 0LL || deadline < this->deadline))
+		{
+			this->deadline = deadline;
+			result = true;
+		}
+		return result;
+	}
+
+	TextureAsync::Callback::Callback()
+	{
+		this->texture = NULL;
+		this->function = NULL;
+		this->userData = NULL;
+		this->success = false;
+	}
+
+	TextureAsync::Callback::Callback(Texture* texture, void (*function)(Texture*, bool, void*), void* userData)
+	{
+		this->texture = texture;
+		this->function = function;
+		this->userData = userData;
+		this->success = false;
+	}
+
+	int TextureAsync::Queue::size() const
+	{
+		return this->entries.size();
+	}
+
+	bool TextureAsync::Queue::has(Texture* texture) const
+	{
+		return this->indices.hasKey(texture);
+	}
 
-	hthread TextureAsync::readerThread(&TextureAsync::_read, "APRIL async loader");
-	bool TextureAsync::readerRunning = false;
+	void TextureAsync::Queue::add(const Entry& entry)
+	{
+		this->entries += entry;
+		this->indices[entry.texture] = this->entries.size() - 1;
+		this->_siftUp(this->entries.size() - 1);
+	}
+
+	bool TextureAsync::Queue::raise(Texture* texture, int priority, int64_t deadline)
+	{
+		int index = this->indices.tryGet(texture, -1);
+		if (index < 0)
+		{
+			return false;
+		}
+		if (this->entries[index].raise(priority, deadline))
+		{
+			this->_siftUp(index); // a raised entry can only move towards the front
+		}
+		return true;
+	}
+
+	bool TextureAsync::Queue::remove(Texture* texture, Entry* entry)
+	{
+		int index = this->indices.tryGet(texture, -1);
+		if (index < 0)
+		{
+			return false;
+		}
+		if (entry != NULL)
+		{
+			*entry = this->entries[index];
+		}
+		this->_removeAt(index);
+		return true;
+	}
+
+	TextureAsync::Entry TextureAsync::Queue::removeFirst()
+	{
+		Entry entry = this->entries.first();
+		this->_removeAt(0);
+		return entry;
+	}
+
+	void TextureAsync::Queue::clear()
+	{
+		this->entries.clear();
+		this->indices.clear();
+	}
+
+	void TextureAsync::Queue::_set(int index, const Entry& entry)
+	{
+		this->entries[index] = entry;
+		this->indices[entry.texture] = index;
+	}
+
+	void TextureAsync::Queue::_removeAt(int index)
+	{
+		this->indices.removeKey(this->entries[index].texture);
+		Entry last = this->entries.removeLast();
+		if (index < this->entries.size()) // the last entry fills the gap
+		{
+			this->_set(index, last);
+			this->_siftDown(index);
+			this->_siftUp(index);
+		}
+	}
+
+	void TextureAsync::Queue::_siftUp(int index)
+	{
+		Entry entry = this->entries[index];
+		int parent = 0;
+		while (index > 0)
+		{
+			parent = (index - 1) / 2;
+			if (!entry.isBefore(this->entries[parent]))
+			{
+				break;
+			}
+			this->_set(index, this->entries[parent]);
+			index = parent;
+		}
+		this->_set(index, entry);
+	}
+
+	void TextureAsync::Queue::_siftDown(int index)
+	{
+		Entry entry = this->entries[index];
+		int size = this->entries.size();
+		int child = 0;
+		while (true)
+		{
+			child = index * 2 + 1;
+			if (child >= size)
+			{
+				break;
+			}
+			if (child + 1 < size && this->entries[child + 1].isBefore(this->entries[child]))
+			{
+				++child;
+			}
+			if (!this->entries[child].isBefore(entry))
+			{
+				break;
+			}
+			this->_set(index, this->entries[child]);
+			index = child;
+		}
+		this->_set(index, entry);
+	}
+
+	TextureAsync::Queue TextureAsync::readQueue;
+	TextureAsync::Queue TextureAsync::decodeQueue;
+	hmap<Texture*, TextureAsync::Entry> TextureAsync::activeEntries;
+	int64_t TextureAsync::nextOrder = 0LL;
+	std::mutex TextureAsync::queueMutex;
+	std::condition_variable TextureAsync::readCondition;
+	std::condition_variable TextureAsync::decodeCondition;
+	std::condition_variable TextureAsync::finishedCondition;
+	bool TextureAsync::stopping = false;
+
+	harray<hthread*> TextureAsync::readerThreads;
+	int TextureAsync::readerThreadCount = 0;
+	int TextureAsync::readingCount = 0;
 
 	harray<hthread*> TextureAsync::decoderThreads;
+	int TextureAsync::decoderThreadCount = 0;
+
+	Timer TextureAsync::uploadTimer;
+
+	harray<TextureAsync::Callback> TextureAsync::callbacks;
+	harray<TextureAsync::Callback> TextureAsync::readyCallbacks;
+	harray<TextureLoadGroup*> TextureAsync::groups;
+	std::mutex TextureAsync::callbackMutex;
+	std::condition_variable TextureAsync::loadedCondition;
 
 	void TextureAsync::update()
 	{
@@ -40,22 +261,63 @@ namespace april
 			return;
 		}
 		TextureAsync::_updateThreads();
+		harray<Texture*> textures = april::rendersys->getTextures();
+		// proxies are tiny so they don't count towards the upload limit
+		foreach (Texture*, it, textures)
+		{
+			(*it)->_tryAsyncProxyUpload();
+		}
 		// upload all ready textures to the GPU
 		int maxCount = april::getMaxAsyncTextureUploadsPerFrame();
-		int count = 0;
-		harray<Texture*> textures = april::rendersys->getTextures();
+		int64_t maxBytes = april::getAsyncTextureUploadBytesPerFrame();
+		float maxTime = april::getAsyncTextureUploadTimePerFrame();
+		int64_t tileSize = 0LL; // without a byte or time limit every texture is uploaded at once
+		if (maxBytes > 0LL || maxTime > 0.0f)
+		{
+			tileSize = (int64_t)hmax(april::getAsyncTextureUploadTileSize(), 1);
+		}
+		// textures with a tiled upload in progress are finished first so their async data can be released sooner
+		harray<Texture*> uploadTextures;
+		harray<Texture*> waitingTextures;
 		foreach (Texture*, it, textures)
 		{
+			if ((*it)->asyncUploadRow > 0)
+			{
+				uploadTextures += (*it);
+			}
+			else
+			{
+				waitingTextures += (*it);
+			}
+		}
+		uploadTextures += waitingTextures;
+		int count = 0;
+		int64_t bytes = 0LL;
+		int64_t startBytes = 0LL;
+		float time = 0.0f;
+		TextureAsync::uploadTimer.update();
+		foreach (Texture*, it, uploadTextures)
+		{
+			startBytes = april::rendersys->getStatCurrentFrameTextureUploadBytes();
 			// only async on-demand textures shouldn't be loaded, this is checked in _isAsyncUploadQueued()
-			if ((*it)->_tryAsyncFinalUpload())
+			if ((*it)->_tryAsyncFinalUpload(maxBytes > 0LL ? hclamp(maxBytes - bytes, (int64_t)1, tileSize) : tileSize))
 			{
+				bytes += april::rendersys->getStatCurrentFrameTextureUploadBytes() - startBytes;
+				time += (float)TextureAsync::uploadTimer.diff();
 				++count;
 				if (maxCount > 0 && count >= maxCount)
 				{
 					break; // only 'maxCount' textures per frame!
 				}
+				if ((maxBytes > 0LL && bytes >= maxBytes) || (maxTime > 0.0f && time >= maxTime))
+				{
+					break; // the rest has to wait for the next frame, large textures continue where their last tile ended
+				}
 			}
 		}
+		TextureCompressor::update(); // finished block compression is applied on the main thread as well
+		TextureDataPacker::update();
+		TextureAsync::_updateCallbacks();
 	}
 
 	void TextureAsync::updateSingleTexture(Texture* texture)
@@ -66,184 +328,449 @@ namespace april
 		}
 		TextureAsync::_updateThreads();
 		texture->_tryAsyncFinalUpload();
+		TextureAsync::_updateCallbacks();
 	}
 
 	void TextureAsync::_updateThreads()
 	{
-		hmutex::ScopeLock lock(&TextureAsync::queueMutex);
-		if (TextureAsync::readerRunning && !TextureAsync::readerThread.isRunning())
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		if (TextureAsync::stopping)
+		{
+			return;
+		}
+		// several readers keep multiple reads in flight so fast drives aren't limited to one request at a time
+		int count = hmax(april::getAsyncTextureReaderThreads(), 1);
+		bool shrinking = (count < TextureAsync::readerThreadCount);
+		TextureAsync::readerThreadCount = count;
+		if (shrinking)
+		{
+			TextureAsync::readCondition.notify_all(); // surplus readers exit on their own
+		}
+		TextureAsync::_updatePool(TextureAsync::readerThreads, count, &TextureAsync::_read, "APRIL async reader");
+		count = april::getAsyncTextureDecoderThreads();
+		if (count <= 0)
+		{
+			count = april::getSystemInfo().cpuCores;
+		}
+		count = hmax(count, 1);
+		shrinking = (count < TextureAsync::decoderThreadCount);
+		TextureAsync::decoderThreadCount = count;
+		if (shrinking)
+		{
+			TextureAsync::decodeCondition.notify_all(); // surplus decoders exit on their own
+		}
+		TextureAsync::_updatePool(TextureAsync::decoderThreads, count, &TextureAsync::_decode, "APRIL async decoder");
+	}
+
+	void TextureAsync::_updatePool(harray<hthread*>& threads, int count, void (*function)(hthread*), chstr name)
+	{
+		// the threads are persistent, only threads that exited after the pool was made smaller are cleaned up
+		hthread* thread = NULL;
+		for_iter (i, 0, threads.size())
 		{
-			TextureAsync::readerThread.join();
-			TextureAsync::readerRunning = false;
+			if (!threads[i]->isRunning())
+			{
+				thread = threads.removeAt(i);
+				thread->join();
+				delete thread;
+				--i;
+			}
 		}
-		if (!TextureAsync::readerRunning && TextureAsync::textures.size() > 0) // new textures got queued in the meantime
+		while (threads.size() < count)
 		{
-			TextureAsync::readerRunning = true;
-			TextureAsync::readerThread.start();
+			thread = new hthread(function, name);
+			threads += thread;
+			thread->start();
 		}
-		lock.release();
 	}
 
-	bool TextureAsync::queueLoad(Texture* texture)
+	int TextureAsync::_getPriorityValue(Texture::LoadPriority priority)
 	{
-		hmutex::ScopeLock lock(&TextureAsync::queueMutex);
-		if (TextureAsync::textures.has(texture))
+		if (priority == Texture::LoadPriority::Prefetch)
+		{
+			return 0;
+		}
+		if (priority == Texture::LoadPriority::Visible)
+		{
+			return 2;
+		}
+		return 1;
+	}
+
+	int64_t TextureAsync::_getDeadlineTime(float deadline)
+	{
+		return (deadline > 0.0f ? htickCount() + (int64_t)(deadline * 1000.0f) : 0LL);
+	}
+
+	bool TextureAsync::queueLoad(Texture* texture, Texture::LoadPriority priority, float deadline, bool proxy)
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		if (TextureAsync::readQueue.has(texture) || TextureAsync::decodeQueue.has(texture))
 		{
 			return false;
 		}
-		TextureAsync::textures += texture;
-		if (!TextureAsync::readerRunning)
+		Entry entry(texture, TextureAsync::_getPriorityValue(priority), TextureAsync::_getDeadlineTime(deadline));
+		entry.order = TextureAsync::nextOrder; // keeps FIFO order within the same priority and deadline
+		entry.proxy = proxy;
+		++TextureAsync::nextOrder;
+		TextureAsync::readQueue.add(entry);
+		bool started = (TextureAsync::readerThreads.size() > 0);
+		lock.unlock();
+		if (!started)
 		{
-			TextureAsync::readerRunning = true;
-			TextureAsync::readerThread.start();
+			TextureAsync::_updateThreads();
 		}
+		TextureAsync::readCondition.notify_one();
 		return true;
 	}
 
+	bool TextureAsync::updateLoad(Texture* texture, Texture::LoadPriority priority, float deadline)
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		return TextureAsync::_raiseLoad(texture, TextureAsync::_getPriorityValue(priority), TextureAsync::_getDeadlineTime(deadline));
+	}
+
 	bool TextureAsync::prioritizeLoad(Texture* texture)
 	{
-		hmutex::ScopeLock lock(&TextureAsync::queueMutex);
-		if (!TextureAsync::textures.has(texture))
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		return TextureAsync::_raiseLoad(texture, PRIORITY_IMMEDIATE, 0LL);
+	}
+
+	bool TextureAsync::_raiseLoad(Texture* texture, int priority, int64_t deadline)
+	{
+		if (TextureAsync::readQueue.raise(texture, priority, deadline) || TextureAsync::decodeQueue.raise(texture, priority, deadline))
 		{
-			return false;
+			return true;
 		}
-		int index = TextureAsync::textures.indexOf(texture);
-		if (index >= TextureAsync::streams.size()) // if not loaded from disk yet
+		if (TextureAsync::activeEntries.hasKey(texture)) // the raised priority is carried over into the decode queue once it was read
 		{
-			if (index > TextureAsync::streams.size()) // if not already at the front
+			TextureAsync::activeEntries[texture].raise(priority, deadline);
+			return true;
+		}
+		return false;
+	}
+
+	bool TextureAsync::cancelLoad(Texture* texture)
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		if (TextureAsync::readQueue.remove(texture))
+		{
+			TextureAsync::finishedCondition.notify_all();
+			return true;
+		}
+		Entry entry;
+		if (TextureAsync::decodeQueue.remove(texture, &entry))
+		{
+			delete entry.stream;
+			TextureAsync::readCondition.notify_one(); // there's room for more read data now
+			TextureAsync::finishedCondition.notify_all();
+			return true;
+		}
+		return false;
+	}
+
+	bool TextureAsync::isRunning()
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		return (TextureAsync::readQueue.size() > 0 || TextureAsync::decodeQueue.size() > 0 || TextureAsync::activeEntries.size() > 0);
+	}
+
+	void TextureAsync::waitForLoad(Texture* texture)
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		while (!TextureAsync::stopping && (TextureAsync::readQueue.has(texture) || TextureAsync::decodeQueue.has(texture) || TextureAsync::activeEntries.hasKey(texture)))
+		{
+			TextureAsync::finishedCondition.wait(lock);
+		}
+	}
+
+	bool TextureAsync::waitForUpload(Texture* texture, float timeout)
+	{
+		std::chrono::steady_clock::time_point endTime = TextureAsync::_getWaitEndTime(timeout);
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		// uploads happen during updates which notify waiting threads, so this doesn't need to poll
+		while (!texture->_isAsyncLoadFinished())
+		{
+			if (!TextureAsync::_wait(lock, TextureAsync::loadedCondition, timeout, endTime))
 			{
-				TextureAsync::textures.removeAt(index);
-				TextureAsync::textures.insertAt(TextureAsync::streams.size(), texture);
+				return texture->_isAsyncLoadFinished();
 			}
 		}
-		else if (index > 0) // if data was already loaded in RAM, but not decoded and not already at the front
+		return true;
+	}
+
+	bool TextureAsync::waitForIdle(float timeout)
+	{
+		std::chrono::steady_clock::time_point endTime = TextureAsync::_getWaitEndTime(timeout);
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		while (!TextureAsync::stopping && (TextureAsync::readQueue.size() > 0 || TextureAsync::decodeQueue.size() > 0 || TextureAsync::activeEntries.size() > 0))
 		{
-			TextureAsync::textures.removeAt(index);
-			TextureAsync::textures.addFirst(texture);
-			TextureAsync::streams.addFirst(TextureAsync::streams.removeAt(index));
+			if (!TextureAsync::_wait(lock, TextureAsync::finishedCondition, timeout, endTime))
+			{
+				break;
+			}
 		}
-		return true;
+		return (TextureAsync::readQueue.size() == 0 && TextureAsync::decodeQueue.size() == 0 && TextureAsync::activeEntries.size() == 0);
 	}
 
-	bool TextureAsync::isRunning()
+	std::chrono::steady_clock::time_point TextureAsync::_getWaitEndTime(float timeout)
 	{
-		hmutex::ScopeLock lock(&TextureAsync::queueMutex);
-		return TextureAsync::readerRunning;
+		return (std::chrono::steady_clock::now() + std::chrono::microseconds((int64_t)(hmax(timeout, 0.0f) * 1000000.0f)));
 	}
 
-	void TextureAsync::_read(hthread* thread)
+	bool TextureAsync::_wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, float timeout, const std::chrono::steady_clock::time_point& endTime)
 	{
-		Texture* texture = NULL;
-		hstream* stream = NULL;
-		hthread* decoderThread = NULL;
-		int index = 0;
-		int size = 0;
-		bool running = true;
-		hmutex::ScopeLock lock;
-		int maxWaitingCount = 0;
-		SystemInfo info = getSystemInfo();
-		while (running)
+		if (timeout <= 0.0f)
+		{
+			condition.wait(lock);
+			return true;
+		}
+		return (condition.wait_until(lock, endTime) == std::cv_status::no_timeout);
+	}
+
+	void TextureAsync::addCallback(Texture* texture, void (*function)(Texture*, bool, void*), void* userData)
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		TextureAsync::callbacks += Callback(texture, function, userData);
+	}
+
+	void TextureAsync::removeCallbacks(Texture* texture)
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		for_iter (i, 0, TextureAsync::callbacks.size())
 		{
-			running = false;
-			maxWaitingCount = getMaxWaitingAsyncTextures(); // keep this value up to date in every iteration
-			// check for new queued textures
-			lock.acquire(&TextureAsync::queueMutex);
-			if (TextureAsync::textures.size() > TextureAsync::streams.size())
+			if (TextureAsync::callbacks[i].texture == texture)
 			{
-				running = true;
-				if (maxWaitingCount <= 0 || TextureAsync::streams.size() < maxWaitingCount)
-				{
-					texture = TextureAsync::textures[TextureAsync::streams.size()];
-					lock.release();
-					stream = texture->_prepareAsyncStream();
-					lock.acquire(&TextureAsync::queueMutex);
-					index = TextureAsync::textures.indexOf(texture); // it's possible that the queue was rearranged in the meantime
-					if (stream != NULL)
-					{
-						if (index >= TextureAsync::streams.size())
-						{
-							if (index > TextureAsync::streams.size()) // if texture was moved towards the back of the queue
-							{
-								// put it back to the current decoder position
-								TextureAsync::textures.removeAt(index);
-								TextureAsync::textures.insertAt(TextureAsync::streams.size(), texture);
-							}
-							TextureAsync::streams += stream;
-						}
-						else // the texture was moved forward in the queue
-						{
-							TextureAsync::streams.insertAt(index, stream);
-						}
-					}
-					else // it was canceled
-					{
-						TextureAsync::textures.removeAt(index);
-					}
-				}
-				else
-				{
-					lock.release();
-					hthread::sleep(1.0f);
-					lock.acquire(&TextureAsync::queueMutex);
-				}
+				TextureAsync::callbacks.removeAt(i);
+				--i;
+			}
+		}
+		for_iter (i, 0, TextureAsync::readyCallbacks.size())
+		{
+			if (TextureAsync::readyCallbacks[i].texture == texture)
+			{
+				TextureAsync::readyCallbacks.removeAt(i);
+				--i;
 			}
-			size = TextureAsync::streams.size();
-			lock.release();
-			// create new worker threads if needed
-			if (size > 0)
+		}
+		// groups must not wait for a texture that doesn't exist anymore
+		foreach (TextureLoadGroup*, it, TextureAsync::groups)
+		{
+			if ((*it)->textures.has(texture))
+			{
+				(*it)->textures -= texture;
+			}
+			if ((*it)->pendingTextures.has(texture))
+			{
+				(*it)->pendingTextures -= texture;
+			}
+		}
+	}
+
+	void TextureAsync::_updateCallbacks()
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		for_iter (i, 0, TextureAsync::callbacks.size())
+		{
+			if (TextureAsync::callbacks[i].texture->_isAsyncLoadFinished())
+			{
+				TextureAsync::callbacks[i].success = TextureAsync::callbacks[i].texture->isUploaded();
+				TextureAsync::readyCallbacks += TextureAsync::callbacks.removeAt(i);
+				--i;
+			}
+		}
+		TextureLoadGroup* group = NULL;
+		foreach (TextureLoadGroup*, it, TextureAsync::groups)
+		{
+			group = (*it);
+			if (group->completed)
 			{
-				running = true;
-				size = hmin(size, info.cpuCores) - TextureAsync::decoderThreads.size();
-				for_iter (i, 0, size)
+				continue;
+			}
+			for_iter (i, 0, group->pendingTextures.size())
+			{
+				if (group->pendingTextures[i]->_isAsyncLoadFinished())
 				{
-					decoderThread = new hthread(&TextureAsync::_decode, "APRIL async decoder");
-					TextureAsync::decoderThreads += decoderThread;
-					decoderThread->start();
+					group->pendingTextures.removeAt(i);
+					--i;
 				}
 			}
-			// check current worker threads' status
-			if (TextureAsync::decoderThreads.size() > 0)
+			if (group->pendingTextures.size() == 0)
 			{
-				running = true;
-				for_iter (i, 0, TextureAsync::decoderThreads.size())
+				group->completed = true;
+				group->successful = true;
+				foreach (Texture*, it2, group->textures)
 				{
-					if (!TextureAsync::decoderThreads[i]->isRunning())
+					if (!(*it2)->isUploaded())
 					{
-						decoderThread = TextureAsync::decoderThreads.removeAt(i);
-						decoderThread->join();
-						delete decoderThread;
-						--i;
+						group->successful = false;
+						break;
 					}
 				}
+				group->callbackQueued = (group->callback != NULL);
+			}
+		}
+		// textures can also be uploaded while rendering so waiting threads check again after every update
+		TextureAsync::loadedCondition.notify_all();
+		// callbacks are called without the lock and one by one so they can load, wait for or destroy textures and groups
+		Callback callback;
+		void (*groupFunction)(TextureLoadGroup*, bool, void*) = NULL;
+		void* userData = NULL;
+		bool success = false;
+		while (true)
+		{
+			if (TextureAsync::readyCallbacks.size() > 0)
+			{
+				callback = TextureAsync::readyCallbacks.removeFirst();
+				lock.unlock();
+				(*callback.function)(callback.texture, callback.success, callback.userData);
+				lock.lock();
+				continue;
+			}
+			group = NULL;
+			foreach (TextureLoadGroup*, it, TextureAsync::groups)
+			{
+				if ((*it)->callbackQueued)
+				{
+					group = (*it);
+					break;
+				}
+			}
+			if (group == NULL)
+			{
+				break;
 			}
+			group->callbackQueued = false;
+			groupFunction = group->callback;
+			userData = group->userData;
+			success = group->successful;
+			lock.unlock();
+			(*groupFunction)(group, success, userData);
+			lock.lock();
 		}
 	}
 
-	void TextureAsync::_decode(hthread* thread)
+	void TextureAsync::destroy()
 	{
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		TextureAsync::stopping = true;
+		lock.unlock();
+		TextureAsync::readCondition.notify_all();
+		TextureAsync::decodeCondition.notify_all();
+		TextureAsync::finishedCondition.notify_all();
+		// threads don't need the lock to finish, it's safe to join them here
+		foreach (hthread*, it, TextureAsync::readerThreads)
+		{
+			(*it)->join();
+			delete (*it);
+		}
+		foreach (hthread*, it, TextureAsync::decoderThreads)
+		{
+			(*it)->join();
+			delete (*it);
+		}
+		lock.lock();
+		TextureAsync::readerThreads.clear();
+		TextureAsync::decoderThreads.clear();
+		while (TextureAsync::decodeQueue.size() > 0)
+		{
+			delete TextureAsync::decodeQueue.removeFirst().stream;
+		}
+		TextureAsync::readQueue.clear();
+		TextureAsync::activeEntries.clear();
+		TextureAsync::readingCount = 0;
+		TextureAsync::stopping = false; // threads can be started again on demand
+	}
+
+	void TextureAsync::_read(hthread* thread)
+	{
+		Entry entry;
 		Texture* texture = NULL;
 		hstream* stream = NULL;
-		hmutex::ScopeLock lock(&TextureAsync::queueMutex);
-		while (TextureAsync::streams.size() > 0)
+		bool proxyOnly = false;
+		int maxWaitingCount = 0;
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		while (true)
 		{
-			if (TextureAsync::textures.size() == 0) // something went terribly, terribly wrong, just abort and delete the remaining streams
+			// keep this value up to date in every iteration, it limits how much read data is waiting for decoding, reads in flight included
+			maxWaitingCount = april::getMaxWaitingAsyncTextures();
+			// surplus readers exit when the pool is made smaller
+			while (!TextureAsync::stopping && TextureAsync::readerThreads.indexOf(thread) < TextureAsync::readerThreadCount &&
+				(TextureAsync::readQueue.size() == 0 || (maxWaitingCount > 0 && TextureAsync::decodeQueue.size() + TextureAsync::readingCount >= maxWaitingCount)))
+			{
+				TextureAsync::readCondition.wait(lock);
+				maxWaitingCount = april::getMaxWaitingAsyncTextures();
+			}
+			if (TextureAsync::stopping || TextureAsync::readerThreads.indexOf(thread) >= TextureAsync::readerThreadCount)
+			{
+				break;
+			}
+			entry = TextureAsync::readQueue.removeFirst();
+			texture = entry.texture;
+			TextureAsync::activeEntries[texture] = entry;
+			++TextureAsync::readingCount;
+			lock.unlock();
+			if (entry.proxy)
 			{
-				foreach (hstream*, it, TextureAsync::streams)
+				proxyOnly = !texture->_loadAsyncProxy();
+				lock.lock();
+				--TextureAsync::readingCount;
+				entry = TextureAsync::activeEntries[texture];
+				TextureAsync::activeEntries.removeKey(texture);
+				if (proxyOnly)
 				{
-					if ((*it) != NULL)
-					{
-						delete (*it);
-					}
+					TextureAsync::finishedCondition.notify_all();
 				}
-				TextureAsync::streams.clear();
+				else // the full resolution image has to wait behind the proxies of other textures
+				{
+					entry.proxy = false;
+					TextureAsync::readQueue.add(entry);
+				}
+				continue;
+			}
+			stream = texture->_prepareAsyncStream();
+			lock.lock();
+			--TextureAsync::readingCount;
+			entry = TextureAsync::activeEntries[texture]; // the priority could have been raised while reading
+			TextureAsync::activeEntries.removeKey(texture);
+			if (stream != NULL)
+			{
+				entry.stream = stream;
+				TextureAsync::decodeQueue.add(entry);
+				TextureAsync::decodeCondition.notify_one();
+			}
+			else // it was canceled
+			{
+				TextureAsync::readCondition.notify_one(); // the canceled read doesn't occupy a waiting slot anymore
+				TextureAsync::finishedCondition.notify_all();
+			}
+		}
+	}
+
+	void TextureAsync::_decode(hthread* thread)
+	{
+		Entry entry;
+		std::unique_lock<std::mutex> lock(TextureAsync::queueMutex);
+		while (true)
+		{
+			// surplus decoders exit when the pool is made smaller
+			while (!TextureAsync::stopping && TextureAsync::decodeQueue.size() == 0 && TextureAsync::decoderThreads.indexOf(thread) < TextureAsync::decoderThreadCount)
+			{
+				TextureAsync::decodeCondition.wait(lock);
+			}
+			if (TextureAsync::stopping || TextureAsync::decoderThreads.indexOf(thread) >= TextureAsync::decoderThreadCount)
+			{
 				break;
 			}
-			texture = TextureAsync::textures.removeFirst();
-			stream = TextureAsync::streams.removeFirst();
-			lock.release();
-			texture->_decodeFromAsyncStream(stream);
-			delete stream;
-			lock.acquire(&TextureAsync::queueMutex);
+			entry = TextureAsync::decodeQueue.removeFirst();
+			TextureAsync::activeEntries[entry.texture] = entry;
+			lock.unlock();
+			TextureAsync::readCondition.notify_one(); // there's room for more read data now
+			entry.texture->_decodeFromAsyncStream(entry.stream);
+			delete entry.stream;
+			lock.lock();
+			TextureAsync::activeEntries.removeKey(entry.texture);
+			TextureAsync::finishedCondition.notify_all();
 		}
 	}
 
@@ -13,42 +13,136 @@
 #ifndef APRIL_TEXTURE_ASYNC_H
 #define APRIL_TEXTURE_ASYNC_H
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 #include <gtypes/Rectangle.h>
 #include <gtypes/Vector2.h>
 #include <hltypes/harray.h>
 #include <hltypes/hlist.h>
 #include <hltypes/hmap.h>
-#include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
 #include <hltypes/hthread.h>
 #include <hltypes/hstring.h>
 
 #include "aprilExport.h"
+#include "Texture.h"
+#include "TextureLoadGroup.h"
+#include "Timer.h"
 
 namespace april
 {
-	class Texture;
-
 	class TextureAsync
 	{
 	public:
+		friend class TextureLoadGroup;
+
 		static void update();
 		static void updateSingleTexture(Texture* texture);
-		static bool queueLoad(Texture* texture);
+		static bool queueLoad(Texture* texture, Texture::LoadPriority priority, float deadline, bool proxy);
+		static bool updateLoad(Texture* texture, Texture::LoadPriority priority, float deadline);
 		static bool prioritizeLoad(Texture* texture);
+		static bool cancelLoad(Texture* texture);
 		static bool isRunning();
+		static void waitForLoad(Texture* texture);
+		static bool waitForUpload(Texture* texture, float timeout);
+		static bool waitForIdle(float timeout);
+		static void addCallback(Texture* texture, void (*function)(Texture*, bool, void*), void* userData);
+		static void removeCallbacks(Texture* texture);
+		static void destroy();
 
 	protected:
-		static harray<Texture*> textures;
-		static harray<hstream*> streams;
-		static hmutex queueMutex;
+		struct Entry
+		{
+		public:
+			Texture* texture;
+			hstream* stream;
+			int priority;
+			int64_t deadline;
+			int64_t order;
+			bool proxy;
+
+			Entry();
+			Entry(Texture* texture, int priority, int64_t deadline);
+
+			bool isBefore(const Entry& other) const;
+			bool raise(int priority, int64_t deadline);
+
+		};
+
+		struct Callback
+		{
+		public:
+			Texture* texture;
+			void (*function)(Texture*, bool, void*);
+			void* userData;
+			bool success;
+
+			Callback();
+			Callback(Texture* texture, void (*function)(Texture*, bool, void*), void* userData);
+
+		};
 
-		static hthread readerThread;
-		static bool readerRunning;
+		// binary heap with an index per texture so entries can be reprioritized and removed in O(log n)
+		class Queue
+		{
+		public:
+			int size() const;
+			bool has(Texture* texture) const;
+			void add(const Entry& entry);
+			bool raise(Texture* texture, int priority, int64_t deadline);
+			bool remove(Texture* texture, Entry* entry = NULL);
+			Entry removeFirst();
+			void clear();
+
+		protected:
+			harray<Entry> entries;
+			hmap<Texture*, int> indices;
+
+			void _set(int index, const Entry& entry);
+			void _removeAt(int index);
+			void _siftUp(int index);
+			void _siftDown(int index);
+
+		};
+
+		static Queue readQueue;
+		static Queue decodeQueue;
+		static hmap<Texture*, Entry> activeEntries;
+		static int64_t nextOrder;
+		// hmutex can't be used with condition variables
+		static std::mutex queueMutex;
+		static std::condition_variable readCondition;
+		static std::condition_variable decodeCondition;
+		static std::condition_variable finishedCondition;
+		static bool stopping;
+
+		static harray<hthread*> readerThreads;
+		static int readerThreadCount;
+		static int readingCount;
 
 		static harray<hthread*> decoderThreads;
+		static int decoderThreadCount;
+
+		// measures how long uploads take on the render thread
+		static Timer uploadTimer;
+
+		// completion is only checked once per update, independent of how many textures are still loading
+		static harray<Callback> callbacks;
+		static harray<Callback> readyCallbacks;
+		static harray<TextureLoadGroup*> groups;
+		static std::mutex callbackMutex;
+		static std::condition_variable loadedCondition;
 
 		static void _updateThreads();
+		static void _updatePool(harray<hthread*>& threads, int count, void (*function)(hthread*), chstr name);
+		static int _getPriorityValue(Texture::LoadPriority priority);
+		static int64_t _getDeadlineTime(float deadline);
+		static bool _raiseLoad(Texture* texture, int priority, int64_t deadline);
+		static std::chrono::steady_clock::time_point _getWaitEndTime(float timeout);
+		static bool _wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, float timeout, const std::chrono::steady_clock::time_point& endTime);
+		static void _updateCallbacks();
 
 		static void _read(hthread* thread);
 		static void _decode(hthread* thread);
@@ -58,7 +152,7 @@ namespace april
 		~TextureAsync() { }
 
 	};
-	
+
 }
 
 #endif
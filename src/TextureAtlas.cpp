@@ -0,0 +1,444 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <limits.h>
+#include <string.h>
+
+#include <gtypes/Rectangle.h>
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "april.h"
+#include "Color.h"
+#include "Image.h"
+#include "RenderSystem.h"
+#include "Texture.h"
+#include "TextureAtlas.h"
+
+// queued and repeated frames can still reference a page for a while after it was retired
+#define RETIRED_PAGE_FRAMES 4
+
+namespace april
+{
+	TextureAtlas::Segment::Segment() : x(0), y(0), w(0)
+	{
+	}
+
+	TextureAtlas::Segment::Segment(int x, int y, int w) : x(x), y(y), w(w)
+	{
+	}
+
+	TextureAtlas::Page::Page(Texture* texture, int size, int padding)
+	{
+		this->texture = texture;
+		this->size = size;
+		this->padding = padding;
+		this->skyline += Segment(0, 0, size);
+		this->usedArea = 0;
+		this->freedArea = 0;
+	}
+
+	bool TextureAtlas::Page::insert(int w, int h, grecti& rect)
+	{
+		int bestIndex = -1;
+		int bestBottom = INT_MAX;
+		int bestWidth = INT_MAX;
+		int y = 0;
+		// bottom-left rule, ties go to the narrower segment to keep wide segments for wide textures
+		for_iter (i, 0, this->skyline.size())
+		{
+			y = this->_fit(i, w, h);
+			if (y >= 0 && (y + h < bestBottom || (y + h == bestBottom && this->skyline[i].w < bestWidth)))
+			{
+				bestIndex = i;
+				bestBottom = y + h;
+				bestWidth = this->skyline[i].w;
+			}
+		}
+		if (bestIndex < 0)
+		{
+			return false;
+		}
+		rect = grecti(this->skyline[bestIndex].x, bestBottom - h, w, h);
+		this->_addSegment(bestIndex, rect);
+		return true;
+	}
+
+	grectf TextureAtlas::Page::getUvRect(Texture* texture) const
+	{
+		grecti rect = this->regions.tryGet(texture, grecti());
+		float size = (float)this->size;
+		return grectf((rect.x + this->padding) / size, (rect.y + this->padding) / size, (rect.w - this->padding * 2) / size, (rect.h - this->padding * 2) / size);
+	}
+
+	int TextureAtlas::Page::_fit(int index, int w, int h) const
+	{
+		if (this->skyline[index].x + w > this->size)
+		{
+			return -1;
+		}
+		int y = this->skyline[index].y;
+		int remaining = w;
+		for (int i = index; remaining > 0; ++i)
+		{
+			y = hmax(y, this->skyline[i].y);
+			if (y + h > this->size)
+			{
+				return -1;
+			}
+			remaining -= this->skyline[i].w;
+		}
+		return y;
+	}
+
+	void TextureAtlas::Page::_addSegment(int index, const grecti& rect)
+	{
+		this->skyline.insertAt(index, Segment(rect.x, rect.y + rect.h, rect.w));
+		int shrink = 0;
+		// segments covered by the new one are cut off or removed
+		for_iter (i, index + 1, this->skyline.size())
+		{
+			shrink = this->skyline[i - 1].x + this->skyline[i - 1].w - this->skyline[i].x;
+			if (shrink <= 0)
+			{
+				break;
+			}
+			this->skyline[i].x += shrink;
+			this->skyline[i].w -= shrink;
+			if (this->skyline[i].w > 0)
+			{
+				break;
+			}
+			this->skyline.removeAt(i);
+			--i;
+		}
+		for_iter (i, 0, this->skyline.size() - 1)
+		{
+			if (this->skyline[i].y == this->skyline[i + 1].y)
+			{
+				this->skyline[i].w += this->skyline[i + 1].w;
+				this->skyline.removeAt(i + 1);
+				--i;
+			}
+		}
+	}
+
+	harray<TextureAtlas::Page*> TextureAtlas::pages;
+	hmap<Texture*, TextureAtlas::Page*> TextureAtlas::texturePages;
+	hmap<TextureAtlas::Page*, int> TextureAtlas::retiredPages;
+	hmutex TextureAtlas::mutex;
+
+	bool TextureAtlas::add(Texture* texture, unsigned char* data, Image::Format format)
+	{
+		if (!TextureAtlas::_isEligible(texture, format))
+		{
+			return false;
+		}
+		TextureAtlas::remove(texture); // a texture that is uploaded again might have changed
+		hmutex::ScopeLock lock(&TextureAtlas::mutex);
+		grecti rect;
+		Page* page = NULL;
+		if (!TextureAtlas::_insert(texture, texture->width, texture->height, rect, &page))
+		{
+			return false;
+		}
+		TextureAtlas::_writeRegion(page, rect, data, texture->width, texture->height, format);
+		page->regions[texture] = rect;
+		page->usedArea += rect.w * rect.h;
+		TextureAtlas::texturePages[texture] = page;
+		return true;
+	}
+
+	void TextureAtlas::remove(Texture* texture)
+	{
+		hmutex::ScopeLock lock(&TextureAtlas::mutex);
+		Page* page = TextureAtlas::texturePages.tryGet(texture, NULL);
+		if (page == NULL)
+		{
+			return;
+		}
+		grecti rect = page->regions[texture];
+		page->regions.removeKey(texture);
+		page->usedArea -= rect.w * rect.h;
+		page->freedArea += rect.w * rect.h;
+		TextureAtlas::texturePages.removeKey(texture);
+	}
+
+	bool TextureAtlas::has(Texture* texture)
+	{
+		hmutex::ScopeLock lock(&TextureAtlas::mutex);
+		return TextureAtlas::texturePages.hasKey(texture);
+	}
+
+	bool TextureAtlas::getRegion(Texture* texture, Texture** pageTexture, grectf* uvRect)
+	{
+		hmutex::ScopeLock lock(&TextureAtlas::mutex);
+		if (TextureAtlas::texturePages.size() == 0)
+		{
+			return false;
+		}
+		Page* page = TextureAtlas::texturePages.tryGet(texture, NULL);
+		if (page == NULL)
+		{
+			return false;
+		}
+		*pageTexture = page->texture;
+		*uvRect = page->getUvRect(texture);
+		return true;
+	}
+
+	bool TextureAtlas::update()
+	{
+		hmutex::ScopeLock lock(&TextureAtlas::mutex);
+		bool result = false;
+		harray<Page*> retiredPages = TextureAtlas::retiredPages.keys();
+		foreach (Page*, it, retiredPages)
+		{
+			--TextureAtlas::retiredPages[*it];
+			if (TextureAtlas::retiredPages[*it] <= 0)
+			{
+				TextureAtlas::retiredPages.removeKey(*it);
+				TextureAtlas::_destroyPage(*it);
+				result = true;
+			}
+		}
+		harray<Page*> pages = TextureAtlas::pages;
+		foreach (Page*, it, pages)
+		{
+			if ((*it)->regions.size() == 0)
+			{
+				TextureAtlas::_retirePage(*it);
+			}
+			// unloaded textures leave holes that the skyline can't reuse, one page per frame is repacked to keep the cost low
+			else if ((*it)->freedArea * 4 >= (*it)->size * (*it)->size && (*it)->freedArea >= (*it)->usedArea)
+			{
+				if (TextureAtlas::_defragment(*it))
+				{
+					break;
+				}
+			}
+		}
+		return result;
+	}
+
+	int TextureAtlas::getPageCount()
+	{
+		hmutex::ScopeLock lock(&TextureAtlas::mutex);
+		return TextureAtlas::pages.size();
+	}
+
+	float TextureAtlas::getOccupancy()
+	{
+		hmutex::ScopeLock lock(&TextureAtlas::mutex);
+		int64_t usedArea = 0LL;
+		int64_t area = 0LL;
+		foreach (Page*, it, TextureAtlas::pages)
+		{
+			usedArea += (int64_t)(*it)->usedArea;
+			area += (int64_t)(*it)->size * (*it)->size;
+		}
+		return (area > 0LL ? (float)((double)usedArea / area) : 0.0f);
+	}
+
+	int64_t TextureAtlas::getVRamSize()
+	{
+		// pages aren't registered in the render system so they are counted here instead of the packed textures
+		hmutex::ScopeLock lock(&TextureAtlas::mutex);
+		int64_t result = 0LL;
+		foreach (Page*, it, TextureAtlas::pages)
+		{
+			result += (int64_t)(*it)->size * (*it)->size * (*it)->texture->getFormat().getBpp();
+		}
+		harray<Page*> retiredPages = TextureAtlas::retiredPages.keys();
+		foreach (Page*, it, retiredPages)
+		{
+			result += (int64_t)(*it)->size * (*it)->size * (*it)->texture->getFormat().getBpp();
+		}
+		return result;
+	}
+
+	void TextureAtlas::destroy()
+	{
+		hmutex::ScopeLock lock(&TextureAtlas::mutex);
+		harray<Page*> pages = TextureAtlas::pages;
+		pages += TextureAtlas::retiredPages.keys();
+		TextureAtlas::pages.clear();
+		TextureAtlas::retiredPages.clear();
+		TextureAtlas::texturePages.clear();
+		foreach (Page*, it, pages)
+		{
+			TextureAtlas::_destroyPage(*it);
+		}
+	}
+
+	bool TextureAtlas::_isEligible(Texture* texture, Image::Format format)
+	{
+		int maxDimension = april::getTextureAtlasMaxDimension();
+		if (maxDimension <= 0 || texture->type != Texture::Type::Immutable || texture->width <= 0 || texture->height <= 0 ||
+			texture->width > maxDimension || texture->height > maxDimension)
+		{
+			return false;
+		}
+		// sampling outside of the texture's region, mipmaps and block compression would all pick up neighboring textures
+		if (texture->addressMode != Texture::AddressMode::Clamp || texture->_isMipmapFilter() || texture->compressible)
+		{
+			return false;
+		}
+		if (format == Image::Format::Compressed || format == Image::Format::Palette || format == Image::Format::Alpha || texture->dataFormat != 0)
+		{
+			return false;
+		}
+		int size = april::getTextureAtlasPageSize() - april::getTextureAtlasPadding() * 2;
+		return (texture->width <= size && texture->height <= size);
+	}
+
+	TextureAtlas::Page* TextureAtlas::_createPage(int size, int padding)
+	{
+		Texture* texture = april::rendersys->_deviceCreateTexture(false);
+		if (!texture->_create(size, size, Color::Clear, april::rendersys->getNativeTextureFormat(Image::Format::RGBA), Texture::Type::Managed))
+		{
+			delete texture;
+			return NULL;
+		}
+		texture->name = hsprintf("APRIL texture atlas page %d", TextureAtlas::pages.size());
+		texture->addressMode = Texture::AddressMode::Clamp;
+		Page* page = new Page(texture, size, padding);
+		TextureAtlas::pages += page;
+		hlog::writef(logTag, "Created texture atlas page %d with size %d,%d.", TextureAtlas::pages.size() - 1, size, size);
+		return page;
+	}
+
+	void TextureAtlas::_destroyPage(Page* page)
+	{
+		page->texture->_deviceDestroyTexture(); // pages aren't registered so the rest of the unloading isn't needed
+		delete page->texture;
+		delete page;
+	}
+
+	bool TextureAtlas::_insert(Texture* texture, int w, int h, grecti& rect, Page** page)
+	{
+		int size = april::getTextureAtlasPageSize();
+		int padding = april::getTextureAtlasPadding();
+		w += padding * 2;
+		h += padding * 2;
+		// a page uses one filter for all of its textures
+		foreach (Page*, it, TextureAtlas::pages)
+		{
+			if ((*it)->padding == padding && (*it)->texture->filter == texture->filter && (*it)->insert(w, h, rect))
+			{
+				*page = (*it);
+				return true;
+			}
+		}
+		Page* newPage = TextureAtlas::_createPage(size, padding);
+		if (newPage == NULL)
+		{
+			return false;
+		}
+		newPage->texture->filter = texture->filter;
+		if (!newPage->insert(w, h, rect))
+		{
+			return false;
+		}
+		*page = newPage;
+		return true;
+	}
+
+	void TextureAtlas::_writeRegion(Page* page, const grecti& rect, unsigned char* data, int w, int h, Image::Format format)
+	{
+		Texture* texture = page->texture;
+		int padding = page->padding;
+		int bpp = texture->format.getBpp();
+		int rowSize = rect.w * bpp;
+		unsigned char* buffer = new unsigned char[rect.w * rect.h * bpp];
+		Image::write(0, 0, w, h, padding, padding, data, w, h, format, buffer, rect.w, rect.h, texture->format);
+		// the edge pixels are extruded into the padding so linear filtering doesn't blend in neighboring textures
+		unsigned char* row = NULL;
+		for_iter (j, padding, padding + h)
+		{
+			row = &buffer[j * rowSize];
+			for_iter (i, 0, padding)
+			{
+				memcpy(&row[i * bpp], &row[padding * bpp], bpp);
+				memcpy(&row[(padding + w + i) * bpp], &row[(padding + w - 1) * bpp], bpp);
+			}
+		}
+		for_iter (j, 0, padding)
+		{
+			memcpy(&buffer[j * rowSize], &buffer[padding * rowSize], rowSize);
+			memcpy(&buffer[(padding + h + j) * rowSize], &buffer[(padding + h - 1) * rowSize], rowSize);
+		}
+		hmutex::ScopeLock lock(&texture->asyncLoadMutex);
+		bool uploaded = texture->uploaded;
+		lock.release();
+		lock.acquire(&texture->asyncDataMutex);
+		Image::write(0, 0, rect.w, rect.h, rect.x, rect.y, buffer, rect.w, rect.h, texture->format, texture->data, texture->width, texture->height, texture->format);
+		delete[] buffer;
+		// only the new region has to be uploaded instead of the whole page
+		if (!uploaded || texture->dirty || !texture->_uploadDataToGpu(rect.x, rect.y, rect.w, rect.h))
+		{
+			texture->_addDirtyRect(rect.x, rect.y, rect.w, rect.h);
+		}
+	}
+
+	void TextureAtlas::_retirePage(Page* page)
+	{
+		TextureAtlas::pages -= page;
+		TextureAtlas::retiredPages[page] = RETIRED_PAGE_FRAMES;
+	}
+
+	bool TextureAtlas::_defragment(Page* page)
+	{
+		harray<Texture*> textures = page->regions.keys();
+		HL_LAMBDA_CLASS(_sortTallestFirst, bool, ((Texture* const& a, Texture* const& b) { return (a->height > b->height); }));
+		textures.sort(&_sortTallestFirst::lambda);
+		TextureAtlas::pages -= page; // the old page doesn't accept new textures anymore
+		Page* newPage = TextureAtlas::_createPage(page->size, page->padding);
+		if (newPage == NULL)
+		{
+			TextureAtlas::pages += page;
+			return false;
+		}
+		newPage->texture->filter = page->texture->filter;
+		hmap<Texture*, grecti> regions;
+		grecti rect;
+		foreach (Texture*, it, textures)
+		{
+			if (!newPage->insert(page->regions[*it].w, page->regions[*it].h, rect))
+			{
+				hlog::warn(logTag, "Could not defragment texture atlas page, it is kept as it is.");
+				TextureAtlas::pages -= newPage;
+				TextureAtlas::pages += page;
+				TextureAtlas::_destroyPage(newPage);
+				return false;
+			}
+			regions[*it] = rect;
+		}
+		// the new page isn't uploaded yet so its data can be written without locking
+		Image::Format format = page->texture->format;
+		hmutex::ScopeLock lock(&page->texture->asyncDataMutex);
+		foreach (Texture*, it, textures)
+		{
+			rect = page->regions[*it];
+			Image::write(rect.x, rect.y, rect.w, rect.h, regions[*it].x, regions[*it].y, page->texture->data, page->size, page->size, format,
+				newPage->texture->data, newPage->size, newPage->size, format);
+			newPage->regions[*it] = regions[*it];
+			newPage->usedArea += rect.w * rect.h;
+			TextureAtlas::texturePages[*it] = newPage;
+		}
+		lock.release();
+		hlog::writef(logTag, "Defragmented texture atlas page with %d textures, %.0f%% of the page is used now.", textures.size(), newPage->usedArea * 100.0f / (newPage->size * newPage->size));
+		TextureAtlas::retiredPages[page] = RETIRED_PAGE_FRAMES;
+		return true;
+	}
+
+}
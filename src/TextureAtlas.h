@@ -0,0 +1,98 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines utilities for packing small textures into shared atlas pages at runtime.
+
+#ifndef APRIL_TEXTURE_ATLAS_H
+#define APRIL_TEXTURE_ATLAS_H
+
+#include <gtypes/Rectangle.h>
+#include <hltypes/harray.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+
+#include "aprilExport.h"
+#include "Image.h"
+
+namespace april
+{
+	class Texture;
+
+	class TextureAtlas
+	{
+	public:
+		static bool add(Texture* texture, unsigned char* data, Image::Format format);
+		static void remove(Texture* texture);
+		static bool has(Texture* texture);
+		static bool getRegion(Texture* texture, Texture** pageTexture, grectf* uvRect);
+		static bool update();
+		static int getPageCount();
+		static float getOccupancy();
+		static int64_t getVRamSize();
+		static void destroy();
+
+	protected:
+		struct Segment
+		{
+		public:
+			int x;
+			int y;
+			int w;
+
+			Segment();
+			Segment(int x, int y, int w);
+
+		};
+
+		// skyline bottom-left packer, freed space is only reclaimed by defragmentation
+		class Page
+		{
+		public:
+			Texture* texture;
+			int size;
+			int padding;
+			harray<Segment> skyline;
+			hmap<Texture*, grecti> regions; // includes the padding
+			int usedArea;
+			int freedArea;
+
+			Page(Texture* texture, int size, int padding);
+
+			bool insert(int w, int h, grecti& rect);
+			grectf getUvRect(Texture* texture) const;
+
+		protected:
+			int _fit(int index, int w, int h) const;
+			void _addSegment(int index, const grecti& rect);
+
+		};
+
+		static harray<Page*> pages;
+		static hmap<Texture*, Page*> texturePages;
+		static hmap<Page*, int> retiredPages;
+		static hmutex mutex;
+
+		static bool _isEligible(Texture* texture, Image::Format format);
+		static Page* _createPage(int size, int padding);
+		static void _destroyPage(Page* page);
+		static bool _insert(Texture* texture, int w, int h, grecti& rect, Page** page);
+		static void _writeRegion(Page* page, const grecti& rect, unsigned char* data, int w, int h, Image::Format format);
+		static void _retirePage(Page* page);
+		static bool _defragment(Page* page);
+
+	private: // prevents inheritance and instantiation
+		TextureAtlas() { }
+		~TextureAtlas() { }
+
+	};
+
+}
+
+#endif
@@ -0,0 +1,435 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <stdio.h>
+#include <string.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hdir.h>
+#include <hltypes/hexception.h>
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hsbase.h>
+#include <hltypes/hstring.h>
+
+#include "april.h"
+#include "hashUtil.h"
+#include "Image.h"
+#include "TextureCache.h"
+
+#define CACHE_SIGNATURE "ATEX"
+#define CACHE_VERSION 2
+#define CACHE_EXTENSION ".tex"
+#define TEMPORARY_EXTENSION ".tmp"
+#define INDEX_SIGNATURE "AIDX"
+#define INDEX_FILENAME "index.dat"
+#define HASH_BUFFER_SIZE 65536
+
+namespace april
+{
+	struct TextureCacheHeader
+	{
+		char signature[4];
+		unsigned int version;
+		unsigned int width;
+		unsigned int height;
+		unsigned int format;
+		unsigned int size;
+		unsigned long long hash;
+		unsigned long long sourceSize;
+		long long sourceTime;
+	};
+
+	struct TextureCacheIndexEntry
+	{
+		unsigned long long hash;
+		long long size;
+		long long access;
+	};
+
+	TextureCache::Entry::Entry()
+	{
+		this->size = 0LL;
+		this->access = 0LL;
+		this->readers = 0;
+	}
+
+	TextureCache::Entry::Entry(int64_t size, int64_t access)
+	{
+		this->size = size;
+		this->access = access;
+		this->readers = 0;
+	}
+
+	hstr TextureCache::path;
+	hmap<unsigned long long, TextureCache::Entry> TextureCache::entries;
+	int64_t TextureCache::size = 0LL;
+	int64_t TextureCache::nextAccess = 0LL;
+	int64_t TextureCache::nextWriteId = 0LL;
+	bool TextureCache::indexChanged = false;
+	int64_t TextureCache::hits = 0LL;
+	int64_t TextureCache::misses = 0LL;
+	int64_t TextureCache::writes = 0LL;
+	int64_t TextureCache::evictions = 0LL;
+	hmutex TextureCache::mutex;
+
+	unsigned long long TextureCache::calcHash(hsbase& stream, chstr key)
+	{
+		unsigned long long hash = hashFnv1a((const unsigned char*)key.cStr(), key.size());
+		unsigned char* buffer = new unsigned char[HASH_BUFFER_SIZE];
+		int count = 0;
+		stream.rewind();
+		while ((count = stream.readRaw(buffer, HASH_BUFFER_SIZE)) > 0)
+		{
+			hash = hashFnv1a(hash, buffer, count);
+		}
+		stream.rewind();
+		delete[] buffer;
+		return hash;
+	}
+
+	bool TextureCache::read(unsigned long long hash, int64_t sourceSize, int64_t sourceTime, int* width, int* height, Image::Format* format, unsigned char** data)
+	{
+		hmutex::ScopeLock lock(&TextureCache::mutex);
+		if (!TextureCache::_updatePath())
+		{
+			return false;
+		}
+		if (!TextureCache::entries.hasKey(hash))
+		{
+			++TextureCache::misses;
+			return false;
+		}
+		hstr path = TextureCache::path;
+		hstr filename = TextureCache::_getFilename(hash);
+		++TextureCache::entries[hash].readers;
+		lock.release();
+		bool result = false;
+		TextureCacheHeader header;
+		try
+		{
+			hfile file;
+			file.open(filename);
+			if (file.readRaw(&header, sizeof(TextureCacheHeader)) == sizeof(TextureCacheHeader) && hstr(header.signature, sizeof(header.signature)) == CACHE_SIGNATURE &&
+				header.version == CACHE_VERSION && header.hash == hash && header.sourceSize == (unsigned long long)sourceSize && header.sourceTime == (long long)sourceTime &&
+				header.size == header.width * header.height * Image::Format::fromInt(header.format).getBpp())
+			{
+				*data = new unsigned char[header.size];
+				if (file.readRaw(*data, header.size) == (int)header.size)
+				{
+					*width = header.width;
+					*height = header.height;
+					*format = Image::Format::fromInt(header.format);
+					result = true;
+				}
+				else
+				{
+					delete[] *data;
+					*data = NULL;
+				}
+			}
+		}
+		catch (hexception&)
+		{
+		}
+		lock.acquire(&TextureCache::mutex);
+		if (TextureCache::path == path && TextureCache::entries.hasKey(hash) && TextureCache::entries[hash].readers > 0)
+		{
+			--TextureCache::entries[hash].readers;
+		}
+		if (!result)
+		{
+			hlog::warn(logTag, "Ignoring invalid texture cache file: " + filename);
+			if (TextureCache::entries.hasKey(hash))
+			{
+				TextureCache::size -= TextureCache::entries[hash].size;
+				TextureCache::entries.removeKey(hash);
+				TextureCache::indexChanged = true;
+			}
+			++TextureCache::misses;
+			return false;
+		}
+		if (TextureCache::entries.hasKey(hash))
+		{
+			TextureCache::entries[hash].access = TextureCache::nextAccess;
+			++TextureCache::nextAccess;
+			TextureCache::indexChanged = true;
+		}
+		++TextureCache::hits;
+		return true;
+	}
+
+	void TextureCache::write(unsigned long long hash, int64_t sourceSize, int64_t sourceTime, int width, int height, Image::Format format, unsigned char* data)
+	{
+		hmutex::ScopeLock lock(&TextureCache::mutex);
+		if (!TextureCache::_updatePath())
+		{
+			return;
+		}
+		hstr path = TextureCache::path;
+		hstr filename = TextureCache::_getFilename(hash);
+		// concurrent writers and readers of the same file must never see a partially written one
+		hstr temporaryFilename = filename + hsprintf(".%lld", (long long)TextureCache::nextWriteId) + TEMPORARY_EXTENSION;
+		++TextureCache::nextWriteId;
+		lock.release();
+		TextureCacheHeader header;
+		memcpy(header.signature, CACHE_SIGNATURE, sizeof(header.signature));
+		header.version = CACHE_VERSION;
+		header.width = width;
+		header.height = height;
+		header.format = (unsigned int)format.value;
+		header.size = width * height * format.getBpp();
+		header.hash = hash;
+		header.sourceSize = (unsigned long long)sourceSize;
+		header.sourceTime = (long long)sourceTime;
+		try
+		{
+			hdir::create(path);
+			hfile file;
+			file.open(temporaryFilename, hfaccess::Write);
+			file.writeRaw(&header, sizeof(TextureCacheHeader));
+			file.writeRaw(data, header.size);
+		}
+		catch (hexception& e)
+		{
+			hlog::warn(logTag, "Could not write texture cache file: " + e.getFullMessage());
+			hfile::remove(temporaryFilename);
+			return;
+		}
+		lock.acquire(&TextureCache::mutex);
+		// renaming replaces the file atomically, but some platforms can't rename over an existing file
+		if (::rename(temporaryFilename.cStr(), filename.cStr()) != 0 &&
+			(TextureCache::entries.tryGet(hash, Entry()).readers > 0 || !hfile::remove(filename) || ::rename(temporaryFilename.cStr(), filename.cStr()) != 0))
+		{
+			hlog::warn(logTag, "Could not replace texture cache file: " + filename);
+			hfile::remove(temporaryFilename);
+			return;
+		}
+		if (TextureCache::path != path) // the cache was moved in the meantime
+		{
+			return;
+		}
+		int64_t size = (int64_t)(sizeof(TextureCacheHeader) + header.size);
+		int readers = 0;
+		if (TextureCache::entries.hasKey(hash))
+		{
+			TextureCache::size -= TextureCache::entries[hash].size;
+			readers = TextureCache::entries[hash].readers;
+		}
+		TextureCache::entries[hash] = Entry(size, TextureCache::nextAccess);
+		TextureCache::entries[hash].readers = readers;
+		++TextureCache::nextAccess;
+		TextureCache::size += size;
+		TextureCache::indexChanged = true;
+		++TextureCache::writes;
+		int64_t maxSize = april::getTextureCacheMaxSize();
+		if (maxSize > 0LL && TextureCache::size > maxSize)
+		{
+			TextureCache::_trim(maxSize);
+		}
+	}
+
+	int64_t TextureCache::getHits()
+	{
+		hmutex::ScopeLock lock(&TextureCache::mutex);
+		return TextureCache::hits;
+	}
+
+	int64_t TextureCache::getMisses()
+	{
+		hmutex::ScopeLock lock(&TextureCache::mutex);
+		return TextureCache::misses;
+	}
+
+	int64_t TextureCache::getWrites()
+	{
+		hmutex::ScopeLock lock(&TextureCache::mutex);
+		return TextureCache::writes;
+	}
+
+	int64_t TextureCache::getEvictions()
+	{
+		hmutex::ScopeLock lock(&TextureCache::mutex);
+		return TextureCache::evictions;
+	}
+
+	int64_t TextureCache::getSize()
+	{
+		hmutex::ScopeLock lock(&TextureCache::mutex);
+		return TextureCache::size;
+	}
+
+	void TextureCache::destroy()
+	{
+		hmutex::ScopeLock lock(&TextureCache::mutex);
+		TextureCache::_saveIndex();
+		TextureCache::path = "";
+		TextureCache::entries.clear();
+		TextureCache::size = 0LL;
+		TextureCache::nextAccess = 0LL;
+	}
+
+	bool TextureCache::_updatePath()
+	{
+		hstr path = april::getTextureCachePath();
+		if (path != TextureCache::path)
+		{
+			TextureCache::_saveIndex();
+			TextureCache::path = path;
+			TextureCache::entries.clear();
+			TextureCache::size = 0LL;
+			TextureCache::nextAccess = 0LL;
+			if (TextureCache::path != "")
+			{
+				TextureCache::_loadIndex();
+			}
+		}
+		return (TextureCache::path != "");
+	}
+
+	hstr TextureCache::_getFilename(unsigned long long hash)
+	{
+		return hdir::joinPath(TextureCache::path, hsprintf("%016llx", hash) + CACHE_EXTENSION);
+	}
+
+	void TextureCache::_loadIndex()
+	{
+		hstr filename = hdir::joinPath(TextureCache::path, INDEX_FILENAME);
+		TextureCache::indexChanged = false;
+		try
+		{
+			if (hfile::exists(filename))
+			{
+				hfile file;
+				file.open(filename);
+				char signature[4] = { 0 };
+				int count = 0;
+				if (file.readRaw(signature, sizeof(signature)) == sizeof(signature) && hstr(signature, sizeof(signature)) == INDEX_SIGNATURE &&
+					file.readRaw(&count, sizeof(count)) == sizeof(count))
+				{
+					TextureCacheIndexEntry entry;
+					for_iter (i, 0, count)
+					{
+						if (file.readRaw(&entry, sizeof(TextureCacheIndexEntry)) != sizeof(TextureCacheIndexEntry))
+						{
+							break;
+						}
+						TextureCache::entries[entry.hash] = Entry(entry.size, entry.access);
+						TextureCache::size += entry.size;
+						TextureCache::nextAccess = hmax(TextureCache::nextAccess, (int64_t)entry.access + 1);
+					}
+					return;
+				}
+			}
+			// no usable index, e.g. because the application didn't shut down properly, so it's rebuilt from the files
+			if (!hdir::exists(TextureCache::path))
+			{
+				return;
+			}
+			harray<hstr> files = hdir::files(TextureCache::path);
+			TextureCacheHeader header;
+			foreach (hstr, it, files)
+			{
+				if ((*it).endsWith(TEMPORARY_EXTENSION)) // left behind by an interrupted write
+				{
+					hfile::remove(hdir::joinPath(TextureCache::path, (*it)));
+				}
+				else if ((*it).endsWith(CACHE_EXTENSION))
+				{
+					hfile file;
+					file.open(hdir::joinPath(TextureCache::path, (*it)));
+					if (file.readRaw(&header, sizeof(TextureCacheHeader)) == sizeof(TextureCacheHeader) && hstr(header.signature, sizeof(header.signature)) == CACHE_SIGNATURE &&
+						header.version == CACHE_VERSION)
+					{
+						TextureCache::entries[header.hash] = Entry((int64_t)(sizeof(TextureCacheHeader) + header.size), 0LL);
+						TextureCache::size += (int64_t)(sizeof(TextureCacheHeader) + header.size);
+					}
+				}
+			}
+			TextureCache::indexChanged = true;
+		}
+		catch (hexception& e)
+		{
+			hlog::warn(logTag, "Could not read texture cache index: " + e.getFullMessage());
+		}
+	}
+
+	void TextureCache::_saveIndex()
+	{
+		if (TextureCache::path == "" || !TextureCache::indexChanged)
+		{
+			return;
+		}
+		TextureCache::indexChanged = false;
+		try
+		{
+			hdir::create(TextureCache::path);
+			hfile file;
+			file.open(hdir::joinPath(TextureCache::path, INDEX_FILENAME), hfaccess::Write);
+			file.writeRaw(INDEX_SIGNATURE, 4);
+			int count = TextureCache::entries.size();
+			file.writeRaw(&count, sizeof(count));
+			TextureCacheIndexEntry entry;
+			harray<unsigned long long> hashes = TextureCache::entries.keys();
+			foreach (unsigned long long, it, hashes)
+			{
+				entry.hash = (*it);
+				entry.size = TextureCache::entries[*it].size;
+				entry.access = TextureCache::entries[*it].access;
+				file.writeRaw(&entry, sizeof(TextureCacheIndexEntry));
+			}
+		}
+		catch (hexception& e)
+		{
+			hlog::warn(logTag, "Could not write texture cache index: " + e.getFullMessage());
+		}
+	}
+
+	void TextureCache::_trim(int64_t maxSize)
+	{
+		// the least recently used files are removed until the cache fits into 3/4 of the limit so trimming doesn't happen on every write
+		int64_t targetSize = maxSize / 4 * 3;
+		harray<unsigned long long> allHashes = TextureCache::entries.keys();
+		harray<unsigned long long> hashes;
+		harray<int64_t> accesses;
+		foreach (unsigned long long, it, allHashes)
+		{
+			// files that are currently being read are skipped, a later trim can still remove them
+			if (TextureCache::entries[*it].readers == 0)
+			{
+				hashes += (*it);
+				accesses += TextureCache::entries[*it].access;
+			}
+		}
+		unsigned long long hash = 0ULL;
+		int index = 0;
+		while (TextureCache::size > targetSize && hashes.size() > 0)
+		{
+			index = 0;
+			for_iter (i, 1, accesses.size())
+			{
+				if (accesses[i] < accesses[index])
+				{
+					index = i;
+				}
+			}
+			hash = hashes.removeAt(index);
+			accesses.removeAt(index);
+			hfile::remove(TextureCache::_getFilename(hash));
+			TextureCache::size -= TextureCache::entries[hash].size;
+			TextureCache::entries.removeKey(hash);
+			++TextureCache::evictions;
+		}
+		TextureCache::indexChanged = true;
+		TextureCache::_saveIndex();
+	}
+
+}
@@ -0,0 +1,81 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines utilities for caching decoded texture data on disk.
+
+#ifndef APRIL_TEXTURE_CACHE_H
+#define APRIL_TEXTURE_CACHE_H
+
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hsbase.h>
+#include <hltypes/hstring.h>
+
+#include "aprilExport.h"
+#include "Image.h"
+
+namespace april
+{
+	class TextureCache
+	{
+	public:
+		static unsigned long long calcHash(hsbase& stream, chstr key);
+		// the source's size and modification time are checked as well, because the hash alone can't rule out collisions
+		static bool read(unsigned long long hash, int64_t sourceSize, int64_t sourceTime, int* width, int* height, Image::Format* format, unsigned char** data);
+		static void write(unsigned long long hash, int64_t sourceSize, int64_t sourceTime, int width, int height, Image::Format format, unsigned char* data);
+		static int64_t getHits();
+		static int64_t getMisses();
+		static int64_t getWrites();
+		static int64_t getEvictions();
+		static int64_t getSize();
+		static void destroy();
+
+	protected:
+		struct Entry
+		{
+		public:
+			int64_t size;
+			int64_t access;
+			// how many threads are currently reading the file, it's not removed while they do
+			int readers;
+
+			Entry();
+			Entry(int64_t size, int64_t access);
+
+		};
+
+		// the index is kept in memory and only saved when it changed so hits don't cause any writes
+		static hstr path;
+		static hmap<unsigned long long, Entry> entries;
+		static int64_t size;
+		static int64_t nextAccess;
+		static int64_t nextWriteId;
+		static bool indexChanged;
+		static int64_t hits;
+		static int64_t misses;
+		static int64_t writes;
+		static int64_t evictions;
+		static hmutex mutex;
+
+		static bool _updatePath();
+		static hstr _getFilename(unsigned long long hash);
+		static void _loadIndex();
+		static void _saveIndex();
+		static void _trim(int64_t maxSize);
+
+	private: // prevents inheritance and instantiation
+		TextureCache() { }
+		~TextureCache() { }
+
+	};
+
+}
+
+#endif
@@ -0,0 +1,282 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hdir.h>
+#include <hltypes/hexception.h>
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include "april.h"
+#include "hashUtil.h"
+#include "Image.h"
+#include "Platform.h"
+#include "RenderSystem.h"
+#include "Texture.h"
+#include "TextureCompressor.h"
+
+#define CACHE_SIGNATURE "ABLK"
+#define CACHE_VERSION 1
+#define CACHE_EXTENSION ".blk"
+
+namespace april
+{
+	struct BlockCacheHeader
+	{
+		char signature[4];
+		unsigned int version;
+		unsigned int width;
+		unsigned int height;
+		unsigned int size;
+		unsigned long long hash;
+	};
+
+	harray<TextureCompressor::Job*> TextureCompressor::jobs;
+	harray<TextureCompressor::Job*> TextureCompressor::activeJobs;
+	harray<TextureCompressor::Job*> TextureCompressor::finishedJobs;
+	hmutex TextureCompressor::queueMutex;
+
+	harray<hthread*> TextureCompressor::workerThreads;
+
+	TextureCompressor::Job::Job(Texture* texture, Image::BlockFormat blockFormat)
+	{
+		this->texture = texture;
+		this->version = texture->compressionVersion;
+		this->width = texture->width;
+		this->height = texture->height;
+		this->format = texture->format;
+		this->blockFormat = blockFormat;
+		int size = texture->_getByteSize();
+		this->data = new unsigned char[size];
+		memcpy(this->data, texture->data, size);
+		this->blockData = NULL;
+		this->blockDataSize = Image::getBlockDataSize(this->width, this->height, blockFormat);
+		this->cachePath = april::getTextureCompressionCachePath(); // read here, because the setting isn't synchronized with worker threads
+		this->canceled = false;
+	}
+
+	TextureCompressor::Job::~Job()
+	{
+		if (this->data != NULL)
+		{
+			delete[] this->data;
+		}
+		if (this->blockData != NULL)
+		{
+			delete[] this->blockData;
+		}
+	}
+
+	bool TextureCompressor::queue(Texture* texture, Image::BlockFormat blockFormat)
+	{
+		// the texture's data has to be locked by the caller
+		Job* job = new Job(texture, blockFormat);
+		hmutex::ScopeLock lock(&TextureCompressor::queueMutex);
+		for_iter (i, 0, TextureCompressor::jobs.size())
+		{
+			if (TextureCompressor::jobs[i]->texture == texture) // replace outdated job
+			{
+				delete TextureCompressor::jobs[i];
+				TextureCompressor::jobs.removeAt(i);
+				--i;
+			}
+		}
+		TextureCompressor::jobs += job;
+		lock.release();
+		TextureCompressor::_updateThreads();
+		return true;
+	}
+
+	void TextureCompressor::dequeue(Texture* texture)
+	{
+		hmutex::ScopeLock lock(&TextureCompressor::queueMutex);
+		for_iter (i, 0, TextureCompressor::jobs.size())
+		{
+			if (TextureCompressor::jobs[i]->texture == texture)
+			{
+				delete TextureCompressor::jobs[i];
+				TextureCompressor::jobs.removeAt(i);
+				--i;
+			}
+		}
+		// active jobs are deleted by the worker thread when it's done
+		foreach (Job*, it, TextureCompressor::activeJobs)
+		{
+			if ((*it)->texture == texture)
+			{
+				(*it)->canceled = true;
+			}
+		}
+		for_iter (i, 0, TextureCompressor::finishedJobs.size())
+		{
+			if (TextureCompressor::finishedJobs[i]->texture == texture)
+			{
+				delete TextureCompressor::finishedJobs[i];
+				TextureCompressor::finishedJobs.removeAt(i);
+				--i;
+			}
+		}
+	}
+
+	void TextureCompressor::update()
+	{
+		if (april::rendersys == NULL || !april::rendersys->canUseLowLevelCalls())
+		{
+			return;
+		}
+		TextureCompressor::_updateThreads();
+		hmutex::ScopeLock lock(&TextureCompressor::queueMutex);
+		if (TextureCompressor::finishedJobs.size() == 0)
+		{
+			return;
+		}
+		harray<Job*> finishedJobs = TextureCompressor::finishedJobs;
+		TextureCompressor::finishedJobs.clear();
+		lock.release();
+		// textures are only destroyed on the main thread so they can't disappear in the meantime
+		foreach (Job*, it, finishedJobs)
+		{
+			(*it)->texture->_applyBlockData((*it)->version, (*it)->blockFormat, (*it)->blockData, (*it)->blockDataSize);
+			(*it)->blockData = NULL; // the texture took over ownership
+			delete (*it);
+		}
+	}
+
+	void TextureCompressor::_updateThreads()
+	{
+		hmutex::ScopeLock lock(&TextureCompressor::queueMutex);
+		hthread* workerThread = NULL;
+		for_iter (i, 0, TextureCompressor::workerThreads.size())
+		{
+			if (!TextureCompressor::workerThreads[i]->isRunning())
+			{
+				workerThread = TextureCompressor::workerThreads.removeAt(i);
+				workerThread->join();
+				delete workerThread;
+				--i;
+			}
+		}
+		// one core is left for the main thread, encoding is a background task
+		int count = hmin(TextureCompressor::jobs.size(), hmax(april::getSystemInfo().cpuCores - 1, 1)) - TextureCompressor::workerThreads.size();
+		for_iter (i, 0, count)
+		{
+			workerThread = new hthread(&TextureCompressor::_work, "APRIL texture compressor");
+			TextureCompressor::workerThreads += workerThread;
+			workerThread->start();
+		}
+	}
+
+	unsigned long long TextureCompressor::_calcHash(Job* job)
+	{
+		hstr key = hsprintf("%d %d ", job->width, job->height) + job->format.getName() + " " + job->blockFormat.getName();
+		unsigned long long hash = hashFnv1a((const unsigned char*)key.cStr(), key.size());
+		return hashFnv1a(hash, job->data, job->width * job->height * job->format.getBpp());
+	}
+
+	bool TextureCompressor::_readCache(chstr filename, unsigned long long hash, Job* job)
+	{
+		if (!hfile::exists(filename))
+		{
+			return false;
+		}
+		hfile file;
+		file.open(filename);
+		BlockCacheHeader header;
+		if (file.readRaw(&header, sizeof(BlockCacheHeader)) != sizeof(BlockCacheHeader) || hstr(header.signature, sizeof(header.signature)) != CACHE_SIGNATURE ||
+			header.version != CACHE_VERSION || header.hash != hash || (int)header.width != job->width || (int)header.height != job->height ||
+			(int)header.size != job->blockDataSize)
+		{
+			hlog::warn(logTag, "Ignoring invalid block compression cache file: " + filename);
+			return false;
+		}
+		job->blockData = new unsigned char[job->blockDataSize];
+		if (file.readRaw(job->blockData, job->blockDataSize) != job->blockDataSize)
+		{
+			hlog::warn(logTag, "Ignoring incomplete block compression cache file: " + filename);
+			delete[] job->blockData;
+			job->blockData = NULL;
+			return false;
+		}
+		return true;
+	}
+
+	void TextureCompressor::_writeCache(chstr filename, unsigned long long hash, Job* job)
+	{
+		BlockCacheHeader header;
+		memcpy(header.signature, CACHE_SIGNATURE, sizeof(header.signature));
+		header.version = CACHE_VERSION;
+		header.width = job->width;
+		header.height = job->height;
+		header.size = job->blockDataSize;
+		header.hash = hash;
+		try
+		{
+			hdir::create(job->cachePath);
+			hfile file;
+			file.open(filename, hfaccess::Write);
+			file.writeRaw(&header, sizeof(BlockCacheHeader));
+			file.writeRaw(job->blockData, job->blockDataSize);
+		}
+		catch (hexception& e)
+		{
+			hlog::warn(logTag, "Could not write block compression cache file: " + e.getFullMessage());
+		}
+	}
+
+	void TextureCompressor::_work(hthread* thread)
+	{
+		Job* job = NULL;
+		unsigned long long hash = 0ULL;
+		hstr filename;
+		hmutex::ScopeLock lock(&TextureCompressor::queueMutex);
+		while (TextureCompressor::jobs.size() > 0)
+		{
+			job = TextureCompressor::jobs.removeFirst();
+			TextureCompressor::activeJobs += job;
+			lock.release();
+			filename = "";
+			if (job->cachePath != "")
+			{
+				hash = TextureCompressor::_calcHash(job);
+				filename = hdir::joinPath(job->cachePath, hsprintf("%016llx", hash) + CACHE_EXTENSION);
+			}
+			if (filename == "" || !TextureCompressor::_readCache(filename, hash, job))
+			{
+				if (Image::encodeBlocks(job->width, job->height, job->data, job->format, job->blockFormat, &job->blockData))
+				{
+					if (filename != "")
+					{
+						TextureCompressor::_writeCache(filename, hash, job);
+					}
+				}
+				else
+				{
+					hlog::warn(logTag, "Could not encode block compressed texture data, format: " + job->format.getName());
+				}
+			}
+			delete[] job->data; // not needed anymore
+			job->data = NULL;
+			lock.acquire(&TextureCompressor::queueMutex);
+			TextureCompressor::activeJobs -= job;
+			if (job->canceled || job->blockData == NULL)
+			{
+				delete job;
+			}
+			else
+			{
+				TextureCompressor::finishedJobs += job;
+			}
+		}
+	}
+
+}
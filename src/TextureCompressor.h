@@ -0,0 +1,78 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines utilities for runtime block compression of textures.
+
+#ifndef APRIL_TEXTURE_COMPRESSOR_H
+#define APRIL_TEXTURE_COMPRESSOR_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include "aprilExport.h"
+#include "Image.h"
+
+namespace april
+{
+	class Texture;
+
+	class TextureCompressor
+	{
+	public:
+		static bool queue(Texture* texture, Image::BlockFormat blockFormat);
+		static void dequeue(Texture* texture);
+		static void update();
+
+	protected:
+		struct Job
+		{
+		public:
+			Texture* texture;
+			int version;
+			int width;
+			int height;
+			Image::Format format;
+			Image::BlockFormat blockFormat;
+			unsigned char* data;
+			unsigned char* blockData;
+			int blockDataSize;
+			hstr cachePath;
+			bool canceled;
+
+			Job(Texture* texture, Image::BlockFormat blockFormat);
+			~Job();
+
+		};
+
+		static harray<Job*> jobs;
+		static harray<Job*> activeJobs;
+		static harray<Job*> finishedJobs;
+		static hmutex queueMutex;
+
+		static harray<hthread*> workerThreads;
+
+		static void _updateThreads();
+		static unsigned long long _calcHash(Job* job);
+		static bool _readCache(chstr filename, unsigned long long hash, Job* job);
+		static void _writeCache(chstr filename, unsigned long long hash, Job* job);
+
+		static void _work(hthread* thread);
+
+	private: // prevents inheritance and instantiation
+		TextureCompressor() { }
+		~TextureCompressor() { }
+
+	};
+
+}
+
+#endif
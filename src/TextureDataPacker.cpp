@@ -0,0 +1,178 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hthread.h>
+
+#include "april.h"
+#include "RenderSystem.h"
+#include "Texture.h"
+#include "TextureDataPacker.h"
+#include "zlibUtil.h"
+
+namespace april
+{
+	harray<TextureDataPacker::Job*> TextureDataPacker::jobs;
+	harray<TextureDataPacker::Job*> TextureDataPacker::activeJobs;
+	harray<TextureDataPacker::Job*> TextureDataPacker::finishedJobs;
+	hmutex TextureDataPacker::queueMutex;
+
+	harray<hthread*> TextureDataPacker::workerThreads;
+
+	TextureDataPacker::Job::Job(Texture* texture)
+	{
+		this->texture = texture;
+		this->version = texture->dataVersion;
+		this->size = texture->getByteSize();
+		this->data = new unsigned char[this->size];
+		memcpy(this->data, texture->data, this->size);
+		this->packedData = NULL;
+		this->packedDataSize = 0;
+		this->canceled = false;
+	}
+
+	TextureDataPacker::Job::~Job()
+	{
+		if (this->data != NULL)
+		{
+			delete[] this->data;
+		}
+		if (this->packedData != NULL)
+		{
+			delete[] this->packedData;
+		}
+	}
+
+	bool TextureDataPacker::queue(Texture* texture)
+	{
+		// the texture's data has to be locked by the caller
+		Job* job = new Job(texture);
+		hmutex::ScopeLock lock(&TextureDataPacker::queueMutex);
+		for_iter (i, 0, TextureDataPacker::jobs.size())
+		{
+			if (TextureDataPacker::jobs[i]->texture == texture) // replace outdated job
+			{
+				delete TextureDataPacker::jobs[i];
+				TextureDataPacker::jobs.removeAt(i);
+				--i;
+			}
+		}
+		TextureDataPacker::jobs += job;
+		lock.release();
+		TextureDataPacker::_updateThreads();
+		return true;
+	}
+
+	void TextureDataPacker::dequeue(Texture* texture)
+	{
+		hmutex::ScopeLock lock(&TextureDataPacker::queueMutex);
+		for_iter (i, 0, TextureDataPacker::jobs.size())
+		{
+			if (TextureDataPacker::jobs[i]->texture == texture)
+			{
+				delete TextureDataPacker::jobs[i];
+				TextureDataPacker::jobs.removeAt(i);
+				--i;
+			}
+		}
+		// active jobs are deleted by the worker thread when it's done
+		foreach (Job*, it, TextureDataPacker::activeJobs)
+		{
+			if ((*it)->texture == texture)
+			{
+				(*it)->canceled = true;
+			}
+		}
+		for_iter (i, 0, TextureDataPacker::finishedJobs.size())
+		{
+			if (TextureDataPacker::finishedJobs[i]->texture == texture)
+			{
+				delete TextureDataPacker::finishedJobs[i];
+				TextureDataPacker::finishedJobs.removeAt(i);
+				--i;
+			}
+		}
+	}
+
+	void TextureDataPacker::update()
+	{
+		TextureDataPacker::_updateThreads();
+		hmutex::ScopeLock lock(&TextureDataPacker::queueMutex);
+		if (TextureDataPacker::finishedJobs.size() == 0)
+		{
+			return;
+		}
+		harray<Job*> finishedJobs = TextureDataPacker::finishedJobs;
+		TextureDataPacker::finishedJobs.clear();
+		lock.release();
+		// textures are only destroyed on the main thread so they can't disappear in the meantime
+		foreach (Job*, it, finishedJobs)
+		{
+			(*it)->texture->_applyPackedData((*it)->version, (*it)->packedData, (*it)->packedDataSize);
+			(*it)->packedData = NULL; // the texture took over ownership
+			delete (*it);
+		}
+	}
+
+	void TextureDataPacker::_updateThreads()
+	{
+		hmutex::ScopeLock lock(&TextureDataPacker::queueMutex);
+		hthread* workerThread = NULL;
+		for_iter (i, 0, TextureDataPacker::workerThreads.size())
+		{
+			if (!TextureDataPacker::workerThreads[i]->isRunning())
+			{
+				workerThread = TextureDataPacker::workerThreads.removeAt(i);
+				workerThread->join();
+				delete workerThread;
+				--i;
+			}
+		}
+		// packing only saves memory, so a single thread is enough and leaves the other cores alone
+		if (TextureDataPacker::jobs.size() > 0 && TextureDataPacker::workerThreads.size() == 0)
+		{
+			workerThread = new hthread(&TextureDataPacker::_work, "APRIL texture data packer");
+			TextureDataPacker::workerThreads += workerThread;
+			workerThread->start();
+		}
+	}
+
+	void TextureDataPacker::_work(hthread* thread)
+	{
+		Job* job = NULL;
+		hmutex::ScopeLock lock(&TextureDataPacker::queueMutex);
+		while (TextureDataPacker::jobs.size() > 0)
+		{
+			job = TextureDataPacker::jobs.removeFirst();
+			TextureDataPacker::activeJobs += job;
+			lock.release();
+			job->packedData = zlibCompress(job->size, job->data, &job->packedDataSize);
+			if (job->packedData != NULL && job->packedDataSize >= job->size) // e.g. noise doesn't compress
+			{
+				delete[] job->packedData;
+				job->packedData = NULL;
+			}
+			delete[] job->data; // not needed anymore
+			job->data = NULL;
+			lock.acquire(&TextureDataPacker::queueMutex);
+			TextureDataPacker::activeJobs -= job;
+			if (job->canceled || job->packedData == NULL)
+			{
+				delete job;
+			}
+			else
+			{
+				TextureDataPacker::finishedJobs += job;
+			}
+		}
+	}
+
+}
@@ -0,0 +1,69 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines utilities for packing idle texture data in RAM in the background.
+
+#ifndef APRIL_TEXTURE_DATA_PACKER_H
+#define APRIL_TEXTURE_DATA_PACKER_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hthread.h>
+
+#include "aprilExport.h"
+
+namespace april
+{
+	class Texture;
+
+	class TextureDataPacker
+	{
+	public:
+		static bool queue(Texture* texture);
+		static void dequeue(Texture* texture);
+		static void update();
+
+	protected:
+		struct Job
+		{
+		public:
+			Texture* texture;
+			int version;
+			int size;
+			unsigned char* data;
+			unsigned char* packedData;
+			int packedDataSize;
+			bool canceled;
+
+			Job(Texture* texture);
+			~Job();
+
+		};
+
+		static harray<Job*> jobs;
+		static harray<Job*> activeJobs;
+		static harray<Job*> finishedJobs;
+		static hmutex queueMutex;
+
+		static harray<hthread*> workerThreads;
+
+		static void _updateThreads();
+
+		static void _work(hthread* thread);
+
+	private: // prevents inheritance and instantiation
+		TextureDataPacker() { }
+		~TextureDataPacker() { }
+
+	};
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include <hltypes/harray.h>
+
+#include "Texture.h"
+#include "TextureAsync.h"
+#include "TextureLoadGroup.h"
+
+namespace april
+{
+	TextureLoadGroup::TextureLoadGroup(void (*callback)(TextureLoadGroup* group, bool success, void* userData), void* userData)
+	{
+		this->callback = callback;
+		this->userData = userData;
+		this->completed = true; // an empty group has nothing to wait for
+		this->successful = true;
+		this->callbackQueued = false;
+	}
+
+	TextureLoadGroup::~TextureLoadGroup()
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		if (TextureAsync::groups.has(this))
+		{
+			TextureAsync::groups -= this;
+		}
+	}
+
+	harray<Texture*> TextureLoadGroup::getTextures()
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		return this->textures;
+	}
+
+	int TextureLoadGroup::getPendingCount()
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		return this->pendingTextures.size();
+	}
+
+	bool TextureLoadGroup::isCompleted()
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		return this->completed;
+	}
+
+	bool TextureLoadGroup::isSuccessful()
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		return this->successful;
+	}
+
+	void TextureLoadGroup::add(Texture* texture)
+	{
+		harray<Texture*> textures;
+		textures += texture;
+		this->add(textures);
+	}
+
+	void TextureLoadGroup::add(const harray<Texture*>& textures)
+	{
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		for_iter (i, 0, textures.size())
+		{
+			if (!this->textures.has(textures[i]))
+			{
+				this->textures += textures[i];
+				this->pendingTextures += textures[i];
+				this->completed = false;
+				this->callbackQueued = false;
+			}
+		}
+		// groups are only registered once they contain textures so they can be created before anything else
+		if (!TextureAsync::groups.has(this))
+		{
+			TextureAsync::groups += this;
+		}
+	}
+
+	bool TextureLoadGroup::loadAsync(Texture::LoadPriority priority, float deadline)
+	{
+		harray<Texture*> textures = this->getTextures();
+		bool result = false;
+		foreach (Texture*, it, textures)
+		{
+			if ((*it)->loadAsync(priority, deadline))
+			{
+				result = true;
+			}
+		}
+		return result;
+	}
+
+	bool TextureLoadGroup::wait(float timeout)
+	{
+		std::chrono::steady_clock::time_point endTime = TextureAsync::_getWaitEndTime(timeout);
+		std::unique_lock<std::mutex> lock(TextureAsync::callbackMutex);
+		while (!this->completed)
+		{
+			if (!TextureAsync::_wait(lock, TextureAsync::loadedCondition, timeout, endTime))
+			{
+				break;
+			}
+		}
+		return this->completed;
+	}
+
+}
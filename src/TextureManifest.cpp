@@ -0,0 +1,112 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hdir.h>
+#include <hltypes/hfile.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hrdir.h>
+#include <hltypes/hresource.h>
+#include <hltypes/hstring.h>
+
+#include "april.h"
+#include "TextureManifest.h"
+
+namespace april
+{
+	hmap<hstr, hmap<hstr, bool> > TextureManifest::resourceDirectories;
+	hmap<hstr, hmap<hstr, bool> > TextureManifest::fileDirectories;
+	hmutex TextureManifest::mutex;
+
+	hstr TextureManifest::find(chstr filename, bool fromResource, bool includeExtension)
+	{
+		harray<hstr> extensions = april::getTextureExtensions();
+		hstr result = TextureManifest::_find(filename, extensions, fromResource, includeExtension, false);
+		if (result == "")
+		{
+			// listings are case sensitive while some file systems and archives aren't, so a miss is confirmed the slow way
+			result = TextureManifest::_find(filename, extensions, fromResource, includeExtension, true);
+		}
+		return result;
+	}
+
+	void TextureManifest::invalidate(chstr path)
+	{
+		hmutex::ScopeLock lock(&TextureManifest::mutex);
+		// the path can be either a changed directory or a changed file within a directory
+		hstr directory = hdir::baseDir(path);
+		TextureManifest::resourceDirectories.removeKey(path);
+		TextureManifest::resourceDirectories.removeKey(directory);
+		TextureManifest::fileDirectories.removeKey(path);
+		TextureManifest::fileDirectories.removeKey(directory);
+	}
+
+	void TextureManifest::clear()
+	{
+		hmutex::ScopeLock lock(&TextureManifest::mutex);
+		TextureManifest::resourceDirectories.clear();
+		TextureManifest::fileDirectories.clear();
+	}
+
+	hstr TextureManifest::_find(chstr filename, const harray<hstr>& extensions, bool fromResource, bool includeExtension, bool probe)
+	{
+		if (TextureManifest::_exists(filename, fromResource, probe))
+		{
+			return filename;
+		}
+		hstr name;
+		foreach (hstr, it, extensions)
+		{
+			name = filename + (*it);
+			if (TextureManifest::_exists(name, fromResource, probe))
+			{
+				return (includeExtension ? name : filename);
+			}
+		}
+		hstr noExtensionName = hfile::withoutExtension(filename);
+		if (noExtensionName != filename)
+		{
+			foreach (hstr, it, extensions)
+			{
+				name = noExtensionName + (*it);
+				if (TextureManifest::_exists(name, fromResource, probe))
+				{
+					return (includeExtension ? name : noExtensionName);
+				}
+			}
+		}
+		return "";
+	}
+
+	bool TextureManifest::_exists(chstr filename, bool fromResource, bool probe)
+	{
+		if (probe)
+		{
+			return (fromResource ? hresource::exists(filename) : hfile::exists(filename));
+		}
+		hstr directory = hdir::baseDir(filename);
+		hmap<hstr, hmap<hstr, bool> >& directories = (fromResource ? TextureManifest::resourceDirectories : TextureManifest::fileDirectories);
+		hmutex::ScopeLock lock(&TextureManifest::mutex);
+		if (!directories.hasKey(directory))
+		{
+			lock.release();
+			// scanning is done without the lock so other threads don't have to wait for it
+			harray<hstr> files = (fromResource ? hrdir::files(directory) : hdir::files(directory));
+			hmap<hstr, bool> entries;
+			foreach (hstr, it, files)
+			{
+				entries[(*it)] = true;
+			}
+			lock.acquire(&TextureManifest::mutex);
+			directories[directory] = entries;
+		}
+		return directories[directory].hasKey(hdir::baseName(filename));
+	}
+
+}
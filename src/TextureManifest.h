@@ -0,0 +1,49 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines utilities for looking up texture filenames without probing the file system on every call.
+
+#ifndef APRIL_TEXTURE_MANIFEST_H
+#define APRIL_TEXTURE_MANIFEST_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "aprilExport.h"
+
+namespace april
+{
+	class TextureManifest
+	{
+	public:
+		static hstr find(chstr filename, bool fromResource, bool includeExtension);
+		static void invalidate(chstr path);
+		static void clear();
+
+	protected:
+		// directory listings, scanned once per directory and used as a set of contained filenames
+		static hmap<hstr, hmap<hstr, bool> > resourceDirectories;
+		static hmap<hstr, hmap<hstr, bool> > fileDirectories;
+		static hmutex mutex;
+
+		static hstr _find(chstr filename, const harray<hstr>& extensions, bool fromResource, bool includeExtension, bool probe);
+		static bool _exists(chstr filename, bool fromResource, bool probe);
+
+	private: // prevents inheritance and instantiation
+		TextureManifest() { }
+		~TextureManifest() { }
+
+	};
+
+}
+
+#endif
@@ -165,18 +165,36 @@ namespace april
 	static hversion version(5, 2, 0);
 
 #ifdef _IOS
-	static harray<hstr> extensions = hstr(".jpt,.png,.jpg,.pvrz,.pvr").split(',');
+	static harray<hstr> extensions = hstr(".jpt,.png,.jpg,.qoi,.pvrz,.pvr").split(',');
 #elif __ANDROID__
-	static harray<hstr> extensions = hstr(".jpt,.png,.jpg,.etcx").split(',');
+	static harray<hstr> extensions = hstr(".jpt,.png,.jpg,.qoi,.etcx").split(',');
 #else
-	static harray<hstr> extensions = hstr(".jpt,.png,.jpg").split(',');
+	static harray<hstr> extensions = hstr(".jpt,.png,.jpg,.qoi").split(',');
 #endif
 	static int maxAsyncTextureUploadsPerFrame = 0;
+	static int64_t asyncTextureUploadBytesPerFrame = 0LL;
+	static float asyncTextureUploadTimePerFrame = 0.0f;
+	static int asyncTextureUploadTileSize = 1048576;
+	static bool asyncTextureUploadThreadEnabled = true;
 #if defined(__ANDROID__) || defined(_IOS) || defined(_UWP) && defined(_WINHONE)
 	static int maxWaitingAsyncTextures = 8; // to limit RAM consumption
 #else
 	static int maxWaitingAsyncTextures = 0;
 #endif
+	static int asyncTextureReaderThreads = 4;
+	static int asyncTextureDecoderThreads = 0;
+	static int maxTextureLoadDimension = 0;
+	static float textureLoadScale = 1.0f;
+	static hstr textureCompressionCachePath = "";
+	static hstr textureCachePath = "";
+	static int64_t textureCacheMaxSize = 268435456LL; // 256 MB
+	static hstr textureProxySuffix = "";
+	static int64_t textureVRamBudget = 0LL;
+	static int64_t textureRamBudget = 0LL;
+	static int textureAtlasMaxDimension = 0;
+	static int textureAtlasPageSize = 1024;
+	static int textureAtlasPadding = 2;
+	static int renderTargetPoolMaxIdleFrames = 60;
 	static int exitCode = 0;
 	hmap<hstr, april::Color> symbolicColors;
 
@@ -476,6 +494,46 @@ namespace april
 		maxAsyncTextureUploadsPerFrame = value;
 	}
 
+	int64_t getAsyncTextureUploadBytesPerFrame()
+	{
+		return asyncTextureUploadBytesPerFrame;
+	}
+
+	void setAsyncTextureUploadBytesPerFrame(int64_t value)
+	{
+		asyncTextureUploadBytesPerFrame = value;
+	}
+
+	float getAsyncTextureUploadTimePerFrame()
+	{
+		return asyncTextureUploadTimePerFrame;
+	}
+
+	void setAsyncTextureUploadTimePerFrame(float value)
+	{
+		asyncTextureUploadTimePerFrame = value;
+	}
+
+	int getAsyncTextureUploadTileSize()
+	{
+		return asyncTextureUploadTileSize;
+	}
+
+	void setAsyncTextureUploadTileSize(int value)
+	{
+		asyncTextureUploadTileSize = value;
+	}
+
+	bool isAsyncTextureUploadThreadEnabled()
+	{
+		return asyncTextureUploadThreadEnabled;
+	}
+
+	void setAsyncTextureUploadThreadEnabled(bool value)
+	{
+		asyncTextureUploadThreadEnabled = value;
+	}
+
 	int getMaxWaitingAsyncTextures()
 	{
 		return maxWaitingAsyncTextures;
@@ -486,6 +544,146 @@ namespace april
 		maxWaitingAsyncTextures = value;
 	}
 
+	int getAsyncTextureReaderThreads()
+	{
+		return asyncTextureReaderThreads;
+	}
+
+	void setAsyncTextureReaderThreads(int value)
+	{
+		asyncTextureReaderThreads = value;
+	}
+
+	int getAsyncTextureDecoderThreads()
+	{
+		return asyncTextureDecoderThreads;
+	}
+
+	void setAsyncTextureDecoderThreads(int value)
+	{
+		asyncTextureDecoderThreads = value;
+	}
+
+	int getMaxTextureLoadDimension()
+	{
+		return maxTextureLoadDimension;
+	}
+
+	void setMaxTextureLoadDimension(int value)
+	{
+		maxTextureLoadDimension = value;
+	}
+
+	float getTextureLoadScale()
+	{
+		return textureLoadScale;
+	}
+
+	void setTextureLoadScale(float value)
+	{
+		textureLoadScale = value;
+	}
+
+	hstr getTextureCompressionCachePath()
+	{
+		return textureCompressionCachePath;
+	}
+
+	void setTextureCompressionCachePath(chstr value)
+	{
+		textureCompressionCachePath = value;
+	}
+
+	hstr getTextureCachePath()
+	{
+		return textureCachePath;
+	}
+
+	void setTextureCachePath(chstr value)
+	{
+		textureCachePath = value;
+	}
+
+	int64_t getTextureCacheMaxSize()
+	{
+		return textureCacheMaxSize;
+	}
+
+	void setTextureCacheMaxSize(int64_t value)
+	{
+		textureCacheMaxSize = value;
+	}
+
+	hstr getTextureProxySuffix()
+	{
+		return textureProxySuffix;
+	}
+
+	void setTextureProxySuffix(chstr value)
+	{
+		textureProxySuffix = value;
+	}
+
+	int64_t getTextureVRamBudget()
+	{
+		return textureVRamBudget;
+	}
+
+	void setTextureVRamBudget(int64_t value)
+	{
+		textureVRamBudget = value;
+	}
+
+	int64_t getTextureRamBudget()
+	{
+		return textureRamBudget;
+	}
+
+	void setTextureRamBudget(int64_t value)
+	{
+		textureRamBudget = value;
+	}
+
+	int getTextureAtlasMaxDimension()
+	{
+		return textureAtlasMaxDimension;
+	}
+
+	void setTextureAtlasMaxDimension(int value)
+	{
+		textureAtlasMaxDimension = value;
+	}
+
+	int getTextureAtlasPageSize()
+	{
+		return textureAtlasPageSize;
+	}
+
+	void setTextureAtlasPageSize(int value)
+	{
+		textureAtlasPageSize = hmax(value, 1);
+	}
+
+	int getTextureAtlasPadding()
+	{
+		return textureAtlasPadding;
+	}
+
+	void setTextureAtlasPadding(int value)
+	{
+		textureAtlasPadding = hmax(value, 0);
+	}
+
+	int getRenderTargetPoolMaxIdleFrames()
+	{
+		return renderTargetPoolMaxIdleFrames;
+	}
+
+	void setRenderTargetPoolMaxIdleFrames(int value)
+	{
+		renderTargetPoolMaxIdleFrames = hmax(value, 0);
+	}
+
 	int getExitCode()
 	{
 		return exitCode;
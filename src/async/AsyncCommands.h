@@ -18,6 +18,7 @@
 #include "ClearCommand.h"
 #include "ClearDepthCommand.h"
 #include "ClearColorCommand.h"
+#include "CopyTextureCommand.h"
 #include "CreateCommand.h"
 #include "CreateWindowCommand.h"
 #include "CustomCommand.h"
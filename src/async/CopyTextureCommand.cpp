@@ -0,0 +1,28 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "CopyTextureCommand.h"
+#include "RenderSystem.h"
+
+namespace april
+{
+	CopyTextureCommand::CopyTextureCommand(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect) :
+		AsyncCommand()
+	{
+		this->source = source;
+		this->destination = destination;
+		this->sourceRect = sourceRect;
+		this->destinationRect = destinationRect;
+	}
+	
+	void CopyTextureCommand::execute()
+	{
+		april::rendersys->_copyTexture(this->source, this->destination, this->sourceRect, this->destinationRect);
+	}
+	
+}
@@ -0,0 +1,40 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a copy texture command.
+
+#ifndef APRIL_COPY_TEXTURE_COMMAND_H
+#define APRIL_COPY_TEXTURE_COMMAND_H
+
+#include <gtypes/Rectangle.h>
+
+#include "AsyncCommand.h"
+
+namespace april
+{
+	class Texture;
+
+	class CopyTextureCommand : public AsyncCommand
+	{
+	public:
+		CopyTextureCommand(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect);
+		
+		void execute() override;
+
+	protected:
+		Texture* source;
+		Texture* destination;
+		grecti sourceRect;
+		grecti destinationRect;
+
+	};
+	
+}
+#endif
@@ -23,6 +23,7 @@ namespace april
 	{
 		RenderCommand::execute();
 		april::rendersys->_devicePresentFrame(this->systemEnabled);
+		april::rendersys->_updateTextureResidency();
 		april::rendersys->_updateDeviceState(&this->state, true);
 	}
 	
@@ -34,7 +34,7 @@ namespace april
 		void execute() override
 		{
 			RenderCommand::execute();
-			april::rendersys->_deviceRender(this->renderOperation, (T*)this->vertices, this->vertices.size());
+			april::rendersys->_deviceRender(this->renderOperation, april::rendersys->_useDeviceAtlasVertices((T*)this->vertices, this->vertices.size()), this->vertices.size());
 		}
 
 	protected:
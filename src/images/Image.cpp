@@ -240,6 +240,7 @@ namespace april
 	(
 		HL_ENUM_DEFINE(Image::FileFormat, Png);
 		HL_ENUM_DEFINE(Image::FileFormat, Jpeg);
+		HL_ENUM_DEFINE(Image::FileFormat, Qoi);
 		HL_ENUM_DEFINE(Image::FileFormat, Custom);
 
 		Image::SaveParameters Image::FileFormat::makeDefaultParameters(chstr customExtension) const
@@ -268,6 +269,7 @@ namespace april
 
 	hmap<hstr, Image* (*)(hsbase&)> Image::customLoaders;
 	hmap<hstr, Image* (*)(hsbase&)> Image::customMetaDataLoaders;
+	hmap<hstr, Image* (*)(hsbase&, int, float)> Image::customScaledLoaders;
 	hmap<hstr, bool (*)(hsbase&, Image*, Image::SaveParameters)> Image::customSavers;
 	hmap<hstr, Image::SaveParameters (*)()> Image::customSaverDefaultParameters;
 
@@ -307,9 +309,23 @@ namespace april
 
 	int Image::getByteSize() const
 	{
+		if (this->compressedSize > 0)
+		{
+			return this->compressedSize;
+		}
 		return (this->w * this->h * this->format.getBpp());
 	}
 
+	unsigned char* Image::getPalette() const
+	{
+		return (this->format == Format::Palette ? this->data : NULL);
+	}
+
+	unsigned char* Image::getPaletteIndices() const
+	{
+		return (this->format == Format::Palette && this->data != NULL ? &this->data[APRIL_IMAGE_PALETTE_BYTE_SIZE] : NULL);
+	}
+
 	bool Image::isValid() const
 	{
 		return (this->data != NULL && this->getByteSize() > 0);
@@ -395,6 +411,67 @@ namespace april
 		return (this->isValid() && Image::dilate(srcData, srcWidth, srcHeight, srcFormat, this->data, this->w, this->h, this->format));
 	}
 
+	bool Image::downscale(int divisor)
+	{
+		if (!this->isValid() || divisor < 1)
+		{
+			return false;
+		}
+		if (divisor == 1)
+		{
+			return true;
+		}
+		if (this->format == Format::Compressed || (this->compressedSize > 0 && this->format != Format::Palette))
+		{
+			hlog::error(logTag, "Cannot downscale compressed image data!");
+			return false;
+		}
+		int destWidth = (this->w + divisor - 1) / divisor;
+		int destHeight = (this->h + divisor - 1) / divisor;
+		unsigned char* destData = NULL;
+		if (this->format == Format::Palette)
+		{
+			// indices can't be averaged so the top-left pixel of every block is used
+			destData = new unsigned char[APRIL_IMAGE_PALETTE_BYTE_SIZE + destWidth * destHeight];
+			memcpy(destData, this->data, APRIL_IMAGE_PALETTE_BYTE_SIZE);
+			unsigned char* srcIndices = &this->data[APRIL_IMAGE_PALETTE_BYTE_SIZE];
+			unsigned char* destIndices = &destData[APRIL_IMAGE_PALETTE_BYTE_SIZE];
+			for_iter (j, 0, destHeight)
+			{
+				for_iter (i, 0, destWidth)
+				{
+					destIndices[i + j * destWidth] = srcIndices[i * divisor + j * divisor * this->w];
+				}
+			}
+			this->compressedSize = APRIL_IMAGE_PALETTE_BYTE_SIZE + destWidth * destHeight;
+		}
+		else
+		{
+			int bpp = this->getBpp();
+			int srcStride = this->w * bpp;
+			int destStride = destWidth * bpp;
+			destData = new unsigned char[destStride * destHeight];
+			unsigned int* sums = new unsigned int[destStride];
+			memset(sums, 0, destStride * sizeof(unsigned int));
+			int rowCount = 0;
+			for_iter (j, 0, destHeight)
+			{
+				rowCount = hmin(divisor, this->h - j * divisor);
+				for_iter (k, 0, rowCount)
+				{
+					Image::_boxFilterAddRow(&this->data[(j * divisor + k) * srcStride], this->w, bpp, divisor, sums);
+				}
+				Image::_boxFilterWriteRow(sums, this->w, bpp, divisor, rowCount, &destData[j * destStride]);
+			}
+			delete[] sums;
+		}
+		delete[] this->data;
+		this->data = destData;
+		this->w = destWidth;
+		this->h = destHeight;
+		return true;
+	}
+
 	Image* Image::extractRed() const
 	{
 		return this->extractColor(this->format.getIndexRed());
@@ -596,6 +673,11 @@ namespace april
 			file.open(filename);
 			return Image::_loadJpt(file);
 		}
+		if (filename.lowered().endsWith(".qoi"))
+		{
+			file.open(filename);
+			return Image::_loadQoi(file);
+		}
 #ifdef _IMAGE_PVR
 		if (filename.lowered().endsWith(".pvr"))
 		{
@@ -628,6 +710,18 @@ namespace april
 
 	Image* Image::createFromResource(chstr filename, Image::Format format)
 	{
+		if (filename.lowered().endsWith(".qoi"))
+		{
+			hresource file;
+			file.open(filename);
+			return Image::_loadQoi(file, (int)file.size(), format);
+		}
+		if (format == Format::Palette && filename.lowered().endsWith(".png"))
+		{
+			hresource file;
+			file.open(filename);
+			return Image::_loadPng(file, (int)file.size(), true, 0, 1.0f);
+		}
 		Image* image = Image::createFromResource(filename);
 		if (image != NULL && Image::needsConversion(image->format, format))
 		{
@@ -660,6 +754,11 @@ namespace april
 			file.open(filename);
 			return Image::_loadJpt(file);
 		}
+		if (filename.lowered().endsWith(".qoi"))
+		{
+			file.open(filename);
+			return Image::_loadQoi(file);
+		}
 #ifdef _IMAGE_PVR
 		if (filename.lowered().endsWith(".pvr"))
 		{
@@ -692,6 +791,18 @@ namespace april
 
 	Image* Image::createFromFile(chstr filename, Image::Format format)
 	{
+		if (filename.lowered().endsWith(".qoi"))
+		{
+			hfile file;
+			file.open(filename);
+			return Image::_loadQoi(file, (int)file.size(), format);
+		}
+		if (format == Format::Palette && filename.lowered().endsWith(".png"))
+		{
+			hfile file;
+			file.open(filename);
+			return Image::_loadPng(file, (int)file.size(), true, 0, 1.0f);
+		}
 		Image* image = Image::createFromFile(filename);
 		if (image != NULL && Image::needsConversion(image->format, format))
 		{
@@ -720,6 +831,10 @@ namespace april
 		{
 			return Image::_loadJpt(stream);
 		}
+		if (logicalExtension.lowered().endsWith(".qoi"))
+		{
+			return Image::_loadQoi(stream);
+		}
 #ifdef _IMAGE_PVR
 		if (logicalExtension.lowered().endsWith(".pvr"))
 		{
@@ -748,6 +863,14 @@ namespace april
 
 	Image* Image::createFromStream(hsbase& stream, chstr logicalExtension, Image::Format format)
 	{
+		if (logicalExtension.lowered().endsWith(".qoi"))
+		{
+			return Image::_loadQoi(stream, (int)stream.size(), format);
+		}
+		if (format == Format::Palette && logicalExtension.lowered().endsWith(".png"))
+		{
+			return Image::_loadPng(stream, (int)stream.size(), true, 0, 1.0f);
+		}
 		Image* image = Image::createFromStream(stream, logicalExtension);
 		if (image != NULL && Image::needsConversion(image->format, format))
 		{
@@ -762,13 +885,88 @@ namespace april
 		return image;
 	}
 
+	Image* Image::createFromResource(chstr filename, int maxDimension, float scale)
+	{
+		if (Image::_canDownscaleWhileDecoding(filename))
+		{
+			hresource file;
+			file.open(filename);
+			return Image::createFromStream(file, filename, maxDimension, scale);
+		}
+		Image* image = Image::createFromResource(filename);
+		if (image != NULL && image->compressedSize == 0) // compressed data can't be downscaled
+		{
+			image->downscale(Image::calcDownscaleDivisor(image->w, image->h, maxDimension, scale));
+		}
+		return image;
+	}
+
+	Image* Image::createFromFile(chstr filename, int maxDimension, float scale)
+	{
+		if (Image::_canDownscaleWhileDecoding(filename))
+		{
+			hfile file;
+			file.open(filename);
+			return Image::createFromStream(file, filename, maxDimension, scale);
+		}
+		Image* image = Image::createFromFile(filename);
+		if (image != NULL && image->compressedSize == 0) // compressed data can't be downscaled
+		{
+			image->downscale(Image::calcDownscaleDivisor(image->w, image->h, maxDimension, scale));
+		}
+		return image;
+	}
+
+	Image* Image::createFromStream(hsbase& stream, chstr logicalExtension, int maxDimension, float scale)
+	{
+		if (logicalExtension.lowered().endsWith(".png"))
+		{
+			return Image::_loadPng(stream, (int)stream.size(), false, maxDimension, scale);
+		}
+		if (logicalExtension.lowered().endsWith(".jpg") || logicalExtension.lowered().endsWith(".jpeg"))
+		{
+			return Image::_loadJpg(stream, (int)stream.size(), maxDimension, scale);
+		}
+		foreach_m (Image* (*)(hsbase&, int, float), it, Image::customScaledLoaders)
+		{
+			if (logicalExtension.lowered().endsWith(it->first.lowered()))
+			{
+				return (*it->second)(stream, maxDimension, scale);
+			}
+		}
+		// other decoders can't downscale while decoding
+		Image* image = Image::createFromStream(stream, logicalExtension);
+		if (image != NULL && image->compressedSize == 0) // compressed data can't be downscaled
+		{
+			image->downscale(Image::calcDownscaleDivisor(image->w, image->h, maxDimension, scale));
+		}
+		return image;
+	}
+
+	bool Image::_canDownscaleWhileDecoding(chstr filename)
+	{
+		hstr lowered = filename.lowered();
+		if (lowered.endsWith(".png") || lowered.endsWith(".jpg") || lowered.endsWith(".jpeg"))
+		{
+			return true;
+		}
+		foreach_m (Image* (*)(hsbase&, int, float), it, Image::customScaledLoaders)
+		{
+			if (lowered.endsWith(it->first.lowered()))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	Image* Image::create(int w, int h, unsigned char* data, Image::Format format)
 	{
 		Image* image = new Image();
 		image->w = w;
 		image->h = h;
 		image->format = format;
-		image->compressedSize = 0;
+		image->compressedSize = (format == Format::Palette ? APRIL_IMAGE_PALETTE_BYTE_SIZE + w * h : 0);
 		int size = image->getByteSize();
 		image->data = NULL;
 		if (data != NULL && size > 0)
@@ -831,6 +1029,12 @@ namespace april
 			file.open(filename, hfaccess::Write);
 			return Image::_saveJpeg(file, image, parameters);
 		}
+		if (format == FileFormat::Qoi)
+		{
+			hfile file;
+			file.open(filename, hfaccess::Write);
+			return Image::_saveQoi(file, image, parameters);
+		}
 		if (format == FileFormat::Custom && Image::customSavers.hasKey(customExtension))
 		{
 			hfile file;
@@ -858,6 +1062,11 @@ namespace april
 			file.open(filename);
 			return Image::_readMetaDataJpt(file);
 		}
+		if (filename.lowered().endsWith(".qoi"))
+		{
+			file.open(filename);
+			return Image::_readMetaDataQoi(file);
+		}
 #ifdef _IMAGE_PVR
 		if (filename.lowered().endsWith(".pvr"))
 		{
@@ -906,6 +1115,11 @@ namespace april
 			file.open(filename);
 			return Image::_readMetaDataJpt(file);
 		}
+		if (filename.lowered().endsWith(".qoi"))
+		{
+			file.open(filename);
+			return Image::_readMetaDataQoi(file);
+		}
 #ifdef _IMAGE_PVR
 		if (filename.lowered().endsWith(".pvr"))
 		{
@@ -950,6 +1164,10 @@ namespace april
 		{
 			return Image::_readMetaDataJpt(stream);
 		}
+		if (logicalExtension.lowered().endsWith(".qoi"))
+		{
+			return Image::_readMetaDataQoi(stream);
+		}
 #ifdef _IMAGE_PVR
 		if (logicalExtension.lowered().endsWith(".pvr"))
 		{
@@ -2043,7 +2261,14 @@ namespace april
 		{
 			return true;
 		}
-		if (srcBpp == 1)
+		if (srcFormat == Format::Palette)
+		{
+			if (Image::_convertFromPalette(w, h, srcData, destData, destFormat))
+			{
+				return true;
+			}
+		}
+		else if (srcBpp == 1)
 		{
 			if (Image::_convertFrom1Bpp(w, h, srcData, srcFormat, destData, destFormat))
 			{
@@ -2371,12 +2596,176 @@ namespace april
 		return false;
 	}
 
+	bool Image::_convertFromPalette(int w, int h, unsigned char* srcData, unsigned char** destData, Format destFormat)
+	{
+		int destBpp = destFormat.getBpp();
+		if (destBpp != 1 && destBpp != 3 && destBpp != 4)
+		{
+			return false;
+		}
+		// the palette is converted only once, afterwards every pixel is a single table lookup
+		unsigned int lookupData[APRIL_IMAGE_PALETTE_COLORS] = { 0 };
+		unsigned char* lookup = (unsigned char*)lookupData;
+		if (destFormat == Format::Alpha)
+		{
+			for_iter (i, 0, APRIL_IMAGE_PALETTE_COLORS)
+			{
+				lookup[i] = srcData[i * 4 + 3];
+			}
+		}
+		else if (!Image::_convertFrom4Bpp(APRIL_IMAGE_PALETTE_COLORS, 1, srcData, Format::RGBA, &lookup, destFormat))
+		{
+			return false;
+		}
+		int size = w * h;
+		if (*destData == NULL)
+		{
+			*destData = new unsigned char[size * destBpp];
+		}
+		unsigned char* indices = &srcData[APRIL_IMAGE_PALETTE_BYTE_SIZE];
+		unsigned char* dest = *destData;
+		if (destBpp == 4)
+		{
+			for_iter (i, 0, size)
+			{
+				memcpy(&dest[i * 4], &lookupData[indices[i]], 4);
+			}
+		}
+		else if (destBpp == 3)
+		{
+			for_iter (i, 0, size)
+			{
+				memcpy(&dest[i * 3], &lookup[indices[i] * 3], 3);
+			}
+		}
+		else
+		{
+			for_iter (i, 0, size)
+			{
+				dest[i] = lookup[indices[i]];
+			}
+		}
+		return true;
+	}
+
+	void Image::_boxFilterAddRow(const unsigned char* srcRow, int srcWidth, int bpp, int divisor, unsigned int* sums)
+	{
+		unsigned int* sum = NULL;
+		for_iter (i, 0, srcWidth)
+		{
+			sum = &sums[(i / divisor) * bpp];
+			for_iter (k, 0, bpp)
+			{
+				sum[k] += srcRow[k];
+			}
+			srcRow += bpp;
+		}
+	}
+
+	void Image::_boxFilterWriteRow(unsigned int* sums, int srcWidth, int bpp, int divisor, int rowCount, unsigned char* destRow)
+	{
+		int destWidth = (srcWidth + divisor - 1) / divisor;
+		unsigned int count = 0;
+		for_iter (i, 0, destWidth)
+		{
+			// the last block in a row can be narrower than the divisor
+			count = (unsigned int)(hmin(divisor, srcWidth - i * divisor) * rowCount);
+			for_iter (k, 0, bpp)
+			{
+				destRow[k] = (unsigned char)((sums[k] + count / 2) / count);
+				sums[k] = 0;
+			}
+			sums += bpp;
+			destRow += bpp;
+		}
+	}
+
+	int Image::calcDownscaleDivisor(int w, int h, int maxDimension, float scale)
+	{
+		int divisor = 1;
+		if (scale > 0.0f && scale < 1.0f)
+		{
+			while (divisor * 2 * scale <= 1.0f)
+			{
+				divisor *= 2;
+			}
+		}
+		if (maxDimension > 0)
+		{
+			while ((w + divisor - 1) / divisor > maxDimension || (h + divisor - 1) / divisor > maxDimension)
+			{
+				divisor *= 2;
+			}
+		}
+		return divisor;
+	}
+
+	int Image::calcMipmapLevels(int w, int h)
+	{
+		int levels = 1;
+		while (w > 1 || h > 1)
+		{
+			w = hmax(w / 2, 1);
+			h = hmax(h / 2, 1);
+			++levels;
+		}
+		return levels;
+	}
+
+	int Image::calcMipmapChainSize(int w, int h, int bpp, int levels)
+	{
+		int result = 0;
+		for_iter (i, 0, levels)
+		{
+			result += w * h * bpp;
+			w = hmax(w / 2, 1);
+			h = hmax(h / 2, 1);
+		}
+		return result;
+	}
+
+	bool Image::createMipmapLevel(int w, int h, unsigned char* srcData, Format srcFormat, unsigned char** destData)
+	{
+		if (srcData == NULL || w < 1 || h < 1 || srcFormat == Format::Compressed || srcFormat == Format::Palette || srcFormat == Format::Invalid)
+		{
+			return false;
+		}
+		int bpp = srcFormat.getBpp();
+		int destWidth = hmax(w / 2, 1);
+		int destHeight = hmax(h / 2, 1);
+		// a dimension of 1 can't be halved so the same pixel is sampled twice
+		int dx = (w > 1 ? bpp : 0);
+		int dy = (h > 1 ? w * bpp : 0);
+		*destData = new unsigned char[destWidth * destHeight * bpp];
+		unsigned char* src = NULL;
+		unsigned char* dest = *destData;
+		for_iter (j, 0, destHeight)
+		{
+			src = &srcData[j * (h > 1 ? 2 : 1) * w * bpp];
+			for_iter (i, 0, destWidth)
+			{
+				for_iter (k, 0, bpp)
+				{
+					dest[k] = (unsigned char)((src[k] + src[k + dx] + src[k + dy] + src[k + dx + dy] + 2) >> 2);
+				}
+				src += (w > 1 ? 2 : 1) * bpp;
+				dest += bpp;
+			}
+		}
+		return true;
+	}
+
 	bool Image::needsConversion(Format srcFormat, Format destFormat, bool preventCopy)
 	{
 		if (srcFormat == Format::Invalid || destFormat == Format::Invalid)
 		{
 			return false;
 		}
+		// these formats can only be created by decoders
+		if (destFormat == Format::Compressed || destFormat == Format::Palette)
+		{
+			return false;
+		}
 		if (preventCopy && srcFormat == destFormat)
 		{
 			return false;
@@ -2551,6 +2940,11 @@ namespace april
 		Image::customMetaDataLoaders[extension] = metaDataLoadfunction;
 	}
 
+	void Image::registerCustomScaledLoader(chstr extension, Image* (*loadFunction)(hsbase&, int, float))
+	{
+		Image::customScaledLoaders[extension] = loadFunction;
+	}
+
 	void Image::registerCustomSaver(chstr extension, bool (*saveFunction)(hsbase&, Image*, SaveParameters), Image::SaveParameters (*defaultParametersFunction)())
 	{
 		Image::customSavers[extension] = saveFunction;
@@ -0,0 +1,602 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <limits.h>
+#include <string.h>
+
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "april.h"
+#include "Image.h"
+
+#define BLOCK_DIMENSION 4
+#define BLOCK_PIXELS 16
+#define POWER_ITERATIONS 4
+
+namespace april
+{
+	// modifiers in the order of the 2-bit pixel indices (+a, +b, -a, -b)
+	static const int etcModifiers[8][4] =
+	{
+		{ 2, 8, -2, -8 },
+		{ 5, 17, -5, -17 },
+		{ 9, 29, -9, -29 },
+		{ 13, 42, -13, -42 },
+		{ 18, 60, -18, -60 },
+		{ 24, 80, -24, -80 },
+		{ 33, 106, -33, -106 },
+		{ 47, 183, -47, -183 }
+	};
+
+	// index 3 is always the smallest and index 7 the largest modifier
+	static const int eacModifiers[16][8] =
+	{
+		{ -3, -6, -9, -15, 2, 5, 8, 14 },
+		{ -3, -7, -10, -13, 2, 6, 9, 12 },
+		{ -2, -5, -8, -13, 1, 4, 7, 12 },
+		{ -2, -4, -6, -13, 1, 3, 5, 12 },
+		{ -3, -6, -8, -12, 2, 5, 7, 11 },
+		{ -3, -7, -9, -11, 2, 6, 8, 10 },
+		{ -4, -7, -8, -11, 3, 6, 7, 10 },
+		{ -3, -5, -8, -11, 2, 4, 7, 10 },
+		{ -2, -6, -8, -10, 1, 5, 7, 9 },
+		{ -2, -5, -8, -10, 1, 4, 7, 9 },
+		{ -2, -4, -8, -10, 1, 3, 7, 9 },
+		{ -2, -5, -7, -10, 1, 4, 6, 9 },
+		{ -3, -4, -7, -10, 2, 3, 6, 9 },
+		{ -1, -2, -3, -10, 0, 1, 2, 9 },
+		{ -4, -6, -8, -9, 3, 5, 7, 8 },
+		{ -3, -5, -7, -9, 2, 4, 6, 8 }
+	};
+
+	// table 13 contains a modifier of 0 so it can represent a single value exactly
+	#define EAC_EXACT_TABLE 13
+	#define EAC_EXACT_INDEX 4
+
+	HL_ENUM_CLASS_DEFINE(Image::BlockFormat,
+	(
+		HL_ENUM_DEFINE(Image::BlockFormat, Etc2Rgb);
+		HL_ENUM_DEFINE(Image::BlockFormat, Etc2Rgba);
+		HL_ENUM_DEFINE(Image::BlockFormat, Bc1);
+		HL_ENUM_DEFINE(Image::BlockFormat, Bc3);
+
+		int Image::BlockFormat::getBlockSize() const
+		{
+			if ((*this) == Etc2Rgb)		return 8;
+			if ((*this) == Etc2Rgba)	return 16;
+			if ((*this) == Bc1)			return 8;
+			if ((*this) == Bc3)			return 16;
+			return 0;
+		}
+
+		bool Image::BlockFormat::hasAlpha() const
+		{
+			return ((*this) == Etc2Rgba || (*this) == Bc3);
+		}
+
+	));
+
+	static inline int _colorDistance(const unsigned char* color, int r, int g, int b)
+	{
+		int dr = color[0] - r;
+		int dg = color[1] - g;
+		int db = color[2] - b;
+		return (dr * dr + dg * dg + db * db);
+	}
+
+	static inline unsigned short _packRgb565(const unsigned char* color)
+	{
+		return (unsigned short)((((color[0] * 31 + 127) / 255) << 11) | (((color[1] * 63 + 127) / 255) << 5) | ((color[2] * 31 + 127) / 255));
+	}
+
+	static inline void _unpackRgb565(unsigned short value, int* color)
+	{
+		int r = (value >> 11) & 0x1F;
+		int g = (value >> 5) & 0x3F;
+		int b = value & 0x1F;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// BC1 color block, colors are fitted along the principal axis of the block's color distribution
+	static void _encodeBc1Block(const unsigned char* pixels, unsigned char* dest)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for_iter (i, 0, BLOCK_PIXELS)
+		{
+			mean[0] += pixels[i * 4];
+			mean[1] += pixels[i * 4 + 1];
+			mean[2] += pixels[i * 4 + 2];
+		}
+		mean[0] /= BLOCK_PIXELS;
+		mean[1] /= BLOCK_PIXELS;
+		mean[2] /= BLOCK_PIXELS;
+		// covariance matrix (xx, xy, xz, yy, yz, zz)
+		float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		float dr = 0.0f;
+		float dg = 0.0f;
+		float db = 0.0f;
+		int minIndex[3] = { 0, 0, 0 };
+		int maxIndex[3] = { 0, 0, 0 };
+		for_iter (i, 0, BLOCK_PIXELS)
+		{
+			dr = pixels[i * 4] - mean[0];
+			dg = pixels[i * 4 + 1] - mean[1];
+			db = pixels[i * 4 + 2] - mean[2];
+			covariance[0] += dr * dr;
+			covariance[1] += dr * dg;
+			covariance[2] += dr * db;
+			covariance[3] += dg * dg;
+			covariance[4] += dg * db;
+			covariance[5] += db * db;
+			for_iter (c, 0, 3)
+			{
+				if (pixels[i * 4 + c] < pixels[minIndex[c] * 4 + c])
+				{
+					minIndex[c] = i;
+				}
+				if (pixels[i * 4 + c] > pixels[maxIndex[c] * 4 + c])
+				{
+					maxIndex[c] = i;
+				}
+			}
+		}
+		// the bounding box diagonal is a good starting point for the power iteration
+		float axis[3];
+		for_iter (c, 0, 3)
+		{
+			axis[c] = (float)(pixels[maxIndex[c] * 4 + c] - pixels[minIndex[c] * 4 + c]);
+		}
+		float x = 0.0f;
+		float y = 0.0f;
+		float z = 0.0f;
+		float length = 0.0f;
+		for_iter (i, 0, POWER_ITERATIONS)
+		{
+			x = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+			y = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+			z = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+			length = hmax(hmax(habs(x), habs(y)), habs(z));
+			if (length <= 0.0f)
+			{
+				break;
+			}
+			axis[0] = x / length;
+			axis[1] = y / length;
+			axis[2] = z / length;
+		}
+		// the pixels furthest apart along the axis become the end points
+		int minPixel = 0;
+		int maxPixel = 0;
+		float minDot = 0.0f;
+		float maxDot = 0.0f;
+		float dot = 0.0f;
+		for_iter (i, 0, BLOCK_PIXELS)
+		{
+			dot = pixels[i * 4] * axis[0] + pixels[i * 4 + 1] * axis[1] + pixels[i * 4 + 2] * axis[2];
+			if (i == 0 || dot < minDot)
+			{
+				minDot = dot;
+				minPixel = i;
+			}
+			if (i == 0 || dot > maxDot)
+			{
+				maxDot = dot;
+				maxPixel = i;
+			}
+		}
+		unsigned short color0 = _packRgb565(&pixels[maxPixel * 4]);
+		unsigned short color1 = _packRgb565(&pixels[minPixel * 4]);
+		// color0 has to be larger to use 4-color mode
+		if (color0 < color1)
+		{
+			hswap(color0, color1);
+		}
+		unsigned int indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][3];
+			_unpackRgb565(color0, palette[0]);
+			_unpackRgb565(color1, palette[1]);
+			for_iter (c, 0, 3)
+			{
+				palette[2][c] = (palette[0][c] * 2 + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + palette[1][c] * 2) / 3;
+			}
+			int bestIndex = 0;
+			int bestError = 0;
+			int error = 0;
+			for_iter (i, 0, BLOCK_PIXELS)
+			{
+				bestIndex = 0;
+				bestError = INT_MAX;
+				for_iter (j, 0, 4)
+				{
+					error = _colorDistance(&pixels[i * 4], palette[j][0], palette[j][1], palette[j][2]);
+					if (error < bestError)
+					{
+						bestError = error;
+						bestIndex = j;
+					}
+				}
+				indices |= ((unsigned int)bestIndex << (i * 2));
+			}
+		}
+		dest[0] = (unsigned char)(color0 & 0xFF);
+		dest[1] = (unsigned char)(color0 >> 8);
+		dest[2] = (unsigned char)(color1 & 0xFF);
+		dest[3] = (unsigned char)(color1 >> 8);
+		dest[4] = (unsigned char)(indices & 0xFF);
+		dest[5] = (unsigned char)((indices >> 8) & 0xFF);
+		dest[6] = (unsigned char)((indices >> 16) & 0xFF);
+		dest[7] = (unsigned char)(indices >> 24);
+	}
+
+	// BC3 alpha block, always uses the 8-value mode between the smallest and largest alpha
+	static void _encodeBc3AlphaBlock(const unsigned char* pixels, unsigned char* dest)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		for_iter (i, 0, BLOCK_PIXELS)
+		{
+			alpha0 = hmax(alpha0, (int)pixels[i * 4 + 3]);
+			alpha1 = hmin(alpha1, (int)pixels[i * 4 + 3]);
+		}
+		unsigned long long indices = 0ULL;
+		if (alpha0 != alpha1)
+		{
+			int values[8];
+			values[0] = alpha0;
+			values[1] = alpha1;
+			for_iter (j, 2, 8)
+			{
+				values[j] = ((8 - j) * alpha0 + (j - 1) * alpha1) / 7;
+			}
+			int bestIndex = 0;
+			int bestError = 0;
+			int error = 0;
+			for_iter (i, 0, BLOCK_PIXELS)
+			{
+				bestIndex = 0;
+				bestError = INT_MAX;
+				for_iter (j, 0, 8)
+				{
+					error = habs(values[j] - (int)pixels[i * 4 + 3]);
+					if (error < bestError)
+					{
+						bestError = error;
+						bestIndex = j;
+					}
+				}
+				indices |= ((unsigned long long)bestIndex << (i * 3));
+			}
+		}
+		dest[0] = (unsigned char)alpha0;
+		dest[1] = (unsigned char)alpha1;
+		for_iter (i, 0, 6)
+		{
+			dest[2 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+		}
+	}
+
+	// finds the best modifier table and pixel modifiers for an ETC sub-block with the given base color
+	static int _encodeEtcSubBlock(const unsigned char* pixels, const int* pixelIndices, const int* base, int* bestTable, int* bestModifiers)
+	{
+		int bestError = INT_MAX;
+		int modifiers[8] = { 0 };
+		int error = 0;
+		int pixelError = 0;
+		int bestPixelError = 0;
+		int modifier = 0;
+		const unsigned char* pixel = NULL;
+		for_iter (t, 0, 8)
+		{
+			error = 0;
+			for_iter (k, 0, 8)
+			{
+				pixel = &pixels[pixelIndices[k] * 4];
+				bestPixelError = INT_MAX;
+				for_iter (m, 0, 4)
+				{
+					modifier = etcModifiers[t][m];
+					pixelError = _colorDistance(pixel, hclamp(base[0] + modifier, 0, 255), hclamp(base[1] + modifier, 0, 255), hclamp(base[2] + modifier, 0, 255));
+					if (pixelError < bestPixelError)
+					{
+						bestPixelError = pixelError;
+						modifiers[k] = m;
+					}
+				}
+				error += bestPixelError;
+				if (error >= bestError)
+				{
+					break;
+				}
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				*bestTable = t;
+				memcpy(bestModifiers, modifiers, sizeof(modifiers));
+			}
+		}
+		return bestError;
+	}
+
+	// ETC1 block which is also a valid ETC2 RGB block, both sub-block orientations are tried
+	static void _encodeEtcBlock(const unsigned char* pixels, unsigned char* dest)
+	{
+		int pixelIndices[2][8];
+		int average[2][3];
+		int quantized[2][3];
+		int base[2][3];
+		int tables[2] = { 0, 0 };
+		int modifiers[2][8];
+		int error = 0;
+		int bestError = INT_MAX;
+		unsigned int high = 0;
+		unsigned int low = 0;
+		unsigned int bestHigh = 0;
+		unsigned int bestLow = 0;
+		bool differential = false;
+		int x = 0;
+		int y = 0;
+		for_iter (flip, 0, 2)
+		{
+			// not flipped: left and right 2x4 halves, flipped: top and bottom 4x2 halves
+			for_iter (s, 0, 2)
+			{
+				for_iter (k, 0, 8)
+				{
+					x = (flip == 0 ? s * 2 + k / 4 : k % 4);
+					y = (flip == 0 ? k % 4 : s * 2 + k / 4);
+					pixelIndices[s][k] = x + y * BLOCK_DIMENSION;
+				}
+				for_iter (c, 0, 3)
+				{
+					average[s][c] = 0;
+					for_iter (k, 0, 8)
+					{
+						average[s][c] += pixels[pixelIndices[s][k] * 4 + c];
+					}
+					average[s][c] = (average[s][c] + 4) / 8;
+					quantized[s][c] = (average[s][c] * 31 + 127) / 255;
+				}
+			}
+			// differential mode has more precision, but the second color has to be within a small distance
+			differential = true;
+			for_iter (c, 0, 3)
+			{
+				if (quantized[1][c] - quantized[0][c] < -4 || quantized[1][c] - quantized[0][c] > 3)
+				{
+					differential = false;
+					break;
+				}
+			}
+			for_iter (s, 0, 2)
+			{
+				for_iter (c, 0, 3)
+				{
+					if (!differential)
+					{
+						quantized[s][c] = (average[s][c] * 15 + 127) / 255;
+						base[s][c] = quantized[s][c] * 17;
+					}
+					else
+					{
+						base[s][c] = (quantized[s][c] << 3) | (quantized[s][c] >> 2);
+					}
+				}
+			}
+			error = _encodeEtcSubBlock(pixels, pixelIndices[0], base[0], &tables[0], modifiers[0]);
+			if (error >= bestError)
+			{
+				continue;
+			}
+			error += _encodeEtcSubBlock(pixels, pixelIndices[1], base[1], &tables[1], modifiers[1]);
+			if (error >= bestError)
+			{
+				continue;
+			}
+			bestError = error;
+			if (differential)
+			{
+				high = (quantized[0][0] << 27) | (((quantized[1][0] - quantized[0][0]) & 0x7) << 24) |
+					(quantized[0][1] << 19) | (((quantized[1][1] - quantized[0][1]) & 0x7) << 16) |
+					(quantized[0][2] << 11) | (((quantized[1][2] - quantized[0][2]) & 0x7) << 8);
+			}
+			else
+			{
+				high = (quantized[0][0] << 28) | (quantized[1][0] << 24) | (quantized[0][1] << 20) | (quantized[1][1] << 16) | (quantized[0][2] << 12) | (quantized[1][2] << 8);
+			}
+			high |= (tables[0] << 5) | (tables[1] << 2) | ((differential ? 1 : 0) << 1) | flip;
+			// pixel indices are stored column by column, most significant bits first
+			low = 0;
+			for_iter (s, 0, 2)
+			{
+				for_iter (k, 0, 8)
+				{
+					x = pixelIndices[s][k] % BLOCK_DIMENSION;
+					y = pixelIndices[s][k] / BLOCK_DIMENSION;
+					low |= ((unsigned int)(modifiers[s][k] >> 1) << (x * 4 + y + 16)) | ((unsigned int)(modifiers[s][k] & 0x1) << (x * 4 + y));
+				}
+			}
+			bestHigh = high;
+			bestLow = low;
+		}
+		for_iter (i, 0, 4)
+		{
+			dest[i] = (unsigned char)((bestHigh >> (24 - i * 8)) & 0xFF);
+			dest[4 + i] = (unsigned char)((bestLow >> (24 - i * 8)) & 0xFF);
+		}
+	}
+
+	// EAC alpha block as used by ETC2 RGBA8
+	static void _encodeEacAlphaBlock(const unsigned char* pixels, unsigned char* dest)
+	{
+		int minAlpha = 255;
+		int maxAlpha = 0;
+		for_iter (i, 0, BLOCK_PIXELS)
+		{
+			minAlpha = hmin(minAlpha, (int)pixels[i * 4 + 3]);
+			maxAlpha = hmax(maxAlpha, (int)pixels[i * 4 + 3]);
+		}
+		int bestBase = minAlpha;
+		int bestMultiplier = 1;
+		int bestTable = EAC_EXACT_TABLE;
+		int bestIndices[BLOCK_PIXELS];
+		for_iter (i, 0, BLOCK_PIXELS)
+		{
+			bestIndices[i] = EAC_EXACT_INDEX;
+		}
+		if (minAlpha != maxAlpha)
+		{
+			int bestError = INT_MAX;
+			int indices[BLOCK_PIXELS];
+			int range = 0;
+			int multiplier = 0;
+			int base = 0;
+			int error = 0;
+			int pixelError = 0;
+			int bestPixelError = 0;
+			for_iter (t, 0, 16)
+			{
+				range = eacModifiers[t][7] - eacModifiers[t][3];
+				multiplier = (maxAlpha - minAlpha + range / 2) / range;
+				for_iter (m, multiplier - 1, multiplier + 2)
+				{
+					if (m < 1 || m > 15)
+					{
+						continue;
+					}
+					base = hclamp((minAlpha + maxAlpha + 1) / 2 - (eacModifiers[t][3] + eacModifiers[t][7]) * m / 2, 0, 255);
+					error = 0;
+					for_iter (i, 0, BLOCK_PIXELS)
+					{
+						bestPixelError = INT_MAX;
+						for_iter (j, 0, 8)
+						{
+							pixelError = habs(hclamp(base + eacModifiers[t][j] * m, 0, 255) - (int)pixels[i * 4 + 3]);
+							if (pixelError < bestPixelError)
+							{
+								bestPixelError = pixelError;
+								indices[i] = j;
+							}
+						}
+						error += bestPixelError * bestPixelError;
+						if (error >= bestError)
+						{
+							break;
+						}
+					}
+					if (error < bestError)
+					{
+						bestError = error;
+						bestBase = base;
+						bestMultiplier = m;
+						bestTable = t;
+						memcpy(bestIndices, indices, sizeof(indices));
+					}
+				}
+			}
+		}
+		// pixel indices are stored column by column, most significant bits first
+		unsigned long long bits = 0ULL;
+		int x = 0;
+		int y = 0;
+		for_iter (i, 0, BLOCK_PIXELS)
+		{
+			x = i % BLOCK_DIMENSION;
+			y = i / BLOCK_DIMENSION;
+			bits |= ((unsigned long long)bestIndices[i] << (45 - (x * 4 + y) * 3));
+		}
+		dest[0] = (unsigned char)bestBase;
+		dest[1] = (unsigned char)((bestMultiplier << 4) | bestTable);
+		for_iter (i, 0, 6)
+		{
+			dest[2 + i] = (unsigned char)((bits >> (40 - i * 8)) & 0xFF);
+		}
+	}
+
+	int Image::getBlockDataSize(int w, int h, BlockFormat blockFormat)
+	{
+		return (((w + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION) * ((h + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION) * blockFormat.getBlockSize());
+	}
+
+	bool Image::encodeBlocks(int w, int h, unsigned char* srcData, Format srcFormat, BlockFormat blockFormat, unsigned char** destData)
+	{
+		if (w <= 0 || h <= 0 || srcData == NULL || srcFormat == Format::Compressed)
+		{
+			return false;
+		}
+		// the encoders work on RGBA only
+		unsigned char* rgbaData = srcData;
+		if (srcFormat != Format::RGBA)
+		{
+			rgbaData = NULL;
+			if (!Image::convertToFormat(w, h, srcData, srcFormat, &rgbaData, Format::RGBA))
+			{
+				return false;
+			}
+		}
+		if (*destData == NULL)
+		{
+			*destData = new unsigned char[Image::getBlockDataSize(w, h, blockFormat)];
+		}
+		int blockSize = blockFormat.getBlockSize();
+		int blocksX = (w + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+		int blocksY = (h + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+		unsigned char pixels[BLOCK_PIXELS * 4];
+		unsigned char* dest = *destData;
+		int sx = 0;
+		int sy = 0;
+		for_iter (by, 0, blocksY)
+		{
+			for_iter (bx, 0, blocksX)
+			{
+				// blocks on the right and bottom edges repeat the last column and row
+				for_iter (y, 0, BLOCK_DIMENSION)
+				{
+					sy = hmin(by * BLOCK_DIMENSION + y, h - 1);
+					for_iter (x, 0, BLOCK_DIMENSION)
+					{
+						sx = hmin(bx * BLOCK_DIMENSION + x, w - 1);
+						memcpy(&pixels[(x + y * BLOCK_DIMENSION) * 4], &rgbaData[(sx + sy * w) * 4], 4);
+					}
+				}
+				if (blockFormat == BlockFormat::Etc2Rgb)
+				{
+					_encodeEtcBlock(pixels, dest);
+				}
+				else if (blockFormat == BlockFormat::Etc2Rgba)
+				{
+					_encodeEacAlphaBlock(pixels, dest);
+					_encodeEtcBlock(pixels, &dest[8]);
+				}
+				else if (blockFormat == BlockFormat::Bc1)
+				{
+					_encodeBc1Block(pixels, dest);
+				}
+				else if (blockFormat == BlockFormat::Bc3)
+				{
+					_encodeBc3AlphaBlock(pixels, dest);
+					_encodeBc1Block(pixels, &dest[8]);
+				}
+				dest += blockSize;
+			}
+		}
+		if (rgbaData != srcData)
+		{
+			delete[] rgbaData;
+		}
+		return true;
+	}
+
+}
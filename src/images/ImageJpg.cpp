@@ -33,7 +33,7 @@ namespace april
 		hasError = true;
 	}
 
-	Image* Image::_loadJpg(hsbase& stream, int size)
+	Image* Image::_loadJpg(hsbase& stream, int size, int maxDimension, float scale)
 	{
 		hasError = false;
 		// first read the whole data from the resource file
@@ -51,6 +51,13 @@ namespace april
 		{
 			return NULL;
 		}
+		// libjpeg can reduce the image by up to 1/8 while decoding, anything beyond that is done afterwards
+		int divisor = Image::calcDownscaleDivisor(cInfo.image_width, cInfo.image_height, maxDimension, scale);
+		if (divisor > 1)
+		{
+			cInfo.scale_num = 1;
+			cInfo.scale_denom = hmin(divisor, 8);
+		}
 		jpeg_start_decompress(&cInfo);
 		if (hasError)
 		{
@@ -79,12 +86,21 @@ namespace april
 		image->w = cInfo.output_width;
 		image->h = cInfo.output_height;
 		image->format = Image::Format::RGB; // JPEG is always RGB
+		if (divisor > 8)
+		{
+			image->downscale(divisor / 8);
+		}
 		return image;
 	}
 
+	Image* Image::_loadJpg(hsbase& stream, int size)
+	{
+		return Image::_loadJpg(stream, size, 0, 1.0f);
+	}
+
 	Image* Image::_loadJpg(hsbase& stream)
 	{
-		return Image::_loadJpg(stream, (int)stream.size());
+		return Image::_loadJpg(stream, (int)stream.size(), 0, 1.0f);
 	}
 
 	bool Image::_saveJpeg(hsbase& stream, Image* image, SaveParameters parameters)
@@ -9,11 +9,14 @@
 #define __HL_INCLUDE_PLATFORM_HEADERS
 #include <hltypes/hplatform.h>
 
+#include <string.h>
+
 #include <png.h>
 #include <pngpriv.h>
 #include <pngstruct.h>
 
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hsbase.h>
 #include <hltypes/hstring.h>
 
@@ -38,7 +41,7 @@ namespace april
 	{
 	}
 
-	Image* Image::_loadPng(hsbase& stream, int size)
+	Image* Image::_loadPng(hsbase& stream, int size, bool keepPalette, int maxDimension, float scale)
 	{
 		if (size < PNG_SIGNATURE_SIZE)
 		{
@@ -60,66 +63,170 @@ namespace april
 		png_set_read_fn(pngPtr, &stream, &_pngRead);
 		png_read_info(pngPtr, infoPtr);
 		png_get_IHDR(pngPtr, infoPtr, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
-		png_set_interlace_handling(pngPtr);
+		int passes = png_set_interlace_handling(pngPtr);
 		int bpp = pngPtr->channels;
-		if (pngPtr->color_type == PNG_COLOR_TYPE_PALETTE)
-		{
-			png_set_palette_to_rgb(pngPtr);
-			bpp = 3;
-		}
-		if (pngPtr->color_type == PNG_COLOR_TYPE_GRAY_ALPHA && bpp > 1)
+		bool palette = (keepPalette && pngPtr->color_type == PNG_COLOR_TYPE_PALETTE);
+		if (palette)
 		{
-			png_set_strip_alpha(pngPtr);
-			--bpp;
+			png_set_packing(pngPtr); // indices with less than 8 bits are expanded to one byte
 		}
-		if (png_get_valid(pngPtr, infoPtr, PNG_INFO_tRNS))
+		else
 		{
-			png_set_tRNS_to_alpha(pngPtr);
-			++bpp;
+			if (pngPtr->color_type == PNG_COLOR_TYPE_PALETTE)
+			{
+				png_set_palette_to_rgb(pngPtr);
+				bpp = 3;
+			}
+			if (pngPtr->color_type == PNG_COLOR_TYPE_GRAY_ALPHA && bpp > 1)
+			{
+				png_set_strip_alpha(pngPtr);
+				--bpp;
+			}
+			if (png_get_valid(pngPtr, infoPtr, PNG_INFO_tRNS))
+			{
+				png_set_tRNS_to_alpha(pngPtr);
+				++bpp;
+			}
 		}
 		if (pngPtr->bit_depth == 16)
 		{
 			png_set_strip_16(pngPtr);
 		}
 		png_read_update_info(pngPtr, infoPtr);
+		int w = (int)pngPtr->width;
+		int h = (int)pngPtr->height;
 		int rowBytes = (int)png_get_rowbytes(pngPtr, infoPtr);
-		png_byte* imageData = new png_byte[rowBytes * pngPtr->height];
-		png_bytep* rowPointers = new png_bytep[pngPtr->height];
-		for_itert (unsigned int, i, 0, pngPtr->height)
+		int divisor = Image::calcDownscaleDivisor(w, h, maxDimension, scale);
+		// interlaced images can't be read row by row so they are downscaled afterwards
+		bool streamed = (divisor > 1 && passes == 1);
+		int destWidth = (streamed ? (w + divisor - 1) / divisor : w);
+		int destHeight = (streamed ? (h + divisor - 1) / divisor : h);
+		int destRowBytes = (streamed ? rowBytes / w * destWidth : rowBytes);
+		// paletted data is prefixed with the RGBA palette
+		int offset = (palette ? APRIL_IMAGE_PALETTE_BYTE_SIZE : 0);
+		png_byte* imageData = new png_byte[offset + destRowBytes * destHeight];
+		if (streamed)
 		{
-			rowPointers[i] = imageData + i * rowBytes;
+			int pixelBytes = rowBytes / w;
+			png_byte* row = new png_byte[rowBytes];
+			png_byte* dest = imageData + offset;
+			if (palette)
+			{
+				// indices can't be averaged so the top-left pixel of every block is used
+				for_iter (j, 0, h)
+				{
+					png_read_row(pngPtr, row, NULL);
+					if (j % divisor == 0)
+					{
+						for_iter (i, 0, destWidth)
+						{
+							dest[i] = row[i * divisor];
+						}
+						dest += destRowBytes;
+					}
+				}
+			}
+			else
+			{
+				unsigned int* sums = new unsigned int[destRowBytes];
+				memset(sums, 0, destRowBytes * sizeof(unsigned int));
+				int rowCount = 0;
+				for_iter (j, 0, h)
+				{
+					png_read_row(pngPtr, row, NULL);
+					Image::_boxFilterAddRow(row, w, pixelBytes, divisor, sums);
+					++rowCount;
+					if (rowCount == divisor || j == h - 1)
+					{
+						Image::_boxFilterWriteRow(sums, w, pixelBytes, divisor, rowCount, dest);
+						dest += destRowBytes;
+						rowCount = 0;
+					}
+				}
+				delete[] sums;
+			}
+			delete[] row;
+		}
+		else
+		{
+			png_bytep* rowPointers = new png_bytep[h];
+			for_iter (i, 0, h)
+			{
+				rowPointers[i] = imageData + offset + i * rowBytes;
+			}
+			png_read_image(pngPtr, rowPointers);
+			delete[] rowPointers;
 		}
-		png_read_image(pngPtr, rowPointers);
 		png_read_end(pngPtr, infoPtr);
+		if (palette)
+		{
+			png_colorp colors = NULL;
+			int colorCount = 0;
+			png_bytep alphas = NULL;
+			int alphaCount = 0;
+			png_get_PLTE(pngPtr, infoPtr, &colors, &colorCount);
+			if (png_get_valid(pngPtr, infoPtr, PNG_INFO_tRNS))
+			{
+				png_get_tRNS(pngPtr, infoPtr, &alphas, &alphaCount, NULL);
+			}
+			colorCount = hmin(colorCount, APRIL_IMAGE_PALETTE_COLORS);
+			memset(imageData, 0, APRIL_IMAGE_PALETTE_BYTE_SIZE);
+			for_iter (i, 0, APRIL_IMAGE_PALETTE_COLORS)
+			{
+				if (i < colorCount)
+				{
+					imageData[i * 4] = colors[i].red;
+					imageData[i * 4 + 1] = colors[i].green;
+					imageData[i * 4 + 2] = colors[i].blue;
+				}
+				imageData[i * 4 + 3] = (i < alphaCount ? alphas[i] : 255);
+			}
+		}
 		// assign Image data
 		Image* image = new Image();
 		image->data = (unsigned char*)imageData;
-		image->w = pngPtr->width;
-		image->h = pngPtr->height;
-		switch (bpp)
+		image->w = destWidth;
+		image->h = destHeight;
+		if (palette)
 		{
-		case 4:
-			image->format = Format::RGBA;
-			break;
-		case 3:
-			image->format = Format::RGB;
-			break;
-		case 1:
-			image->format = Format::Alpha;
-			break;
-		default:
-			image->format = Format::RGBA; // TODOaa - maybe palette should go here
-			break;
+			image->format = Format::Palette;
+			image->compressedSize = offset + destRowBytes * destHeight;
+		}
+		else
+		{
+			switch (bpp)
+			{
+			case 4:
+				image->format = Format::RGBA;
+				break;
+			case 3:
+				image->format = Format::RGB;
+				break;
+			case 1:
+				image->format = Format::Alpha;
+				break;
+			default:
+				image->format = Format::RGBA;
+				break;
+			}
 		}
 		// clean up
 		png_destroy_read_struct(&pngPtr, &infoPtr, &endInfo);
-		delete[] rowPointers;
+		if (divisor > 1 && !streamed)
+		{
+			image->downscale(divisor);
+		}
 		return image;
 	}
 
+	Image* Image::_loadPng(hsbase& stream, int size)
+	{
+		return Image::_loadPng(stream, size, false, 0, 1.0f);
+	}
+
 	Image* Image::_loadPng(hsbase& stream)
 	{
-		return Image::_loadPng(stream, (int)stream.size());
+		return Image::_loadPng(stream, (int)stream.size(), false, 0, 1.0f);
 	}
 
 	bool Image::_savePng(hsbase& stream, Image* image, SaveParameters parameters)
@@ -0,0 +1,371 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hsbase.h>
+#include <hltypes/hstring.h>
+
+#include "april.h"
+#include "Image.h"
+
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+#define QOI_PIXELS_MAX 400000000
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+#define QOI_MASK_2 0xC0
+
+#define QOI_HASH(r, g, b, a) ((((r) * 3 + (g) * 5 + (b) * 7 + (a) * 11) & 63) * 4)
+
+namespace april
+{
+	static const unsigned char qoiPadding[QOI_PADDING_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+	static inline unsigned int _qoiReadUInt32(const unsigned char* data)
+	{
+		return (((unsigned int)data[0] << 24) | ((unsigned int)data[1] << 16) | ((unsigned int)data[2] << 8) | (unsigned int)data[3]);
+	}
+
+	static inline void _qoiWriteUInt32(unsigned char* data, unsigned int value)
+	{
+		data[0] = (unsigned char)((value >> 24) & 0xFF);
+		data[1] = (unsigned char)((value >> 16) & 0xFF);
+		data[2] = (unsigned char)((value >> 8) & 0xFF);
+		data[3] = (unsigned char)(value & 0xFF);
+	}
+
+	static bool _qoiReadHeader(const unsigned char* header, int* w, int* h, int* channels)
+	{
+		if (header[0] != 'q' || header[1] != 'o' || header[2] != 'i' || header[3] != 'f')
+		{
+			hlog::error(logTag, "Not a QOI file!");
+			return false;
+		}
+		unsigned int width = _qoiReadUInt32(&header[4]);
+		unsigned int height = _qoiReadUInt32(&header[8]);
+		*channels = header[12];
+		if (width == 0 || height == 0 || height >= QOI_PIXELS_MAX / width || (*channels != 3 && *channels != 4) || header[13] > 1)
+		{
+			hlog::error(logTag, "Invalid QOI header!");
+			return false;
+		}
+		*w = (int)width;
+		*h = (int)height;
+		return true;
+	}
+
+	Image* Image::_loadQoi(hsbase& stream, int size, Image::Format format)
+	{
+		if (size < QOI_HEADER_SIZE + QOI_PADDING_SIZE)
+		{
+			hlog::error(logTag, "Not a QOI file!");
+			return NULL;
+		}
+		// first read the whole data from the resource file
+		unsigned char* fileData = new unsigned char[size];
+		stream.readRaw(fileData, size);
+		int w = 0;
+		int h = 0;
+		int channels = 0;
+		if (!_qoiReadHeader(fileData, &w, &h, &channels))
+		{
+			delete[] fileData;
+			return NULL;
+		}
+		Format naturalFormat = (channels == 4 ? Format::RGBA : Format::RGB);
+		// decoding happens directly into the requested format if it has separate RGB channels, otherwise a conversion is done afterwards
+		Format decodeFormat = format;
+		if (decodeFormat == Format::Invalid || (decodeFormat.getBpp() != 3 && decodeFormat.getBpp() != 4))
+		{
+			decodeFormat = naturalFormat;
+		}
+		int bpp = decodeFormat.getBpp();
+		int ir = 0;
+		int ig = 0;
+		int ib = 0;
+		int ia = 0;
+		decodeFormat.getChannelIndices(&ir, &ig, &ib, &ia);
+		bool keepAlpha = (decodeFormat.getIndexAlpha() >= 0);
+		unsigned char* imageData = new unsigned char[w * h * bpp];
+		unsigned char* dest = imageData;
+		unsigned char index[256] = { 0 };
+		unsigned char r = 0;
+		unsigned char g = 0;
+		unsigned char b = 0;
+		unsigned char a = 255;
+		unsigned char* color = NULL;
+		int b1 = 0;
+		int b2 = 0;
+		int vg = 0;
+		int run = 0;
+		// the padding guarantees that no op-code can read past the end of the data
+		const unsigned char* current = fileData + QOI_HEADER_SIZE;
+		const unsigned char* end = fileData + size - QOI_PADDING_SIZE;
+		int pixelCount = w * h;
+		for_iter (i, 0, pixelCount)
+		{
+			if (run > 0)
+			{
+				--run;
+			}
+			else if (current < end)
+			{
+				b1 = *current++;
+				if (b1 == QOI_OP_RGB)
+				{
+					r = current[0];
+					g = current[1];
+					b = current[2];
+					current += 3;
+				}
+				else if (b1 == QOI_OP_RGBA)
+				{
+					r = current[0];
+					g = current[1];
+					b = current[2];
+					a = current[3];
+					current += 4;
+				}
+				else
+				{
+					switch (b1 & QOI_MASK_2)
+					{
+					case QOI_OP_INDEX:
+						color = &index[b1 * 4];
+						r = color[0];
+						g = color[1];
+						b = color[2];
+						a = color[3];
+						break;
+					case QOI_OP_DIFF:
+						r += ((b1 >> 4) & 0x03) - 2;
+						g += ((b1 >> 2) & 0x03) - 2;
+						b += (b1 & 0x03) - 2;
+						break;
+					case QOI_OP_LUMA:
+						b2 = *current++;
+						vg = (b1 & 0x3F) - 32;
+						r += vg - 8 + ((b2 >> 4) & 0x0F);
+						g += vg;
+						b += vg - 8 + (b2 & 0x0F);
+						break;
+					case QOI_OP_RUN:
+						run = (b1 & 0x3F);
+						break;
+					}
+				}
+				color = &index[QOI_HASH(r, g, b, a)];
+				color[0] = r;
+				color[1] = g;
+				color[2] = b;
+				color[3] = a;
+			}
+			dest[ir] = r;
+			dest[ig] = g;
+			dest[ib] = b;
+			if (bpp == 4)
+			{
+				dest[ia] = (keepAlpha ? a : 255);
+			}
+			dest += bpp;
+		}
+		delete[] fileData;
+		// assign Image data
+		Image* image = new Image();
+		image->data = imageData;
+		image->w = w;
+		image->h = h;
+		image->format = decodeFormat;
+		if (format != Format::Invalid && Image::needsConversion(image->format, format))
+		{
+			unsigned char* data = NULL;
+			if (Image::convertToFormat(image->w, image->h, image->data, image->format, &data, format))
+			{
+				delete[] image->data;
+				image->format = format;
+				image->data = data;
+			}
+		}
+		return image;
+	}
+
+	Image* Image::_loadQoi(hsbase& stream, int size)
+	{
+		return Image::_loadQoi(stream, size, Format::Invalid);
+	}
+
+	Image* Image::_loadQoi(hsbase& stream)
+	{
+		return Image::_loadQoi(stream, (int)stream.size(), Format::Invalid);
+	}
+
+	bool Image::_saveQoi(hsbase& stream, Image* image, SaveParameters parameters)
+	{
+		int bpp = image->getBpp();
+		if (bpp != 1 && bpp != 3 && bpp != 4)
+		{
+			hlog::error(logTag, "Cannot save image format as QOI: " + image->format.getName());
+			return false;
+		}
+		int ir = image->format.getIndexRed();
+		int ig = image->format.getIndexGreen();
+		int ib = image->format.getIndexBlue();
+		int ia = image->format.getIndexAlpha();
+		int channels = (ia >= 0 ? 4 : 3);
+		int pixelCount = image->w * image->h;
+		int maxSize = QOI_HEADER_SIZE + pixelCount * (channels + 1) + QOI_PADDING_SIZE;
+		unsigned char* fileData = new unsigned char[maxSize];
+		unsigned char* current = fileData;
+		current[0] = 'q';
+		current[1] = 'o';
+		current[2] = 'i';
+		current[3] = 'f';
+		_qoiWriteUInt32(&current[4], (unsigned int)image->w);
+		_qoiWriteUInt32(&current[8], (unsigned int)image->h);
+		current[12] = (unsigned char)channels;
+		current[13] = 0; // sRGB with linear alpha
+		current += QOI_HEADER_SIZE;
+		unsigned char index[256] = { 0 };
+		unsigned char r = 0;
+		unsigned char g = 0;
+		unsigned char b = 0;
+		unsigned char a = 255;
+		unsigned char pr = 0;
+		unsigned char pg = 0;
+		unsigned char pb = 0;
+		unsigned char pa = 255;
+		unsigned char* color = NULL;
+		signed char vr = 0;
+		signed char vg = 0;
+		signed char vb = 0;
+		signed char vgr = 0;
+		signed char vgb = 0;
+		int hash = 0;
+		int run = 0;
+		const unsigned char* src = image->data;
+		for_iter (i, 0, pixelCount)
+		{
+			// Alpha format has no color channels and is saved as white
+			r = (ir >= 0 ? src[ir] : 255);
+			g = (ig >= 0 ? src[ig] : 255);
+			b = (ib >= 0 ? src[ib] : 255);
+			a = (ia >= 0 ? src[ia] : 255);
+			src += bpp;
+			if (r == pr && g == pg && b == pb && a == pa)
+			{
+				++run;
+				if (run == 62 || i == pixelCount - 1)
+				{
+					*current++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+					run = 0;
+				}
+				continue;
+			}
+			if (run > 0)
+			{
+				*current++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+				run = 0;
+			}
+			hash = QOI_HASH(r, g, b, a);
+			color = &index[hash];
+			if (color[0] == r && color[1] == g && color[2] == b && color[3] == a)
+			{
+				*current++ = (unsigned char)(QOI_OP_INDEX | (hash / 4));
+			}
+			else
+			{
+				color[0] = r;
+				color[1] = g;
+				color[2] = b;
+				color[3] = a;
+				if (a == pa)
+				{
+					vr = (signed char)(r - pr);
+					vg = (signed char)(g - pg);
+					vb = (signed char)(b - pb);
+					vgr = vr - vg;
+					vgb = vb - vg;
+					if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+					{
+						*current++ = (unsigned char)(QOI_OP_DIFF | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+					}
+					else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+					{
+						*current++ = (unsigned char)(QOI_OP_LUMA | (vg + 32));
+						*current++ = (unsigned char)(((vgr + 8) << 4) | (vgb + 8));
+					}
+					else
+					{
+						current[0] = QOI_OP_RGB;
+						current[1] = r;
+						current[2] = g;
+						current[3] = b;
+						current += 4;
+					}
+				}
+				else
+				{
+					current[0] = QOI_OP_RGBA;
+					current[1] = r;
+					current[2] = g;
+					current[3] = b;
+					current[4] = a;
+					current += 5;
+				}
+			}
+			pr = r;
+			pg = g;
+			pb = b;
+			pa = a;
+		}
+		memcpy(current, qoiPadding, QOI_PADDING_SIZE);
+		current += QOI_PADDING_SIZE;
+		stream.writeRaw(fileData, (int)(current - fileData));
+		delete[] fileData;
+		return true;
+	}
+
+	Image* Image::_readMetaDataQoi(hsbase& stream, int size)
+	{
+		if (size < QOI_HEADER_SIZE + QOI_PADDING_SIZE)
+		{
+			hlog::error(logTag, "Not a QOI file!");
+			return NULL;
+		}
+		unsigned char header[QOI_HEADER_SIZE] = { 0 };
+		stream.readRaw(header, QOI_HEADER_SIZE);
+		int w = 0;
+		int h = 0;
+		int channels = 0;
+		if (!_qoiReadHeader(header, &w, &h, &channels))
+		{
+			return NULL;
+		}
+		// assign Image data
+		Image* image = new Image();
+		image->data = NULL;
+		image->w = w;
+		image->h = h;
+		image->format = (channels == 4 ? Format::RGBA : Format::RGB);
+		return image;
+	}
+
+	Image* Image::_readMetaDataQoi(hsbase& stream)
+	{
+		return Image::_readMetaDataQoi(stream, (int)stream.size());
+	}
+
+}
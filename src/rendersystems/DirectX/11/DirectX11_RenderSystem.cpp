@@ -888,7 +888,7 @@ namespace april
 		if (texture != NULL)
 		{
 			this->d3dDeviceContext->PSSetShaderResources(0, 1, ((DirectX11_Texture*)texture)->d3dView.GetAddressOf());
-			Texture::Filter filter = texture->getFilter();
+			Texture::Filter filter = ((DirectX11_Texture*)texture)->_getRenderFilter();
 			Texture::AddressMode addressMode = texture->getAddressMode();
 			ComPtr<ID3D11SamplerState> sampler = nullptr;
 			if (filter == Texture::Filter::Linear && addressMode == Texture::AddressMode::Wrap)
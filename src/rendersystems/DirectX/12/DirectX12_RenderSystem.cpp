@@ -1195,7 +1195,7 @@ namespace april
 			this->commandList[this->commandListIndex]->SetGraphicsRootDescriptorTable(1, gpuHandle);
 			// sampler
 			int adressModeSize = Texture::AddressMode::getCount();
-			gpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(this->samplerHeaps[this->commandListIndex]->GetGPUDescriptorHandleForHeapStart(), texture->getFilter().value * adressModeSize + texture->getAddressMode().value, this->samplerDescSize);
+			gpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(this->samplerHeaps[this->commandListIndex]->GetGPUDescriptorHandleForHeapStart(), texture->_getRenderFilter().value * adressModeSize + texture->getAddressMode().value, this->samplerDescSize);
 			this->commandList[this->commandListIndex]->SetGraphicsRootDescriptorTable(2, gpuHandle);
 		}
 		else
@@ -17,6 +17,7 @@
 #include "Keys.h"
 #include "OpenGL1_RenderSystem.h"
 #include "OpenGL1_Texture.h"
+#include "OpenGL_TextureUploader.h"
 #include "Platform.h"
 #include "Timer.h"
 #include "Window.h"
@@ -30,6 +31,10 @@ namespace april
 		this->name = april::RenderSystemType::OpenGL1.getName();
 #if defined(_WIN32) && !defined(_WINRT)
 		this->hRC = 0;
+		this->hRCUpload = 0;
+		this->fenceSync = NULL;
+		this->clientWaitSync = NULL;
+		this->deleteSync = NULL;
 #endif
 	}
 
@@ -45,12 +50,17 @@ namespace april
 		this->deviceState_matrixMode = 0;
 #if defined(_WIN32) && !defined(_WINRT)
 		this->hRC = 0;
+		this->hRCUpload = 0;
+		this->fenceSync = NULL;
+		this->clientWaitSync = NULL;
+		this->deleteSync = NULL;
 #endif
 	}
 
 #if defined(_WIN32) && !defined(_WINRT)
 	void OpenGL1_RenderSystem::_releaseWindow()
 	{
+		OpenGL_TextureUploader::destroy(); // the shared context can't outlive the main context
 		if (this->hRC != 0)
 		{
 			wglMakeCurrent(NULL, NULL);
@@ -103,6 +113,92 @@ namespace april
 		}
 		return true;
 	}
+
+	bool OpenGL1_RenderSystem::_deviceCreateUploadContext()
+	{
+		if (this->hRC == 0)
+		{
+			return false;
+		}
+		this->hRCUpload = wglCreateContext(this->hDC);
+		if (this->hRCUpload == 0)
+		{
+			hlog::write(logTag, "Can't create a shared GL context!");
+			return false;
+		}
+		// sharing has to be set up before the new context creates any objects
+		if (wglShareLists(this->hRC, this->hRCUpload) == 0)
+		{
+			hlog::write(logTag, "Can't share GL objects with the upload context!");
+			wglDeleteContext(this->hRCUpload);
+			this->hRCUpload = 0;
+			return false;
+		}
+		// fences need GL 3.2 or ARB_sync, without them the upload thread finishes every upload before handing it over
+		this->fenceSync = (PFNGLFENCESYNCPROC)wglGetProcAddress("glFenceSync");
+		this->clientWaitSync = (PFNGLCLIENTWAITSYNCPROC)wglGetProcAddress("glClientWaitSync");
+		this->deleteSync = (PFNGLDELETESYNCPROC)wglGetProcAddress("glDeleteSync");
+		return true;
+	}
+
+	void OpenGL1_RenderSystem::_deviceDestroyUploadContext()
+	{
+		if (this->hRCUpload != 0)
+		{
+			wglDeleteContext(this->hRCUpload);
+			this->hRCUpload = 0;
+		}
+		this->fenceSync = NULL;
+		this->clientWaitSync = NULL;
+		this->deleteSync = NULL;
+	}
+
+	bool OpenGL1_RenderSystem::_deviceSetUploadContextCurrent(bool current)
+	{
+		if (this->hRCUpload == 0)
+		{
+			return false;
+		}
+		if (!current)
+		{
+			return (wglMakeCurrent(NULL, NULL) != 0);
+		}
+		return (wglMakeCurrent(this->hDC, this->hRCUpload) != 0);
+	}
+
+	void* OpenGL1_RenderSystem::_deviceCreateUploadFence()
+	{
+		if (this->fenceSync == NULL || this->clientWaitSync == NULL || this->deleteSync == NULL)
+		{
+			return OpenGL_RenderSystem::_deviceCreateUploadFence();
+		}
+		GLsync sync = this->fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		if (sync == NULL)
+		{
+			return OpenGL_RenderSystem::_deviceCreateUploadFence();
+		}
+		GL_SAFE_CALL(glFlush, ()); // the fence has to reach the GPU, otherwise the render thread could wait for it forever
+		return (void*)sync;
+	}
+
+	bool OpenGL1_RenderSystem::_deviceWaitUploadFence(void* fence, bool wait)
+	{
+		if (this->clientWaitSync == NULL)
+		{
+			return true;
+		}
+		GLenum result = this->clientWaitSync((GLsync)fence, 0, wait ? GL_TIMEOUT_IGNORED : 0);
+		// a failed wait can't become signaled later so the texture is used anyway
+		return (result != GL_TIMEOUT_EXPIRED);
+	}
+
+	void OpenGL1_RenderSystem::_deviceDestroyUploadFence(void* fence)
+	{
+		if (this->deleteSync != NULL)
+		{
+			this->deleteSync((GLsync)fence);
+		}
+	}
 #endif
 
 	void OpenGL1_RenderSystem::_deviceSetupCaps()
@@ -134,6 +230,33 @@ namespace april
 				}
 			}
 		}
+		if (extensions.contains("texture_filter_anisotropic"))
+		{
+			GL_SAFE_CALL(glGetFloatv, (GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &this->caps.maxAnisotropy));
+		}
+		this->unpackSubimageSupported = true; // strided uploads are part of core OpenGL
+#if defined(_WIN32) && !defined(_WINRT)
+		// pixel unpack buffers and mapping buffer ranges need GL 3.0 or ARB_pixel_buffer_object and ARB_map_buffer_range
+		hstr version;
+		GL_SAFE_CALL(const GLubyte* versionString = glGetString, (GL_VERSION));
+		if (versionString != NULL)
+		{
+			version = (const char*)versionString;
+		}
+		this->pixelUnpackBufferSupported = false;
+		if ((int)version.split('.', 1).first() >= 3 || (extensions.contains("ARB_pixel_buffer_object") && extensions.contains("ARB_map_buffer_range")))
+		{
+			this->genBuffers = (GenBuffersFunction)wglGetProcAddress("glGenBuffers");
+			this->deleteBuffers = (DeleteBuffersFunction)wglGetProcAddress("glDeleteBuffers");
+			this->bindBuffer = (BindBufferFunction)wglGetProcAddress("glBindBuffer");
+			this->bufferData = (BufferDataFunction)wglGetProcAddress("glBufferData");
+			this->mapBufferRange = (MapBufferRangeFunction)wglGetProcAddress("glMapBufferRange");
+			this->unmapBuffer = (UnmapBufferFunction)wglGetProcAddress("glUnmapBuffer");
+			this->pixelUnpackBufferSupported = (this->genBuffers != NULL && this->deleteBuffers != NULL && this->bindBuffer != NULL &&
+				this->bufferData != NULL && this->mapBufferRange != NULL && this->unmapBuffer != NULL);
+		}
+		hlog::write(logTag, "Pixel unpack buffers supported: " + hstr(this->pixelUnpackBufferSupported ? "yes" : "no"));
+#endif
 		// TODO - is there a way to make this work on Win32?
 #ifndef _WIN32
 		this->blendSeparationSupported = extensions.contains("EXT_blend_equation_separate") && extensions.contains("EXT_blend_func_separate");
@@ -60,9 +60,20 @@ namespace april
 
 #if defined(_WIN32) && !defined(_WINRT)
 		HGLRC hRC;
+		HGLRC hRCUpload;
+		PFNGLFENCESYNCPROC fenceSync;
+		PFNGLCLIENTWAITSYNCPROC clientWaitSync;
+		PFNGLDELETESYNCPROC deleteSync;
 
 		void _releaseWindow();
 		bool _initWin32(Window* window);
+
+		bool _deviceCreateUploadContext();
+		void _deviceDestroyUploadContext();
+		bool _deviceSetUploadContextCurrent(bool current);
+		void* _deviceCreateUploadFence();
+		bool _deviceWaitUploadFence(void* fence, bool wait);
+		void _deviceDestroyUploadFence(void* fence);
 #endif
 
 	};
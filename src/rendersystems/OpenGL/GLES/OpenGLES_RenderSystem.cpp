@@ -20,6 +20,7 @@
 #ifdef _EGL
 #include "egl.h"
 #endif
+#include "OpenGL_TextureUploader.h"
 #include "OpenGLES_defaultShaders.h"
 #include "OpenGLES_PixelShader.h"
 #include "OpenGLES_RenderSystem.h"
@@ -200,6 +201,14 @@ namespace april
 		this->pixelShaderColoredExTexturedDesaturate_AlphaHack = NULL;
 		this->pixelShaderColoredExTexturedSepia_AlphaHack = NULL;
 #endif
+		this->pixelShaderTexturedMultiply_Palette = NULL;
+		this->pixelShaderTexturedLerp_Palette = NULL;
+		this->pixelShaderTexturedDesaturate_Palette = NULL;
+		this->pixelShaderTexturedSepia_Palette = NULL;
+		this->pixelShaderColoredTexturedMultiply_Palette = NULL;
+		this->pixelShaderColoredTexturedLerp_Palette = NULL;
+		this->pixelShaderColoredTexturedDesaturate_Palette = NULL;
+		this->pixelShaderColoredTexturedSepia_Palette = NULL;
 		this->shaderMultiply = NULL;
 		this->shaderAlphaMap = NULL;
 		this->shaderLerp = NULL;
@@ -248,6 +257,14 @@ namespace april
 		this->shaderColoredExTexturedDesaturate_AlphaHack = NULL;
 		this->shaderColoredExTexturedSepia_AlphaHack = NULL;
 #endif
+		this->shaderTexturedMultiply_Palette = NULL;
+		this->shaderTexturedLerp_Palette = NULL;
+		this->shaderTexturedDesaturate_Palette = NULL;
+		this->shaderTexturedSepia_Palette = NULL;
+		this->shaderColoredTexturedMultiply_Palette = NULL;
+		this->shaderColoredTexturedLerp_Palette = NULL;
+		this->shaderColoredTexturedDesaturate_Palette = NULL;
+		this->shaderColoredTexturedSepia_Palette = NULL;
 		this->deviceState_matrixChanged = true;
 		this->deviceState_systemColorChanged = true;
 		this->deviceState_colorModeFactorChanged = true;
@@ -290,6 +307,8 @@ namespace april
 	{
 		OpenGL_RenderSystem::_deviceSuspend();
 		this->_deviceUnloadTextures();
+		OpenGL_TextureUploader::destroy(); // the shared context is lost together with the main context
+		this->_destroyPixelUnpackBuffers();
 		this->_tryDestroyIntermediateRenderTextures();
 		this->_destroyShaders();
 	}
@@ -315,6 +334,10 @@ namespace april
 		this->caps.npotTexturesLimited = (extensions.contains("IMG_texture_npot") || extensions.contains("APPLE_texture_2D_limited_npot"));
 #endif
 		this->caps.npotTextures = (extensions.contains("OES_texture_npot") || extensions.contains("ARB_texture_non_power_of_two"));
+		if (extensions.contains("texture_filter_anisotropic"))
+		{
+			GL_SAFE_CALL(glGetFloatv, (GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &this->caps.maxAnisotropy));
+		}
 #ifdef __ANDROID__ // seems to not work on iOS
 		this->caps.externalTextures = extensions.contains("GL_OES_EGL_image_external");
 #endif
@@ -327,9 +350,65 @@ namespace april
 		this->etc1Supported = extensions.contains("OES_compressed_ETC1_RGB8_texture");
 		hlog::write(logTag, "ETC1 supported: " + hstr(this->etc1Supported ? "yes" : "no"));
 #endif
+		hstr version;
+		GL_SAFE_CALL(const GLubyte* versionString = glGetString, (GL_VERSION));
+		if (versionString != NULL)
+		{
+			version = (const char*)versionString;
+		}
+		// strided sub-rectangle uploads are core since OpenGLES 3.0
+		this->unpackSubimageSupported = (version.contains("OpenGL ES 3") || extensions.contains("EXT_unpack_subimage"));
+		hlog::write(logTag, "Unpack subimage supported: " + hstr(this->unpackSubimageSupported ? "yes" : "no"));
+#ifdef _EGL
+		// pixel unpack buffers and mapping buffer ranges are core since OpenGLES 3.0, but OpenGLES 2 headers don't declare them
+		this->pixelUnpackBufferSupported = false;
+		if (version.contains("OpenGL ES 3"))
+		{
+			this->genBuffers = &glGenBuffers;
+			this->deleteBuffers = &glDeleteBuffers;
+			this->bindBuffer = &glBindBuffer;
+			this->bufferData = &glBufferData;
+			this->mapBufferRange = (MapBufferRangeFunction)eglGetProcAddress("glMapBufferRange");
+			this->unmapBuffer = (UnmapBufferFunction)eglGetProcAddress("glUnmapBuffer");
+			this->pixelUnpackBufferSupported = (this->mapBufferRange != NULL && this->unmapBuffer != NULL);
+		}
+		hlog::write(logTag, "Pixel unpack buffers supported: " + hstr(this->pixelUnpackBufferSupported ? "yes" : "no"));
+#endif
+		// block formats that compressible textures can be encoded into at runtime, ETC2 is mandatory since OpenGLES 3.0
+		this->caps.blockFormats.clear();
+		if (version.contains("OpenGL ES 3") || extensions.contains("ARB_ES3_compatibility"))
+		{
+			this->caps.blockFormats += Image::BlockFormat::Etc2Rgb;
+			this->caps.blockFormats += Image::BlockFormat::Etc2Rgba;
+		}
+		else
+		{
+			if (extensions.contains("OES_compressed_ETC2_RGB8_texture"))
+			{
+				this->caps.blockFormats += Image::BlockFormat::Etc2Rgb;
+			}
+			if (extensions.contains("OES_compressed_ETC2_RGBA8_texture"))
+			{
+				this->caps.blockFormats += Image::BlockFormat::Etc2Rgba;
+			}
+		}
+		if (extensions.contains("EXT_texture_compression_s3tc") || extensions.contains("NV_texture_compression_s3tc"))
+		{
+			this->caps.blockFormats += Image::BlockFormat::Bc1;
+			this->caps.blockFormats += Image::BlockFormat::Bc3;
+		}
+		else if (extensions.contains("EXT_texture_compression_dxt1"))
+		{
+			this->caps.blockFormats += Image::BlockFormat::Bc1;
+		}
         // OpenGLES implementations do not appear to support alpha textures by default
 		this->caps.textureFormats /= Image::Format::Alpha;
 		this->caps.textureFormats /= Image::Format::Greyscale;
+		// palette indices are resolved in the pixel shader, NPOT support is required since index data can't be stretched to POT sizes
+		if (this->options.paletteTextures && (this->caps.npotTextures || this->caps.npotTexturesLimited) && !this->caps.textureFormats.has(Image::Format::Palette))
+		{
+			this->caps.textureFormats += Image::Format::Palette;
+		}
 		return OpenGL_RenderSystem::_deviceSetupCaps();
 	}
 
@@ -424,6 +503,17 @@ namespace april
 			LOAD_PIXEL_SHADER(this->pixelShaderColoredExTexturedSepia_AlphaHack, ColoredExTexturedSepia_AlphaHack, data);
 		}
 #endif
+		if (this->caps.textureFormats.has(Image::Format::Palette))
+		{
+			LOAD_PIXEL_SHADER(this->pixelShaderTexturedMultiply_Palette, TexturedMultiply_Palette, data);
+			LOAD_PIXEL_SHADER(this->pixelShaderTexturedLerp_Palette, TexturedLerp_Palette, data);
+			LOAD_PIXEL_SHADER(this->pixelShaderTexturedDesaturate_Palette, TexturedDesaturate_Palette, data);
+			LOAD_PIXEL_SHADER(this->pixelShaderTexturedSepia_Palette, TexturedSepia_Palette, data);
+			LOAD_PIXEL_SHADER(this->pixelShaderColoredTexturedMultiply_Palette, ColoredTexturedMultiply_Palette, data);
+			LOAD_PIXEL_SHADER(this->pixelShaderColoredTexturedLerp_Palette, ColoredTexturedLerp_Palette, data);
+			LOAD_PIXEL_SHADER(this->pixelShaderColoredTexturedDesaturate_Palette, ColoredTexturedDesaturate_Palette, data);
+			LOAD_PIXEL_SHADER(this->pixelShaderColoredTexturedSepia_Palette, ColoredTexturedSepia_Palette, data);
+		}
 		LOAD_PROGRAM(this->shaderMultiply, this->pixelShaderMultiply, this->vertexShaderPlain);
 		LOAD_PROGRAM(this->shaderAlphaMap, this->pixelShaderAlphaMap, this->vertexShaderPlain);
 		LOAD_PROGRAM(this->shaderLerp, this->pixelShaderLerp, this->vertexShaderPlain);
@@ -484,6 +574,17 @@ namespace april
 			LOAD_PROGRAM(this->shaderColoredExTexturedSepia_AlphaHack, this->pixelShaderColoredExTexturedSepia_AlphaHack, this->vertexShaderColoredTextured);
 		}
 #endif
+		if (this->caps.textureFormats.has(Image::Format::Palette))
+		{
+			LOAD_PROGRAM(this->shaderTexturedMultiply_Palette, this->pixelShaderTexturedMultiply_Palette, this->vertexShaderTextured);
+			LOAD_PROGRAM(this->shaderTexturedLerp_Palette, this->pixelShaderTexturedLerp_Palette, this->vertexShaderTextured);
+			LOAD_PROGRAM(this->shaderTexturedDesaturate_Palette, this->pixelShaderTexturedDesaturate_Palette, this->vertexShaderTextured);
+			LOAD_PROGRAM(this->shaderTexturedSepia_Palette, this->pixelShaderTexturedSepia_Palette, this->vertexShaderTextured);
+			LOAD_PROGRAM(this->shaderColoredTexturedMultiply_Palette, this->pixelShaderColoredTexturedMultiply_Palette, this->vertexShaderColoredTextured);
+			LOAD_PROGRAM(this->shaderColoredTexturedLerp_Palette, this->pixelShaderColoredTexturedLerp_Palette, this->vertexShaderColoredTextured);
+			LOAD_PROGRAM(this->shaderColoredTexturedDesaturate_Palette, this->pixelShaderColoredTexturedDesaturate_Palette, this->vertexShaderColoredTextured);
+			LOAD_PROGRAM(this->shaderColoredTexturedSepia_Palette, this->pixelShaderColoredTexturedSepia_Palette, this->vertexShaderColoredTextured);
+		}
 	}
 
 	void OpenGLES_RenderSystem::_destroyShaders()
@@ -552,6 +653,14 @@ namespace april
 			DELETE_PIXEL_SHADER(this->pixelShaderColoredExTexturedSepia_AlphaHack);
 		}
 #endif
+		DELETE_PIXEL_SHADER(this->pixelShaderTexturedMultiply_Palette);
+		DELETE_PIXEL_SHADER(this->pixelShaderTexturedLerp_Palette);
+		DELETE_PIXEL_SHADER(this->pixelShaderTexturedDesaturate_Palette);
+		DELETE_PIXEL_SHADER(this->pixelShaderTexturedSepia_Palette);
+		DELETE_PIXEL_SHADER(this->pixelShaderColoredTexturedMultiply_Palette);
+		DELETE_PIXEL_SHADER(this->pixelShaderColoredTexturedLerp_Palette);
+		DELETE_PIXEL_SHADER(this->pixelShaderColoredTexturedDesaturate_Palette);
+		DELETE_PIXEL_SHADER(this->pixelShaderColoredTexturedSepia_Palette);
 		_HL_TRY_DELETE(this->shaderMultiply);
 		_HL_TRY_DELETE(this->shaderAlphaMap);
 		_HL_TRY_DELETE(this->shaderLerp);
@@ -612,6 +721,14 @@ namespace april
 			_HL_TRY_DELETE(this->shaderColoredExTexturedSepia_AlphaHack);
 		}
 #endif
+		_HL_TRY_DELETE(this->shaderTexturedMultiply_Palette);
+		_HL_TRY_DELETE(this->shaderTexturedLerp_Palette);
+		_HL_TRY_DELETE(this->shaderTexturedDesaturate_Palette);
+		_HL_TRY_DELETE(this->shaderTexturedSepia_Palette);
+		_HL_TRY_DELETE(this->shaderColoredTexturedMultiply_Palette);
+		_HL_TRY_DELETE(this->shaderColoredTexturedLerp_Palette);
+		_HL_TRY_DELETE(this->shaderColoredTexturedDesaturate_Palette);
+		_HL_TRY_DELETE(this->shaderColoredTexturedSepia_Palette);
 	}
 
 	void OpenGLES_RenderSystem::_updateDeviceState(RenderState* state, bool forceUpdate, bool ignoreRenderTarget)
@@ -677,6 +794,12 @@ namespace april
 
 	void OpenGLES_RenderSystem::_setDeviceTexture(Texture* texture)
 	{
+		if (texture != NULL && ((OpenGLES_Texture*)texture)->paletteTextureId != 0)
+		{
+			GL_SAFE_CALL(glActiveTexture, (GL_TEXTURE1));
+			GL_SAFE_CALL(glBindTexture, (GL_TEXTURE_2D, ((OpenGLES_Texture*)texture)->paletteTextureId));
+			GL_SAFE_CALL(glActiveTexture, (GL_TEXTURE0));
+		}
 #ifdef __ANDROID__
 		if (texture != NULL)
 		{
@@ -831,6 +954,43 @@ namespace april
 			}
 		}
 #endif
+		OpenGLES_Texture* paletteTexture = (OpenGLES_Texture*)this->deviceState->texture;
+		bool usePalette = (this->deviceState->useTexture && paletteTexture != NULL && paletteTexture->paletteTextureId != 0);
+		if (usePalette)
+		{
+			if (shader == this->shaderTexturedMultiply)
+			{
+				shader = this->shaderTexturedMultiply_Palette;
+			}
+			else if (shader == this->shaderTexturedLerp)
+			{
+				shader = this->shaderTexturedLerp_Palette;
+			}
+			else if (shader == this->shaderTexturedDesaturate)
+			{
+				shader = this->shaderTexturedDesaturate_Palette;
+			}
+			else if (shader == this->shaderTexturedSepia)
+			{
+				shader = this->shaderTexturedSepia_Palette;
+			}
+			else if (shader == this->shaderColoredTexturedMultiply)
+			{
+				shader = this->shaderColoredTexturedMultiply_Palette;
+			}
+			else if (shader == this->shaderColoredTexturedLerp)
+			{
+				shader = this->shaderColoredTexturedLerp_Palette;
+			}
+			else if (shader == this->shaderColoredTexturedDesaturate)
+			{
+				shader = this->shaderColoredTexturedDesaturate_Palette;
+			}
+			else if (shader == this->shaderColoredTexturedSepia)
+			{
+				shader = this->shaderColoredTexturedSepia_Palette;
+			}
+		}
 		if (this->deviceState_shader != shader)
 		{
 			forceUpdate = true;
@@ -863,6 +1023,14 @@ namespace april
 					}
 				}
 #endif
+				if (usePalette) // will only be true if this->deviceState->useTexture is true
+				{
+					GL_SAFE_CALL(samplerLocation = glGetUniformLocation, (this->deviceState_shader->glShaderProgram, "sampler2dPalette"));
+					if (samplerLocation >= 0)
+					{
+						GL_SAFE_CALL(glUniform1i, (samplerLocation, 1));
+					}
+				}
 			}
 		}
 		if (this->deviceState_shader != NULL)
@@ -947,6 +1115,78 @@ namespace april
 		this->_updateDeviceState(&deviceState, true);
 	}
 
+	void OpenGLES_RenderSystem::_deviceCopyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgvec2i destinationPosition)
+	{
+		OpenGLES_Texture* glSource = (OpenGLES_Texture*)source;
+		OpenGLES_Texture* glDestination = (OpenGLES_Texture*)destination;
+		if (glSource->glFormat != glDestination->glFormat) // glCopyTexSubImage2D can't convert between formats
+		{
+			this->_deviceBlitTexture(source, destination, sourceRect, grecti(destinationPosition.x, destinationPosition.y, sourceRect.w, sourceRect.h));
+			return;
+		}
+		RenderState deviceState(*this->deviceState);
+		unsigned int previousFramebufferId = 0;
+		GL_SAFE_CALL(glGetIntegerv, (GL_FRAMEBUFFER_BINDING, (GLint*)&previousFramebufferId));
+		unsigned int framebufferId = glSource->framebufferId;
+		if (framebufferId == 0) // only render targets have their own framebuffer
+		{
+			GL_SAFE_CALL(glGenFramebuffers, (1, &framebufferId));
+			GL_SAFE_CALL(glBindFramebuffer, (GL_FRAMEBUFFER, framebufferId));
+			GL_SAFE_CALL(glFramebufferTexture2D, (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, glSource->internalType, glSource->textureId, 0));
+		}
+		else
+		{
+			GL_SAFE_CALL(glBindFramebuffer, (GL_FRAMEBUFFER, framebufferId));
+		}
+		bool copied = false;
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
+		{
+			glDestination->_setCurrentTexture();
+			glCopyTexSubImage2D(glDestination->internalType, 0, destinationPosition.x, destinationPosition.y, sourceRect.x, sourceRect.y, sourceRect.w, sourceRect.h);
+			copied = (glGetError() == GL_NO_ERROR);
+		}
+		GL_SAFE_CALL(glBindFramebuffer, (GL_FRAMEBUFFER, previousFramebufferId));
+		if (framebufferId != glSource->framebufferId)
+		{
+			glDeleteFramebuffers(1, &framebufferId);
+		}
+		this->_updateDeviceState(&deviceState, true);
+		if (!copied) // e.g. the source's format can't be attached to a framebuffer, but it can still be sampled
+		{
+			this->_deviceBlitTexture(source, destination, sourceRect, grecti(destinationPosition.x, destinationPosition.y, sourceRect.w, sourceRect.h));
+		}
+	}
+
+	void OpenGLES_RenderSystem::_deviceBlitTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect)
+	{
+		OpenGLES_Texture* glDestination = (OpenGLES_Texture*)destination;
+		if (glDestination->framebufferId != 0)
+		{
+			this->_renderTextureQuad(source, destination, sourceRect, destinationRect, true);
+			return;
+		}
+		// any texture can be rendered into while it's attached to a framebuffer, _setDeviceRenderTarget() binds it like a render target
+		unsigned int previousFramebufferId = 0;
+		GL_SAFE_CALL(glGetIntegerv, (GL_FRAMEBUFFER_BINDING, (GLint*)&previousFramebufferId));
+		unsigned int framebufferId = 0;
+		GL_SAFE_CALL(glGenFramebuffers, (1, &framebufferId));
+		GL_SAFE_CALL(glBindFramebuffer, (GL_FRAMEBUFFER, framebufferId));
+		GL_SAFE_CALL(glFramebufferTexture2D, (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, glDestination->internalType, glDestination->textureId, 0));
+		bool complete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+		GL_SAFE_CALL(glBindFramebuffer, (GL_FRAMEBUFFER, previousFramebufferId));
+		if (complete)
+		{
+			glDestination->framebufferId = framebufferId;
+			this->_renderTextureQuad(source, destination, sourceRect, destinationRect, true);
+			glDestination->framebufferId = 0;
+		}
+		else
+		{
+			hlog::error(logTag, "Cannot blit texture, the destination's format can't be rendered into: " + destination->_getInternalName());
+		}
+		glDeleteFramebuffers(1, &framebufferId);
+	}
+
 	void OpenGLES_RenderSystem::_deviceTakeScreenshot(Image::Format format, bool backBufferOnly)
 	{
 		int glFormat = GL_RGBA;
@@ -1030,5 +1270,43 @@ namespace april
 		GL_SAFE_CALL(glVertexAttribPointer, (COLOR_ARRAY, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, pointer));
 	}
 
+#ifdef _EGL
+	bool OpenGLES_RenderSystem::_deviceCreateUploadContext()
+	{
+		return april::egl->createUploadContext();
+	}
+
+	void OpenGLES_RenderSystem::_deviceDestroyUploadContext()
+	{
+		april::egl->destroyUploadContext();
+	}
+
+	bool OpenGLES_RenderSystem::_deviceSetUploadContextCurrent(bool current)
+	{
+		return april::egl->setUploadContextCurrent(current);
+	}
+
+	void* OpenGLES_RenderSystem::_deviceCreateUploadFence()
+	{
+		void* fence = april::egl->createFence();
+		if (fence == NULL)
+		{
+			return OpenGL_RenderSystem::_deviceCreateUploadFence();
+		}
+		GL_SAFE_CALL(glFlush, ()); // the fence has to reach the GPU, otherwise the render thread could wait for it forever
+		return fence;
+	}
+
+	bool OpenGLES_RenderSystem::_deviceWaitUploadFence(void* fence, bool wait)
+	{
+		return april::egl->waitFence(fence, wait);
+	}
+
+	void OpenGLES_RenderSystem::_deviceDestroyUploadFence(void* fence)
+	{
+		april::egl->destroyFence(fence);
+	}
+#endif
+
 }
 #endif
@@ -103,6 +103,14 @@ namespace april
 		OpenGLES_PixelShader* pixelShaderColoredExTexturedDesaturate_AlphaHack;
 		OpenGLES_PixelShader* pixelShaderColoredExTexturedSepia_AlphaHack;
 #endif
+		OpenGLES_PixelShader* pixelShaderTexturedMultiply_Palette;
+		OpenGLES_PixelShader* pixelShaderTexturedLerp_Palette;
+		OpenGLES_PixelShader* pixelShaderTexturedDesaturate_Palette;
+		OpenGLES_PixelShader* pixelShaderTexturedSepia_Palette;
+		OpenGLES_PixelShader* pixelShaderColoredTexturedMultiply_Palette;
+		OpenGLES_PixelShader* pixelShaderColoredTexturedLerp_Palette;
+		OpenGLES_PixelShader* pixelShaderColoredTexturedDesaturate_Palette;
+		OpenGLES_PixelShader* pixelShaderColoredTexturedSepia_Palette;
 		ShaderProgram* shaderMultiply;
 		ShaderProgram* shaderAlphaMap;
 		ShaderProgram* shaderLerp;
@@ -152,6 +160,14 @@ namespace april
 		ShaderProgram* shaderColoredExTexturedSepia_AlphaHack;
 		bool etc1Supported;
 #endif
+		ShaderProgram* shaderTexturedMultiply_Palette;
+		ShaderProgram* shaderTexturedLerp_Palette;
+		ShaderProgram* shaderTexturedDesaturate_Palette;
+		ShaderProgram* shaderTexturedSepia_Palette;
+		ShaderProgram* shaderColoredTexturedMultiply_Palette;
+		ShaderProgram* shaderColoredTexturedLerp_Palette;
+		ShaderProgram* shaderColoredTexturedDesaturate_Palette;
+		ShaderProgram* shaderColoredTexturedSepia_Palette;
 
 		bool deviceState_matrixChanged;
 		bool deviceState_systemColorChanged;
@@ -184,6 +200,8 @@ namespace april
 
 		void _devicePresentFrame(bool systemEnabled) override;
 		void _deviceCopyRenderTargetData(Texture* source, Texture* destination) override;
+		void _deviceCopyTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgvec2i destinationPosition) override;
+		void _deviceBlitTexture(Texture* source, Texture* destination, cgrecti sourceRect, cgrecti destinationRect) override;
 		void _deviceTakeScreenshot(Image::Format format, bool backBufferOnly) override;
 
 		void _setGlTextureEnabled(bool enabled) override;
@@ -192,6 +210,15 @@ namespace april
 		void _setGlTexturePointer(int stride, const void* pointer) override;
 		void _setGlColorPointer(int stride, const void* pointer) override;
 
+#ifdef _EGL
+		bool _deviceCreateUploadContext() override;
+		void _deviceDestroyUploadContext() override;
+		bool _deviceSetUploadContextCurrent(bool current) override;
+		void* _deviceCreateUploadFence() override;
+		bool _deviceWaitUploadFence(void* fence, bool wait) override;
+		void _deviceDestroyUploadFence(void* fence) override;
+#endif
+
 	};
 	
 }
@@ -8,6 +8,7 @@
 
 #ifdef _OPENGLES
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hstring.h>
 
 #include "april.h"
@@ -21,7 +22,8 @@ namespace april
 {
 	OpenGLES_Texture::OpenGLES_Texture(bool fromResource) :
 		OpenGL_Texture(fromResource),
-		framebufferId(0)
+		framebufferId(0),
+		paletteTextureId(0)
 	{
 #ifdef __ANDROID__
 		this->alphaTextureId = 0;
@@ -50,6 +52,16 @@ namespace april
 			GL_SAFE_CALL(glFramebufferTexture2D, (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, this->internalType, this->textureId, 0));
 			GL_SAFE_CALL(glBindFramebuffer, (GL_FRAMEBUFFER, previousFramebufferId));
 		}
+		if (this->format == Image::Format::Palette)
+		{
+			GL_SAFE_CALL(glGenTextures, (1, &this->paletteTextureId));
+			if (this->paletteTextureId == 0)
+			{
+				hlog::error(logTag, "Cannot create GL palette texture for: " + this->_getInternalName());
+				this->_deviceDestroyTexture();
+				return false;
+			}
+		}
 		// data has to be uploaded right away if compressed texture
 #ifdef _IOS
 		if (this->dataFormat == GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG || this->dataFormat == GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG)
@@ -122,6 +134,14 @@ namespace april
 			this->alphaTextureId = 0;
 		}
 #endif
+		if (this->paletteTextureId != 0)
+		{
+			if (april::rendersys->canUseLowLevelCalls())
+			{
+				glDeleteTextures(1, &this->paletteTextureId);
+			}
+			this->paletteTextureId = 0;
+		}
 		return OpenGL_Texture::_deviceDestroyTexture();
 	}
 
@@ -134,6 +154,114 @@ namespace april
 		}
 #endif
 		OpenGL_Texture::_assignFormat();
+		if (this->format == Image::Format::Palette)
+		{
+			// indices are stored in a single channel while the colors are resolved in the pixel shader
+			this->glFormat = this->internalFormat = GL_LUMINANCE;
+			// interpolated indices would result in wrong colors
+			this->filter = Filter::Nearest;
+		}
+	}
+
+	bool OpenGLES_Texture::_uploadToGpu(int sx, int sy, int sw, int sh, int dx, int dy, unsigned char* srcData, int srcWidth, int srcHeight, Image::Format srcFormat)
+	{
+		if (this->format != Image::Format::Palette || this->paletteTextureId == 0)
+		{
+			return OpenGL_Texture::_uploadToGpu(sx, sy, sw, sh, dx, dy, srcData, srcWidth, srcHeight, srcFormat);
+		}
+		if (srcFormat != Image::Format::Palette)
+		{
+			return false;
+		}
+		// the palette is always uploaded as a whole since it's tiny
+		this->_uploadPalette(srcData);
+		this->_setCurrentTexture();
+		unsigned char* indices = &srcData[APRIL_IMAGE_PALETTE_BYTE_SIZE];
+		if (sx == 0 && dx == 0 && sy == 0 && dy == 0 && sw == this->width && srcWidth == this->width && sh == this->height && srcHeight == this->height)
+		{
+			this->_uploadPotSafeData(indices);
+		}
+		else
+		{
+			if (this->firstUpload)
+			{
+				this->_uploadPotSafeClearData();
+			}
+			this->_uploadSubData(sx, sy, sw, sh, dx, dy, indices, srcWidth, 1); // the indices have 1 byte per pixel
+		}
+		this->firstUpload = false;
+		return true;
+	}
+
+	bool OpenGLES_Texture::_uploadBlockDataToGpu()
+	{
+		if (this->blockData == NULL || this->type == Type::External || this->type == Type::RenderTarget)
+		{
+			return false;
+		}
+		unsigned int glBlockFormat = 0;
+		if (this->blockFormat == Image::BlockFormat::Etc2Rgb)
+		{
+			glBlockFormat = GL_COMPRESSED_RGB8_ETC2;
+		}
+		else if (this->blockFormat == Image::BlockFormat::Etc2Rgba)
+		{
+			glBlockFormat = GL_COMPRESSED_RGBA8_ETC2_EAC;
+		}
+		else if (this->blockFormat == Image::BlockFormat::Bc1)
+		{
+			glBlockFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		}
+		else if (this->blockFormat == Image::BlockFormat::Bc3)
+		{
+			glBlockFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		}
+		else
+		{
+			return false;
+		}
+		this->_setCurrentTexture();
+		glCompressedTexImage2D(this->internalType, 0, glBlockFormat, this->width, this->height, 0, this->blockDataSize, this->blockData);
+		GLenum glError = glGetError();
+		SAFE_TEXTURE_UPLOAD_CHECK(glError, glCompressedTexImage2D(this->internalType, 0, glBlockFormat, this->width, this->height, 0, this->blockDataSize, this->blockData));
+		if (glError != GL_NO_ERROR)
+		{
+			return false;
+		}
+		this->firstUpload = false;
+		this->blockDataUploaded = true;
+		return true;
+	}
+
+	bool OpenGLES_Texture::_deviceCreateMipmaps(unsigned char* data, Image::Format format)
+	{
+		RenderSystem::Caps caps = april::rendersys->getCaps();
+		if (!caps.npotTextures && (this->width != hpotCeil(this->width) || this->height != hpotCeil(this->height)))
+		{
+			return false; // OpenGLES 2 doesn't support NPOT mipmaps
+		}
+		// the GPU creates the chain from the uploaded base level so the data isn't needed
+		this->_setCurrentTexture();
+		glGenerateMipmap(this->internalType);
+		if (glGetError() != GL_NO_ERROR)
+		{
+			return false;
+		}
+		this->mipmapLevels = Image::calcMipmapLevels(this->width, this->height);
+		APRIL_OGLES_RENDERSYS->_setDeviceTextureFilter(this->_getRenderFilter());
+		return true;
+	}
+
+	void OpenGLES_Texture::_uploadPalette(unsigned char* palette)
+	{
+		GL_SAFE_CALL(glActiveTexture, (GL_TEXTURE1));
+		GL_SAFE_CALL(glBindTexture, (GL_TEXTURE_2D, this->paletteTextureId));
+		GL_SAFE_CALL(glTexParameteri, (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+		GL_SAFE_CALL(glTexParameteri, (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+		GL_SAFE_CALL(glTexParameteri, (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+		GL_SAFE_CALL(glTexParameteri, (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+		GL_SAFE_CALL(glTexImage2D, (GL_TEXTURE_2D, 0, GL_RGBA, APRIL_IMAGE_PALETTE_COLORS, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, palette));
+		GL_SAFE_CALL(glActiveTexture, (GL_TEXTURE0));
 	}
 
 }
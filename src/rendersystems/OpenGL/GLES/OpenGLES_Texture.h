@@ -33,11 +33,17 @@ namespace april
 #ifdef __ANDROID__
 		unsigned int alphaTextureId;
 #endif
+		unsigned int paletteTextureId;
 
 		bool _deviceCreateTexture(unsigned char* data, int size) override;
 		bool _deviceDestroyTexture() override;
 		void _assignFormat() override;
 
+		bool _uploadToGpu(int sx, int sy, int sw, int sh, int dx, int dy, unsigned char* srcData, int srcWidth, int srcHeight, Image::Format srcFormat) override;
+		void _uploadPalette(unsigned char* palette);
+		bool _uploadBlockDataToGpu() override;
+		bool _deviceCreateMipmaps(unsigned char* data, Image::Format format) override;
+
 	};
 
 }
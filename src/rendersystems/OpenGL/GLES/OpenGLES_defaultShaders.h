@@ -120,6 +120,18 @@
 	uniform samplerExternalOES sampler2dAlpha; \n\
 "
 
+// pixel header defines (PALETTE)
+#define SHADER_PIXEL_Textured_Palette_Include "\
+" SHADER_PIXEL_Textured_Include "\
+	uniform sampler2D sampler2dPalette; \n\
+"
+#define SHADER_PIXEL_ColoredTextured_Palette_Include "\
+" SHADER_PIXEL_ColoredTextured_Include "\
+	uniform sampler2D sampler2dPalette; \n\
+"
+// the index is remapped to the center of the palette texel
+#define MAKE_PALETTE_LOOKUP "texture2D(sampler2dPalette, vec2(texture2D(sampler2d, texFrag).r * 0.99609375 + 0.001953125, 0.5))"
+
 // vertex shaders
 #define SHADER_VertexPlain SHADER_VERTEX_Plain_Include "\
 	void main(void) \n\
@@ -577,5 +589,69 @@
 	} \n\
 "
 
+#define SHADER_PixelTexturedMultiply_Palette SHADER_PIXEL_Textured_Palette_Include "\
+	void main(void) \n\
+	{ \n\
+		gl_FragColor = " MAKE_PALETTE_LOOKUP " * systemColor; \n\
+	} \n\
+"
+#define SHADER_PixelTexturedLerp_Palette SHADER_PIXEL_Textured_Palette_Include "\
+	uniform highp float lerpAlpha; \n\
+	void main(void) \n\
+	{ \n\
+		highp vec4 tex = " MAKE_PALETTE_LOOKUP "; \n\
+		gl_FragColor = vec4(mix(tex.rgb, systemColor.rgb, lerpAlpha), tex.a * systemColor.a); \n\
+	} \n\
+"
+#define SHADER_PixelTexturedDesaturate_Palette SHADER_PIXEL_Textured_Palette_Include "\
+	uniform highp float lerpAlpha; \n\
+	void main(void) \n\
+	{ \n\
+		highp vec4 tex = " MAKE_PALETTE_LOOKUP "; \n\
+		highp float value = " MAKE_DESATURATE(tex) "; \n\
+		gl_FragColor = vec4(value * systemColor.r, value * systemColor.g, value * systemColor.b, tex.a * systemColor.a); \n\
+	} \n\
+"
+#define SHADER_PixelTexturedSepia_Palette SHADER_PIXEL_Textured_Palette_Include "\
+	uniform highp float lerpAlpha; \n\
+	void main(void) \n\
+	{ \n\
+		highp vec4 tex = " MAKE_PALETTE_LOOKUP "; \n\
+		gl_FragColor = vec4(" MAKE_SEPIA(tex) " * systemColor.rgb, tex.a * systemColor.a); \n\
+	} \n\
+"
+
+#define SHADER_PixelColoredTexturedMultiply_Palette SHADER_PIXEL_ColoredTextured_Palette_Include "\
+	void main(void) \n\
+	{ \n\
+		gl_FragColor = " MAKE_PALETTE_LOOKUP " * colorFrag; \n\
+	} \n\
+"
+#define SHADER_PixelColoredTexturedLerp_Palette SHADER_PIXEL_ColoredTextured_Palette_Include "\
+	uniform highp float lerpAlpha; \n\
+	void main(void) \n\
+	{ \n\
+		highp vec4 tex = " MAKE_PALETTE_LOOKUP "; \n\
+		gl_FragColor = vec4(mix(tex.rgb, colorFrag.rgb, lerpAlpha), tex.a * colorFrag.a); \n\
+	} \n\
+"
+#define SHADER_PixelColoredTexturedDesaturate_Palette SHADER_PIXEL_ColoredTextured_Palette_Include "\
+	uniform highp float lerpAlpha; \n\
+	void main(void) \n\
+	{ \n\
+		highp vec4 tex = " MAKE_PALETTE_LOOKUP "; \n\
+		highp float value = " MAKE_DESATURATE(tex) "; \n\
+		gl_FragColor = vec4(value * colorFrag.r, value * colorFrag.g, value * colorFrag.b, tex.a * colorFrag.a); \n\
+	} \n\
+"
+#define SHADER_PixelColoredTexturedSepia_Palette SHADER_PIXEL_ColoredTextured_Palette_Include "\
+	uniform highp float lerpAlpha; \n\
+	void main(void) \n\
+	{ \n\
+		highp vec4 tex = " MAKE_PALETTE_LOOKUP "; \n\
+		gl_FragColor = vec4(" MAKE_SEPIA(tex) " * colorFrag.rgb, tex.a * colorFrag.a); \n\
+	} \n\
+"
+
 #endif
 #endif
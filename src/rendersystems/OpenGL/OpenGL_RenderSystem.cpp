@@ -29,6 +29,7 @@
 #include "Image.h"
 #include "OpenGL_RenderSystem.h"
 #include "OpenGL_Texture.h"
+#include "OpenGL_TextureUploader.h"
 #include "Platform.h"
 #include "RenderState.h"
 #include "UpdateDelegate.h"
@@ -40,6 +41,9 @@
 #define _SEGMENTED_RENDERING
 #endif
 #define MAX_VERTEX_COUNT 65535
+#define MAX_LOCK_BUFFERS 4
+#define MAX_LOCK_BUFFER_SIZE (1024 * 1024 * 4)
+#define PIXEL_UNPACK_BUFFER_COUNT 3
 
 namespace april
 {
@@ -57,6 +61,19 @@ namespace april
 	OpenGL_RenderSystem::OpenGL_RenderSystem() :
 		RenderSystem(),
 		blendSeparationSupported(false),
+		unpackSubimageSupported(false),
+		uploadStagingBuffer(NULL),
+		uploadStagingBufferSize(0),
+		pixelUnpackBufferSupported(false),
+		genBuffers(NULL),
+		deleteBuffers(NULL),
+		bindBuffer(NULL),
+		bufferData(NULL),
+		mapBufferRange(NULL),
+		unmapBuffer(NULL),
+		pixelUnpackBufferIndex(0),
+		pixelUnpackBufferData(NULL),
+		pixelUnpackBufferBound(false),
 		deviceState_vertexStride(0),
 		deviceState_vertexPointer(NULL),
 		deviceState_textureStride(0),
@@ -96,6 +113,15 @@ namespace april
 
 	bool OpenGL_RenderSystem::_deviceDestroy()
 	{
+		OpenGL_TextureUploader::destroy(); // the shared context has to be gone before the main context
+		if (this->uploadStagingBuffer != NULL)
+		{
+			delete[] this->uploadStagingBuffer;
+			this->uploadStagingBuffer = NULL;
+			this->uploadStagingBufferSize = 0;
+		}
+		this->_clearLockBufferPool();
+		this->_destroyPixelUnpackBuffers();
 #if defined(_WIN32) && !defined(_UWP)
 		this->_releaseWindow();
 #endif
@@ -114,6 +140,36 @@ namespace april
 		GL_SAFE_CALL(glGetIntegerv, (GL_MAX_TEXTURE_SIZE, &this->caps.maxTextureSize));
 	}
 
+	bool OpenGL_RenderSystem::_deviceCreateUploadContext()
+	{
+		return false;
+	}
+
+	void OpenGL_RenderSystem::_deviceDestroyUploadContext()
+	{
+	}
+
+	bool OpenGL_RenderSystem::_deviceSetUploadContextCurrent(bool current)
+	{
+		return false;
+	}
+
+	void* OpenGL_RenderSystem::_deviceCreateUploadFence()
+	{
+		// without fences the upload thread has to block until the upload is done
+		GL_SAFE_CALL(glFinish, ());
+		return NULL;
+	}
+
+	bool OpenGL_RenderSystem::_deviceWaitUploadFence(void* fence, bool wait)
+	{
+		return true;
+	}
+
+	void OpenGL_RenderSystem::_deviceDestroyUploadFence(void* fence)
+	{
+	}
+
 #if defined(_WIN32) && !defined(_UWP)
 	void OpenGL_RenderSystem::_releaseWindow()
 	{
@@ -215,7 +271,17 @@ namespace april
 	{
 		if (texture != NULL)
 		{
-			GL_SAFE_CALL(glBindTexture, (((OpenGL_Texture*)texture)->internalType, ((OpenGL_Texture*)texture)->textureId));
+			OpenGL_Texture* glTexture = (OpenGL_Texture*)texture;
+			GL_SAFE_CALL(glBindTexture, (glTexture->internalType, glTexture->textureId));
+			if (this->caps.maxAnisotropy > 1.0f)
+			{
+				float anisotropy = hclamp(glTexture->getAnisotropy(), 1.0f, this->caps.maxAnisotropy);
+				if (anisotropy != glTexture->deviceAnisotropy)
+				{
+					GL_SAFE_CALL(glTexParameterf, (glTexture->internalType, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy));
+					glTexture->deviceAnisotropy = anisotropy;
+				}
+			}
 		}
 		else
 		{
@@ -236,6 +302,16 @@ namespace april
 			GL_SAFE_CALL(glTexParameteri, (type, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
 			GL_SAFE_CALL(glTexParameteri, (type, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
 		}
+		else if (textureFilter == Texture::Filter::MipNearest)
+		{
+			GL_SAFE_CALL(glTexParameteri, (type, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+			GL_SAFE_CALL(glTexParameteri, (type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST));
+		}
+		else if (textureFilter == Texture::Filter::MipLinear)
+		{
+			GL_SAFE_CALL(glTexParameteri, (type, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+			GL_SAFE_CALL(glTexParameteri, (type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+		}
 		else
 		{
 			hlog::warn(logTag, "Trying to set unsupported texture filter!");
@@ -423,6 +499,218 @@ namespace april
 		}
 	}
 
+	unsigned char* OpenGL_RenderSystem::_packUploadData(int x, int y, int w, int h, unsigned char* data, int dataWidth, int bpp)
+	{
+		int rowSize = w * bpp;
+		int size = rowSize * h;
+		unsigned char* buffer = this->_mapPixelUnpackBuffer(size);
+		if (buffer == NULL)
+		{
+			if (this->uploadStagingBufferSize < size) // the buffer is reused, because sub-rectangle uploads usually happen every frame
+			{
+				if (this->uploadStagingBuffer != NULL)
+				{
+					delete[] this->uploadStagingBuffer;
+				}
+				this->uploadStagingBuffer = new unsigned char[size];
+				this->uploadStagingBufferSize = size;
+			}
+			buffer = this->uploadStagingBuffer;
+		}
+		for_iter (j, 0, h)
+		{
+			memcpy(&buffer[j * rowSize], &data[(x + (y + j) * dataWidth) * bpp], rowSize);
+		}
+		return this->_getLockBufferUploadData(buffer);
+	}
+
+	void OpenGL_RenderSystem::_releasePackedUploadData()
+	{
+		if (this->pixelUnpackBufferData != NULL)
+		{
+			this->_releasePixelUnpackBuffer();
+		}
+	}
+
+	unsigned char* OpenGL_RenderSystem::_acquireLockBuffer(int size, bool staging)
+	{
+		if (staging)
+		{
+			unsigned char* buffer = this->_mapPixelUnpackBuffer(size);
+			if (buffer != NULL)
+			{
+				return buffer;
+			}
+		}
+		int index = -1;
+		for_iter (i, 0, this->lockBufferPoolSizes.size())
+		{
+			if (this->lockBufferPoolSizes[i] == size) // exact matches are the common case, because the same regions are usually locked every frame
+			{
+				index = i;
+				break;
+			}
+			if (this->lockBufferPoolSizes[i] > size && (index < 0 || this->lockBufferPoolSizes[i] < this->lockBufferPoolSizes[index]))
+			{
+				index = i;
+			}
+		}
+		if (index < 0)
+		{
+			return new unsigned char[size];
+		}
+		unsigned char* buffer = this->lockBufferPool.removeAt(index);
+		this->lockBufferPoolSizes.removeAt(index);
+		return buffer;
+	}
+
+	unsigned char* OpenGL_RenderSystem::_getLockBufferUploadData(unsigned char* buffer)
+	{
+		if (buffer != NULL && buffer == this->pixelUnpackBufferData && this->_bindPixelUnpackBuffer())
+		{
+			return NULL; // GL reads from offset 0 of the bound buffer
+		}
+		return buffer;
+	}
+
+	void OpenGL_RenderSystem::_releaseLockBuffer(unsigned char* buffer, int size)
+	{
+		if (buffer != NULL && buffer == this->pixelUnpackBufferData)
+		{
+			this->_releasePixelUnpackBuffer();
+			return;
+		}
+		// large buffers are only needed for rare full texture conversions and shouldn't stay allocated
+		if (size > MAX_LOCK_BUFFER_SIZE)
+		{
+			delete[] buffer;
+			return;
+		}
+		if (this->lockBufferPool.size() >= MAX_LOCK_BUFFERS)
+		{
+			// the smallest buffer is the least useful one to keep around
+			int index = 0;
+			for_iter (i, 1, this->lockBufferPoolSizes.size())
+			{
+				if (this->lockBufferPoolSizes[i] < this->lockBufferPoolSizes[index])
+				{
+					index = i;
+				}
+			}
+			if (this->lockBufferPoolSizes[index] >= size)
+			{
+				delete[] buffer;
+				return;
+			}
+			delete[] this->lockBufferPool.removeAt(index);
+			this->lockBufferPoolSizes.removeAt(index);
+		}
+		this->lockBufferPool += buffer;
+		this->lockBufferPoolSizes += size;
+	}
+
+	void OpenGL_RenderSystem::_clearLockBufferPool()
+	{
+		foreach (unsigned char*, it, this->lockBufferPool)
+		{
+			delete[] (*it);
+		}
+		this->lockBufferPool.clear();
+		this->lockBufferPoolSizes.clear();
+	}
+
+	unsigned char* OpenGL_RenderSystem::_mapPixelUnpackBuffer(int size)
+	{
+		// only one buffer is written at a time, nested requests use CPU memory
+		if (!this->pixelUnpackBufferSupported || this->pixelUnpackBufferData != NULL || size <= 0)
+		{
+			return NULL;
+		}
+		if (this->pixelUnpackBuffers.size() == 0)
+		{
+			unsigned int buffers[PIXEL_UNPACK_BUFFER_COUNT] = { 0 };
+			this->genBuffers(PIXEL_UNPACK_BUFFER_COUNT, buffers);
+			for_iter (i, 0, PIXEL_UNPACK_BUFFER_COUNT)
+			{
+				if (buffers[i] == 0)
+				{
+					hlog::warn(logTag, "Could not create pixel unpack buffers, texture uploads are staged in RAM.");
+					this->deleteBuffers(PIXEL_UNPACK_BUFFER_COUNT, buffers);
+					this->pixelUnpackBufferSupported = false;
+					return NULL;
+				}
+				this->pixelUnpackBuffers += buffers[i];
+				this->pixelUnpackBufferSizes += 0;
+			}
+			this->pixelUnpackBufferIndex = 0;
+		}
+		int index = this->pixelUnpackBufferIndex;
+		this->bindBuffer(GL_PIXEL_UNPACK_BUFFER, this->pixelUnpackBuffers[index]);
+		if (this->pixelUnpackBufferSizes[index] < size)
+		{
+			this->bufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+			this->pixelUnpackBufferSizes[index] = size;
+		}
+		// invalidating lets the driver hand out fresh memory instead of waiting until the GPU has read the previous upload from this buffer
+		void* data = this->mapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		this->bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); // other uploads must not read from it
+		if (data == NULL)
+		{
+			return NULL;
+		}
+		this->pixelUnpackBufferData = (unsigned char*)data;
+		return this->pixelUnpackBufferData;
+	}
+
+	bool OpenGL_RenderSystem::_bindPixelUnpackBuffer()
+	{
+		if (this->pixelUnpackBufferData == NULL || this->pixelUnpackBufferBound)
+		{
+			return this->pixelUnpackBufferBound;
+		}
+		this->bindBuffer(GL_PIXEL_UNPACK_BUFFER, this->pixelUnpackBuffers[this->pixelUnpackBufferIndex]);
+		if (this->unmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+		{
+			hlog::warn(logTag, "Pixel unpack buffer data was lost, texture upload could be corrupted.");
+		}
+		this->pixelUnpackBufferBound = true;
+		return true;
+	}
+
+	void OpenGL_RenderSystem::_releasePixelUnpackBuffer()
+	{
+		if (this->pixelUnpackBufferData == NULL)
+		{
+			return;
+		}
+		if (!this->pixelUnpackBufferBound) // the data was never uploaded
+		{
+			this->bindBuffer(GL_PIXEL_UNPACK_BUFFER, this->pixelUnpackBuffers[this->pixelUnpackBufferIndex]);
+			this->unmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+		this->bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		this->pixelUnpackBufferData = NULL;
+		this->pixelUnpackBufferBound = false;
+		this->pixelUnpackBufferIndex = (this->pixelUnpackBufferIndex + 1) % this->pixelUnpackBuffers.size();
+	}
+
+	void OpenGL_RenderSystem::_destroyPixelUnpackBuffers()
+	{
+		if (this->pixelUnpackBuffers.size() > 0 && this->canUseLowLevelCalls())
+		{
+			this->_releasePixelUnpackBuffer();
+			foreach (unsigned int, it, this->pixelUnpackBuffers)
+			{
+				this->deleteBuffers(1, &(*it));
+			}
+		}
+		this->pixelUnpackBuffers.clear();
+		this->pixelUnpackBufferSizes.clear();
+		this->pixelUnpackBufferIndex = 0;
+		this->pixelUnpackBufferData = NULL;
+		this->pixelUnpackBufferBound = false;
+	}
+
 	Image::Format OpenGL_RenderSystem::getNativeTextureFormat(Image::Format format) const
 	{
 		if (format == Image::Format::ARGB || format == Image::Format::ABGR || format == Image::Format::RGBA)
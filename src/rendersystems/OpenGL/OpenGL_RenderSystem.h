@@ -53,6 +53,57 @@
 #define GL_ETCX_RGBA8_OES_HACK (GL_ETC1_RGB8_OES | (1u << 31))
 #endif
 
+// formats for runtime block compression, not all GL headers define them
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+// anisotropic filtering, not all GL headers define it
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+// strided pixel uploads, OpenGLES 2 headers only define them with EXT_unpack_subimage
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+#ifndef GL_UNPACK_SKIP_ROWS
+#define GL_UNPACK_SKIP_ROWS 0x0CF3
+#endif
+#ifndef GL_UNPACK_SKIP_PIXELS
+#define GL_UNPACK_SKIP_PIXELS 0x0CF4
+#endif
+// pixel unpack buffers, GL1 headers on Windows and OpenGLES 2 headers don't define them
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_BUFFER_BIT
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#endif
+#ifdef GL_APIENTRY
+	#define APRIL_GL_APIENTRY GL_APIENTRY
+#elif defined(APIENTRY)
+	#define APRIL_GL_APIENTRY APIENTRY
+#else
+	#define APRIL_GL_APIENTRY
+#endif
+
 #ifndef _DEBUG
 	#define GL_SAFE_CALL(function, params) function params;
 #else
@@ -69,6 +120,7 @@
 
 #include <gtypes/Rectangle.h>
 #include <gtypes/Vector2.h>
+#include <hltypes/harray.h>
 #include <hltypes/hstring.h>
 
 #include "Color.h"
@@ -77,12 +129,14 @@
 namespace april
 {
 	class OpenGL_Texture;
+	class OpenGL_TextureUploader;
 	class Window;
 
 	class OpenGL_RenderSystem : public RenderSystem
 	{
 	public:
 		friend class OpenGL_Texture;
+		friend class OpenGL_TextureUploader;
 
 		OpenGL_RenderSystem();
 
@@ -92,7 +146,34 @@ namespace april
 		unsigned int getNativeColorUInt(const april::Color& color) const override;
 
 	protected:
+		// buffer object functions are loaded at runtime, because not every GL version or platform header provides them
+		typedef void (APRIL_GL_APIENTRY *GenBuffersFunction)(GLsizei, GLuint*);
+		typedef void (APRIL_GL_APIENTRY *DeleteBuffersFunction)(GLsizei, const GLuint*);
+		typedef void (APRIL_GL_APIENTRY *BindBufferFunction)(GLenum, GLuint);
+		typedef void (APRIL_GL_APIENTRY *BufferDataFunction)(GLenum, GLsizeiptr, const void*, GLenum);
+		typedef void* (APRIL_GL_APIENTRY *MapBufferRangeFunction)(GLenum, GLintptr, GLsizeiptr, GLbitfield);
+		typedef GLboolean (APRIL_GL_APIENTRY *UnmapBufferFunction)(GLenum);
+
 		bool blendSeparationSupported;
+		bool unpackSubimageSupported;
+		unsigned char* uploadStagingBuffer;
+		int uploadStagingBufferSize;
+		// released texture lock buffers, kept for reuse by following locks
+		harray<unsigned char*> lockBufferPool;
+		harray<int> lockBufferPoolSizes;
+		// ring of pixel unpack buffers that stage sub-rectangle uploads, so the driver can copy them to the GPU asynchronously
+		bool pixelUnpackBufferSupported;
+		GenBuffersFunction genBuffers;
+		DeleteBuffersFunction deleteBuffers;
+		BindBufferFunction bindBuffer;
+		BufferDataFunction bufferData;
+		MapBufferRangeFunction mapBufferRange;
+		UnmapBufferFunction unmapBuffer;
+		harray<unsigned int> pixelUnpackBuffers;
+		harray<int> pixelUnpackBufferSizes;
+		int pixelUnpackBufferIndex;
+		unsigned char* pixelUnpackBufferData;
+		bool pixelUnpackBufferBound;
 
 		int deviceState_vertexStride;
 		const void* deviceState_vertexPointer;
@@ -135,6 +216,25 @@ namespace april
 		virtual void _setGlTexturePointer(int stride, const void* pointer) = 0;
 		virtual void _setGlColorPointer(int stride, const void* pointer) = 0;
 
+		unsigned char* _packUploadData(int x, int y, int w, int h, unsigned char* data, int dataWidth, int bpp);
+		void _releasePackedUploadData();
+		unsigned char* _acquireLockBuffer(int size, bool staging);
+		unsigned char* _getLockBufferUploadData(unsigned char* buffer);
+		void _releaseLockBuffer(unsigned char* buffer, int size);
+		void _clearLockBufferPool();
+		unsigned char* _mapPixelUnpackBuffer(int size);
+		bool _bindPixelUnpackBuffer();
+		void _releasePixelUnpackBuffer();
+		void _destroyPixelUnpackBuffers();
+
+		// shared context for the background texture upload thread, not every platform can create one
+		virtual bool _deviceCreateUploadContext();
+		virtual void _deviceDestroyUploadContext();
+		virtual bool _deviceSetUploadContextCurrent(bool current);
+		virtual void* _deviceCreateUploadFence();
+		virtual bool _deviceWaitUploadFence(void* fence, bool wait);
+		virtual void _deviceDestroyUploadFence(void* fence);
+
 #if defined(_WIN32) && !defined(_UWP)
 	public:
 		inline HDC getHDC() { return this->hDC; }
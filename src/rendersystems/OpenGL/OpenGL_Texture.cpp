@@ -11,12 +11,14 @@
 #include <hltypes/hplatform.h>
 
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hstring.h>
 
 #include "april.h"
 #include "Image.h"
 #include "OpenGL_RenderSystem.h"
 #include "OpenGL_Texture.h"
+#include "OpenGL_TextureUploader.h"
 #include "RenderState.h"
 
 #define OGL_RENDERSYS ((OpenGL_RenderSystem*)april::rendersys)
@@ -30,7 +32,8 @@ namespace april
 		textureId(0),
 		glFormat(0),
 		internalFormat(0),
-		internalType(GL_TEXTURE_2D)
+		internalType(GL_TEXTURE_2D),
+		deviceAnisotropy(1.0f)
 	{
 	}
 
@@ -53,6 +56,7 @@ namespace april
 	
 	bool OpenGL_Texture::_deviceDestroyTexture()
 	{
+		OpenGL_TextureUploader::cancel(this); // the upload thread could still be reading the data
 		if (this->textureId != 0)
 		{
 			if (april::rendersys->canUseLowLevelCalls())
@@ -60,6 +64,7 @@ namespace april
 				glDeleteTextures(1, &this->textureId);
 			}
 			this->textureId = 0;
+			this->deviceAnisotropy = 1.0f;
 			this->firstUpload = true;
 			return true;
 		}
@@ -125,10 +130,42 @@ namespace april
 		}
 	}
 
+	bool OpenGL_Texture::_deviceUploadInBackground(unsigned char* data)
+	{
+		if (!april::rendersys->canUseLowLevelCalls())
+		{
+			return false;
+		}
+		// the upload thread can't fall back to POT data
+		RenderSystem::Caps caps = april::rendersys->getCaps();
+		if (!caps.npotTexturesLimited && !caps.npotTextures && (this->width != hpotCeil(this->width) || this->height != hpotCeil(this->height)))
+		{
+			return false;
+		}
+		return OpenGL_TextureUploader::queue(this, data);
+	}
+
+	bool OpenGL_Texture::_deviceTryFinishBackgroundUpload(bool wait, bool* success)
+	{
+		unsigned int textureId = 0;
+		if (!OpenGL_TextureUploader::tryFinish(this, wait, &textureId))
+		{
+			return false;
+		}
+		*success = (textureId != 0);
+		if (*success)
+		{
+			this->textureId = textureId;
+			this->firstUpload = false;
+			this->_setCurrentTexture(); // binding it here makes the upload visible to this context and applies the actual filter and address mode
+		}
+		return true;
+	}
+
 	void OpenGL_Texture::_setCurrentTexture()
 	{
 		// filtering and address mode applied before loading texture data, some systems are optimized to work like this (e.g. iOS OpenGLES guidelines suggest it)
-		OGL_RENDERSYS->_setDeviceTextureFilter(this->filter);
+		OGL_RENDERSYS->_setDeviceTextureFilter(this->_getRenderFilter());
 		OGL_RENDERSYS->_setDeviceTextureAddressMode(this->addressMode);
 		OGL_RENDERSYS->_setDeviceTexture(this);
 		OGL_RENDERSYS->deviceState->texture = this;
@@ -138,7 +175,9 @@ namespace april
 	{
 		Lock lock;
 		Image::Format nativeFormat = april::rendersys->getNativeTextureFormat(this->format);
-		lock.activateLock(0, 0, w, h, x, y, new unsigned char[w * h * nativeFormat.getBpp()], w, h, nativeFormat);
+		// full locks keep their data for the mipmaps, so only sub-rectangles can be staged in write-only GPU buffers
+		bool staging = (w != this->width || h != this->height);
+		lock.activateLock(0, 0, w, h, x, y, OGL_RENDERSYS->_acquireLockBuffer(w * h * nativeFormat.getBpp(), staging), w, h, nativeFormat);
 		lock.systemBuffer = lock.data;
 		return lock;
 	}
@@ -157,6 +196,8 @@ namespace april
 				if (this->width == lock.w && this->height == lock.h)
 				{
 					this->_uploadPotSafeData(lock.data);
+					this->firstUpload = false;
+					this->_updateMipmaps(lock.data, lock.format);
 				}
 				else
 				{
@@ -164,12 +205,13 @@ namespace april
 					{
 						this->_uploadPotSafeClearData();
 					}
-					GL_SAFE_CALL(glTexSubImage2D, (this->internalType, 0, lock.dx, lock.dy, lock.w, lock.h, this->glFormat, GL_UNSIGNED_BYTE, lock.data));
+					GL_SAFE_CALL(glTexSubImage2D, (this->internalType, 0, lock.dx, lock.dy, lock.w, lock.h, this->glFormat, GL_UNSIGNED_BYTE, OGL_RENDERSYS->_getLockBufferUploadData(lock.data)));
+					this->firstUpload = false;
+					this->_invalidateMipmaps();
 				}
-				this->firstUpload = false;
 			}
 		}
-		delete[] lock.data;
+		OGL_RENDERSYS->_releaseLockBuffer(lock.data, lock.dataWidth * lock.dataHeight * lock.format.getBpp());
 		return update;
 	}
 
@@ -183,6 +225,9 @@ namespace april
 		if (sx == 0 && dx == 0 && sy == 0 && dy == 0 && sw == this->width && srcWidth == this->width && sh == this->height && srcHeight == this->height)
 		{
 			this->_uploadPotSafeData(srcData);
+			this->firstUpload = false;
+			this->_updateMipmaps(srcData, srcFormat);
+			return true;
 		}
 		else
 		{
@@ -190,20 +235,86 @@ namespace april
 			{
 				this->_uploadPotSafeClearData();
 			}
-			int srcBpp = srcFormat.getBpp();
-			if (sx == 0 && dx == 0 && sw == this->width && srcWidth == this->width)
-			{
-				GL_SAFE_CALL(glTexSubImage2D, (this->internalType, 0, dx, dy, sw, sh, this->glFormat, GL_UNSIGNED_BYTE, &srcData[(sx + sy * srcWidth) * srcBpp]));
-			}
-			else
+			this->_uploadSubData(sx, sy, sw, sh, dx, dy, srcData, srcWidth, srcFormat.getBpp());
+		}
+		this->firstUpload = false;
+		this->_invalidateMipmaps();
+		return true;
+	}
+
+	void OpenGL_Texture::_uploadSubData(int sx, int sy, int sw, int sh, int dx, int dy, unsigned char* srcData, int srcWidth, int srcBpp)
+	{
+		if (sx == 0 && sw == srcWidth) // source rows are contiguous already
+		{
+			GL_SAFE_CALL(glTexSubImage2D, (this->internalType, 0, dx, dy, sw, sh, this->glFormat, GL_UNSIGNED_BYTE, &srcData[(sx + sy * srcWidth) * srcBpp]));
+		}
+		else if (OGL_RENDERSYS->unpackSubimageSupported)
+		{
+			GL_SAFE_CALL(glPixelStorei, (GL_UNPACK_ROW_LENGTH, srcWidth));
+			GL_SAFE_CALL(glPixelStorei, (GL_UNPACK_SKIP_PIXELS, sx));
+			GL_SAFE_CALL(glPixelStorei, (GL_UNPACK_SKIP_ROWS, sy));
+			GL_SAFE_CALL(glTexSubImage2D, (this->internalType, 0, dx, dy, sw, sh, this->glFormat, GL_UNSIGNED_BYTE, srcData));
+			GL_SAFE_CALL(glPixelStorei, (GL_UNPACK_ROW_LENGTH, 0));
+			GL_SAFE_CALL(glPixelStorei, (GL_UNPACK_SKIP_PIXELS, 0));
+			GL_SAFE_CALL(glPixelStorei, (GL_UNPACK_SKIP_ROWS, 0));
+		}
+		else // packing the rows once is cheaper than a driver call per row
+		{
+			GL_SAFE_CALL(glTexSubImage2D, (this->internalType, 0, dx, dy, sw, sh, this->glFormat, GL_UNSIGNED_BYTE, OGL_RENDERSYS->_packUploadData(sx, sy, sw, sh, srcData, srcWidth, srcBpp)));
+			OGL_RENDERSYS->_releasePackedUploadData();
+		}
+	}
+
+	void OpenGL_Texture::_invalidateMipmaps()
+	{
+		// rebuilding the chain after every sub-rectangle would be repeated for every dirty rect, tile or atlas write,
+		// so the chain is only rebuilt once after all changes were uploaded
+		if (this->_isMipmapFilter())
+		{
+			this->mipmapsOutdated = true;
+		}
+	}
+
+	bool OpenGL_Texture::_deviceCreateMipmaps(unsigned char* data, Image::Format format)
+	{
+		if (data == NULL)
+		{
+			return false;
+		}
+		RenderSystem::Caps caps = april::rendersys->getCaps();
+		if (!caps.npotTextures && (this->width != hpotCeil(this->width) || this->height != hpotCeil(this->height)))
+		{
+			return false; // NPOT mipmaps aren't supported everywhere
+		}
+		// fixed function GL has no reliable GPU mipmap generation so the chain is created on the CPU
+		Image::Format nativeFormat = april::rendersys->getNativeTextureFormat(this->format);
+		unsigned char* levelData = NULL;
+		if (!Image::convertToFormat(this->width, this->height, data, format, &levelData, nativeFormat, false))
+		{
+			return false;
+		}
+		this->_setCurrentTexture();
+		int levels = Image::calcMipmapLevels(this->width, this->height);
+		int w = this->width;
+		int h = this->height;
+		unsigned char* nextData = NULL;
+		for_iter (i, 1, levels)
+		{
+			nextData = NULL;
+			if (!Image::createMipmapLevel(w, h, levelData, nativeFormat, &nextData))
 			{
-				for_iter (j, 0, sh)
-				{
-					GL_SAFE_CALL(glTexSubImage2D, (this->internalType, 0, dx, (dy + j), sw, 1, this->glFormat, GL_UNSIGNED_BYTE, &srcData[(sx + (sy + j) * srcWidth) * srcBpp]));
-				}
+				delete[] levelData;
+				return false;
 			}
+			delete[] levelData;
+			levelData = nextData;
+			w = hmax(w / 2, 1);
+			h = hmax(h / 2, 1);
+			GL_SAFE_CALL(glTexImage2D, (this->internalType, i, this->internalFormat, w, h, 0, this->glFormat, GL_UNSIGNED_BYTE, levelData));
 		}
-		this->firstUpload = false;
+		delete[] levelData;
+		this->mipmapLevels = levels;
+		OGL_RENDERSYS->_setDeviceTextureFilter(this->_getRenderFilter());
 		return true;
 	}
 
@@ -40,12 +40,14 @@
 namespace april
 {
 	class OpenGL_RenderSystem;
+	class OpenGL_TextureUploader;
 	class OpenGLES_RenderSystem;
 
 	class OpenGL_Texture : public Texture
 	{
 	public:
 		friend class OpenGL_RenderSystem;
+		friend class OpenGL_TextureUploader;
 		friend class OpenGLES_RenderSystem;
 
 		OpenGL_Texture(bool fromResource);
@@ -57,17 +59,23 @@ namespace april
 		int glFormat;
 		int internalFormat;
 		int internalType;
+		float deviceAnisotropy;
 
 		void _setCurrentTexture();
 
 		bool _deviceCreateTexture(unsigned char* data, int size) override;
 		bool _deviceDestroyTexture() override;
 		void _assignFormat() override;
+		bool _deviceUploadInBackground(unsigned char* data) override;
+		bool _deviceTryFinishBackgroundUpload(bool wait, bool* success) override;
 
 		Lock _tryLockSystem(int x, int y, int w, int h) override;
 		bool _unlockSystem(Lock& lock, bool update) override;
 		bool _uploadToGpu(int sx, int sy, int sw, int sh, int dx, int dy, unsigned char* srcData, int srcWidth, int srcHeight, Image::Format srcFormat) override;
+		bool _deviceCreateMipmaps(unsigned char* data, Image::Format format) override;
 
+		void _invalidateMipmaps();
+		void _uploadSubData(int sx, int sy, int sw, int sh, int dx, int dy, unsigned char* srcData, int srcWidth, int srcBpp);
 		void _uploadPotSafeData(unsigned char* data);
 		void _uploadPotSafeClearData();
 
@@ -0,0 +1,284 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#ifdef _OPENGL
+#include <condition_variable>
+#include <mutex>
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hthread.h>
+
+#include "april.h"
+#include "OpenGL_RenderSystem.h"
+#include "OpenGL_Texture.h"
+#include "OpenGL_TextureUploader.h"
+
+#define OGL_RENDERSYS ((OpenGL_RenderSystem*)april::rendersys)
+
+namespace april
+{
+	OpenGL_TextureUploader::Entry::Entry() :
+		texture(NULL),
+		data(NULL),
+		width(0),
+		height(0),
+		glFormat(0),
+		internalFormat(0),
+		internalType(0),
+		textureId(0),
+		fence(NULL)
+	{
+	}
+
+	OpenGL_TextureUploader::Entry::Entry(OpenGL_Texture* texture, unsigned char* data) :
+		texture(texture),
+		data(data),
+		width(texture->width),
+		height(texture->height),
+		glFormat(texture->glFormat),
+		internalFormat(texture->internalFormat),
+		internalType(texture->internalType),
+		textureId(0),
+		fence(NULL)
+	{
+	}
+
+	harray<OpenGL_TextureUploader::Entry> OpenGL_TextureUploader::pendingEntries;
+	harray<OpenGL_TextureUploader::Entry> OpenGL_TextureUploader::uploadedEntries;
+	OpenGL_Texture* OpenGL_TextureUploader::uploadingTexture = NULL;
+	std::mutex OpenGL_TextureUploader::mutex;
+	std::condition_variable OpenGL_TextureUploader::queueCondition;
+	std::condition_variable OpenGL_TextureUploader::uploadedCondition;
+	hthread OpenGL_TextureUploader::thread(&OpenGL_TextureUploader::_upload, "APRIL GL texture uploader");
+	bool OpenGL_TextureUploader::running = false;
+	bool OpenGL_TextureUploader::stopping = false;
+	bool OpenGL_TextureUploader::unavailable = false;
+
+	bool OpenGL_TextureUploader::queue(OpenGL_Texture* texture, unsigned char* data)
+	{
+		if (!april::isAsyncTextureUploadThreadEnabled())
+		{
+			return false;
+		}
+		std::unique_lock<std::mutex> lock(OpenGL_TextureUploader::mutex);
+		if (OpenGL_TextureUploader::unavailable || OpenGL_TextureUploader::stopping)
+		{
+			return false;
+		}
+		if (!OpenGL_TextureUploader::running)
+		{
+			// the shared context has to be created while the render thread's context is current
+			if (!OGL_RENDERSYS->_deviceCreateUploadContext())
+			{
+				hlog::write(logTag, "Shared GL contexts are not available, async textures are uploaded on the render thread.");
+				OpenGL_TextureUploader::unavailable = true;
+				return false;
+			}
+			OpenGL_TextureUploader::running = true;
+			OpenGL_TextureUploader::thread.start();
+		}
+		OpenGL_TextureUploader::pendingEntries += Entry(texture, data);
+		lock.unlock();
+		OpenGL_TextureUploader::queueCondition.notify_one();
+		return true;
+	}
+
+	bool OpenGL_TextureUploader::tryFinish(OpenGL_Texture* texture, bool wait, unsigned int* textureId)
+	{
+		std::unique_lock<std::mutex> lock(OpenGL_TextureUploader::mutex);
+		int index = -1;
+		void* fence = NULL;
+		bool signaled = false;
+		while (true)
+		{
+			index = OpenGL_TextureUploader::_findUploaded(texture);
+			if (index >= 0)
+			{
+				break;
+			}
+			bool queued = (OpenGL_TextureUploader::uploadingTexture == texture);
+			for_iter (i, 0, OpenGL_TextureUploader::pendingEntries.size())
+			{
+				if (OpenGL_TextureUploader::pendingEntries[i].texture == texture)
+				{
+					queued = true;
+					break;
+				}
+			}
+			if (!queued) // e.g. the uploader was destroyed in the meantime
+			{
+				*textureId = 0;
+				return true;
+			}
+			if (!wait)
+			{
+				return false;
+			}
+			OpenGL_TextureUploader::uploadedCondition.wait(lock);
+		}
+		fence = OpenGL_TextureUploader::uploadedEntries[index].fence;
+		if (fence != NULL)
+		{
+			// only the render thread removes uploaded entries so the fence stays valid without the lock
+			lock.unlock();
+			signaled = OGL_RENDERSYS->_deviceWaitUploadFence(fence, wait);
+			lock.lock();
+			if (!signaled)
+			{
+				return false;
+			}
+			index = OpenGL_TextureUploader::_findUploaded(texture);
+			OGL_RENDERSYS->_deviceDestroyUploadFence(fence);
+			OpenGL_TextureUploader::uploadedEntries[index].fence = NULL;
+		}
+		*textureId = OpenGL_TextureUploader::uploadedEntries.removeAt(index).textureId;
+		return true;
+	}
+
+	void OpenGL_TextureUploader::cancel(OpenGL_Texture* texture)
+	{
+		std::unique_lock<std::mutex> lock(OpenGL_TextureUploader::mutex);
+		for_iter (i, 0, OpenGL_TextureUploader::pendingEntries.size())
+		{
+			if (OpenGL_TextureUploader::pendingEntries[i].texture == texture)
+			{
+				OpenGL_TextureUploader::pendingEntries.removeAt(i);
+				--i;
+			}
+		}
+		// the data is still being read by the upload thread and must not be deleted yet
+		while (OpenGL_TextureUploader::uploadingTexture == texture)
+		{
+			OpenGL_TextureUploader::uploadedCondition.wait(lock);
+		}
+		int index = OpenGL_TextureUploader::_findUploaded(texture);
+		if (index >= 0)
+		{
+			OpenGL_TextureUploader::_destroyUploaded(index);
+		}
+	}
+
+	void OpenGL_TextureUploader::destroy()
+	{
+		std::unique_lock<std::mutex> lock(OpenGL_TextureUploader::mutex);
+		OpenGL_TextureUploader::unavailable = false; // a new device could support shared contexts
+		if (!OpenGL_TextureUploader::running)
+		{
+			return;
+		}
+		OpenGL_TextureUploader::stopping = true;
+		lock.unlock();
+		OpenGL_TextureUploader::queueCondition.notify_all();
+		OpenGL_TextureUploader::thread.join();
+		lock.lock();
+		// textures that are still waiting fall back to uploads on the render thread
+		OpenGL_TextureUploader::pendingEntries.clear();
+		while (OpenGL_TextureUploader::uploadedEntries.size() > 0)
+		{
+			OpenGL_TextureUploader::_destroyUploaded(0);
+		}
+		OGL_RENDERSYS->_deviceDestroyUploadContext();
+		OpenGL_TextureUploader::running = false;
+		OpenGL_TextureUploader::stopping = false;
+		lock.unlock();
+		OpenGL_TextureUploader::uploadedCondition.notify_all();
+	}
+
+	int OpenGL_TextureUploader::_findUploaded(OpenGL_Texture* texture)
+	{
+		for_iter (i, 0, OpenGL_TextureUploader::uploadedEntries.size())
+		{
+			if (OpenGL_TextureUploader::uploadedEntries[i].texture == texture)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	void OpenGL_TextureUploader::_destroyUploaded(int index)
+	{
+		Entry entry = OpenGL_TextureUploader::uploadedEntries.removeAt(index);
+		if (entry.fence != NULL)
+		{
+			OGL_RENDERSYS->_deviceDestroyUploadFence(entry.fence);
+		}
+		// the texture namespace is shared so the render thread can delete textures created by the upload thread
+		if (entry.textureId != 0 && april::rendersys->canUseLowLevelCalls())
+		{
+			glDeleteTextures(1, &entry.textureId);
+		}
+	}
+
+	void OpenGL_TextureUploader::_upload(hthread* thread)
+	{
+		bool current = OGL_RENDERSYS->_deviceSetUploadContextCurrent(true);
+		if (current)
+		{
+			GL_SAFE_CALL(glPixelStorei, (GL_UNPACK_ALIGNMENT, 1));
+		}
+		else
+		{
+			hlog::error(logTag, "Can't activate the shared GL upload context!");
+		}
+		Entry entry;
+		GLenum glError = GL_NO_ERROR;
+		std::unique_lock<std::mutex> lock(OpenGL_TextureUploader::mutex);
+		while (true)
+		{
+			while (!OpenGL_TextureUploader::stopping && OpenGL_TextureUploader::pendingEntries.size() == 0)
+			{
+				OpenGL_TextureUploader::queueCondition.wait(lock);
+			}
+			if (OpenGL_TextureUploader::stopping)
+			{
+				break;
+			}
+			entry = OpenGL_TextureUploader::pendingEntries.removeFirst();
+			OpenGL_TextureUploader::uploadingTexture = entry.texture;
+			lock.unlock();
+			if (current)
+			{
+				glGenTextures(1, &entry.textureId);
+				glBindTexture(entry.internalType, entry.textureId);
+				// the render thread applies the actual filter and address mode when it takes over the texture
+				glTexParameteri(entry.internalType, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(entry.internalType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				glTexImage2D(entry.internalType, 0, entry.internalFormat, entry.width, entry.height, 0, entry.glFormat, GL_UNSIGNED_BYTE, entry.data);
+				glError = glGetError();
+				glBindTexture(entry.internalType, 0);
+				if (glError == GL_NO_ERROR)
+				{
+					entry.fence = OGL_RENDERSYS->_deviceCreateUploadFence();
+				}
+				else
+				{
+					hlog::warnf(logTag, "Background texture upload failed with GL error 0x%X, falling back to uploads on the render thread.", glError);
+					glDeleteTextures(1, &entry.textureId);
+					entry.textureId = 0;
+				}
+			}
+			lock.lock();
+			if (entry.textureId == 0) // textures that can't be uploaded here are uploaded on the render thread again
+			{
+				OpenGL_TextureUploader::unavailable = true;
+			}
+			OpenGL_TextureUploader::uploadingTexture = NULL;
+			OpenGL_TextureUploader::uploadedEntries += entry;
+			OpenGL_TextureUploader::uploadedCondition.notify_all();
+		}
+		lock.unlock();
+		if (current)
+		{
+			OGL_RENDERSYS->_deviceSetUploadContextCurrent(false);
+		}
+	}
+
+}
+#endif
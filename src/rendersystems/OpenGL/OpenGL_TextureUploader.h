@@ -0,0 +1,79 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines an upload thread with a shared OpenGL context for asynchronously loaded textures.
+
+#ifdef _OPENGL
+#ifndef APRIL_OPENGL_TEXTURE_UPLOADER_H
+#define APRIL_OPENGL_TEXTURE_UPLOADER_H
+
+#include <condition_variable>
+#include <mutex>
+
+#include <hltypes/harray.h>
+#include <hltypes/hthread.h>
+
+namespace april
+{
+	class OpenGL_Texture;
+
+	class OpenGL_TextureUploader
+	{
+	public:
+		static bool queue(OpenGL_Texture* texture, unsigned char* data);
+		static bool tryFinish(OpenGL_Texture* texture, bool wait, unsigned int* textureId);
+		static void cancel(OpenGL_Texture* texture);
+		static void destroy();
+
+	protected:
+		struct Entry
+		{
+		public:
+			OpenGL_Texture* texture;
+			unsigned char* data;
+			int width;
+			int height;
+			int glFormat;
+			int internalFormat;
+			int internalType;
+			unsigned int textureId;
+			void* fence;
+
+			Entry();
+			Entry(OpenGL_Texture* texture, unsigned char* data);
+
+		};
+
+		static harray<Entry> pendingEntries;
+		static harray<Entry> uploadedEntries;
+		static OpenGL_Texture* uploadingTexture;
+		// hmutex can't be used with condition variables
+		static std::mutex mutex;
+		static std::condition_variable queueCondition;
+		static std::condition_variable uploadedCondition;
+		static hthread thread;
+		static bool running;
+		static bool stopping;
+		static bool unavailable;
+
+		static int _findUploaded(OpenGL_Texture* texture);
+		static void _destroyUploaded(int index);
+
+		static void _upload(hthread* thread);
+
+	private: // prevents inheritance and instantiation
+		OpenGL_TextureUploader() { }
+		~OpenGL_TextureUploader() { }
+
+	};
+
+}
+#endif
+#endif
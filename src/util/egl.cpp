@@ -8,6 +8,7 @@
 
 #ifdef _EGL
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hstring.h>
@@ -38,6 +39,11 @@ namespace april
 		this->config = NULL;
 		this->surface = NULL;
 		this->context = NULL;
+		this->uploadSurface = NULL;
+		this->uploadContext = NULL;
+		this->createSyncKHR = NULL;
+		this->clientWaitSyncKHR = NULL;
+		this->destroySyncKHR = NULL;
 		memset(this->pi32ConfigAttribs, 0, sizeof(EGLint) * 128);
 		this->pi32ConfigAttribs[0] = EGL_BUFFER_SIZE;
 		this->pi32ConfigAttribs[1] = 0;
@@ -196,6 +202,7 @@ namespace april
 
 	bool EglData::destroy()
 	{
+		this->destroyUploadContext();
 		if (this->display != NULL)
 		{
 			eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
@@ -223,5 +230,115 @@ namespace april
 		eglSwapBuffers(this->display, this->surface);
 	}
 
+	bool EglData::createUploadContext()
+	{
+		if (this->uploadContext != NULL)
+		{
+			return true;
+		}
+		if (this->display == NULL || this->context == NULL)
+		{
+			return false;
+		}
+		if (april::rendersys->getName() == april::RenderSystemType::OpenGLES2.getName())
+		{
+			EGLint contextAttributes[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+			this->uploadContext = eglCreateContext(this->display, this->config, this->context, contextAttributes);
+		}
+		else
+		{
+			this->uploadContext = eglCreateContext(this->display, this->config, this->context, NULL);
+		}
+		if (this->uploadContext == NULL)
+		{
+			hlog::writef(logTag, "Can't create shared EGL context! Error: %X", eglGetError());
+			return false;
+		}
+		hstr extensions = eglQueryString(this->display, EGL_EXTENSIONS);
+		// the upload context never renders so it doesn't need a surface if the driver allows it
+		if (!extensions.contains("EGL_KHR_surfaceless_context"))
+		{
+			EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+			this->uploadSurface = eglCreatePbufferSurface(this->display, this->config, surfaceAttributes);
+			if (this->uploadSurface == NULL)
+			{
+				hlog::writef(logTag, "Can't create EGL pbuffer surface for the shared context! Error: %X", eglGetError());
+				this->destroyUploadContext();
+				return false;
+			}
+		}
+		if (extensions.contains("EGL_KHR_fence_sync"))
+		{
+			this->createSyncKHR = (PFNEGLCREATESYNCKHRPROC)eglGetProcAddress("eglCreateSyncKHR");
+			this->clientWaitSyncKHR = (PFNEGLCLIENTWAITSYNCKHRPROC)eglGetProcAddress("eglClientWaitSyncKHR");
+			this->destroySyncKHR = (PFNEGLDESTROYSYNCKHRPROC)eglGetProcAddress("eglDestroySyncKHR");
+		}
+		return true;
+	}
+
+	void EglData::destroyUploadContext()
+	{
+		if (this->uploadContext != NULL)
+		{
+			eglDestroyContext(this->display, this->uploadContext);
+			this->uploadContext = NULL;
+		}
+		if (this->uploadSurface != NULL)
+		{
+			eglDestroySurface(this->display, this->uploadSurface);
+			this->uploadSurface = NULL;
+		}
+		this->createSyncKHR = NULL;
+		this->clientWaitSyncKHR = NULL;
+		this->destroySyncKHR = NULL;
+	}
+
+	bool EglData::setUploadContextCurrent(bool current)
+	{
+		if (this->uploadContext == NULL)
+		{
+			return false;
+		}
+		if (!current)
+		{
+			return (eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) == EGL_TRUE);
+		}
+		EGLSurface surface = (this->uploadSurface != NULL ? this->uploadSurface : EGL_NO_SURFACE);
+		return (eglMakeCurrent(this->display, surface, surface, this->uploadContext) == EGL_TRUE);
+	}
+
+	void* EglData::createFence()
+	{
+		if (this->createSyncKHR == NULL || this->clientWaitSyncKHR == NULL || this->destroySyncKHR == NULL)
+		{
+			return NULL;
+		}
+		EGLSyncKHR sync = this->createSyncKHR(this->display, EGL_SYNC_FENCE_KHR, NULL);
+		if (sync == EGL_NO_SYNC_KHR)
+		{
+			return NULL;
+		}
+		return (void*)sync;
+	}
+
+	bool EglData::waitFence(void* fence, bool wait)
+	{
+		if (this->clientWaitSyncKHR == NULL)
+		{
+			return true;
+		}
+		EGLint result = this->clientWaitSyncKHR(this->display, (EGLSyncKHR)fence, 0, wait ? EGL_FOREVER_KHR : 0);
+		// a failed wait can't become signaled later so the texture is used anyway
+		return (result != EGL_TIMEOUT_EXPIRED_KHR);
+	}
+
+	void EglData::destroyFence(void* fence)
+	{
+		if (this->destroySyncKHR != NULL)
+		{
+			this->destroySyncKHR(this->display, (EGLSyncKHR)fence);
+		}
+	}
+
 }
 #endif
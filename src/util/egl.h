@@ -15,6 +15,7 @@
 #define APRIL_EGL_H
 
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <gtypes/Vector3.h>
 
 namespace april
@@ -28,6 +29,12 @@ namespace april
 		EGLSurface surface;
 		EGLContext context;
 		EGLint pi32ConfigAttribs[128];
+		// shared context used by the background texture upload thread
+		EGLSurface uploadSurface;
+		EGLContext uploadContext;
+		PFNEGLCREATESYNCKHRPROC createSyncKHR;
+		PFNEGLCLIENTWAITSYNCKHRPROC clientWaitSyncKHR;
+		PFNEGLDESTROYSYNCKHRPROC destroySyncKHR;
 
 		EglData();
 		~EglData();
@@ -36,6 +43,13 @@ namespace april
 		bool destroy();
 		void swapBuffers();
 
+		bool createUploadContext();
+		void destroyUploadContext();
+		bool setUploadContextCurrent(bool current);
+		void* createFence();
+		bool waitFence(void* fence, bool wait);
+		void destroyFence(void* fence);
+
 	};
 
 	extern EglData* egl;
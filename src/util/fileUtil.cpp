@@ -0,0 +1,129 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <limits.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mutex>
+#endif
+
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "fileUtil.h"
+
+namespace april
+{
+#if defined(__linux__) || defined(__APPLE__)
+	// a mapped file that is truncated while it's being copied raises SIGBUS, the copy jumps out of the handler instead of crashing
+	static thread_local sigjmp_buf* mappedCopyJump = NULL;
+	static struct sigaction previousBusAction;
+	static std::once_flag busHandlerFlag;
+
+	static void _handleBusError(int signal, siginfo_t* info, void* context)
+	{
+		if (mappedCopyJump != NULL)
+		{
+			siglongjmp(*mappedCopyJump, 1);
+		}
+		// not caused by a mapped copy, so it's handled the way it would have been without this handler
+		if ((previousBusAction.sa_flags & SA_SIGINFO) != 0)
+		{
+			previousBusAction.sa_sigaction(signal, info, context);
+		}
+		else if (previousBusAction.sa_handler != SIG_DFL && previousBusAction.sa_handler != SIG_IGN)
+		{
+			previousBusAction.sa_handler(signal);
+		}
+		else // delivered with the previous action as soon as this handler returns
+		{
+			sigaction(SIGBUS, &previousBusAction, NULL);
+			raise(signal);
+		}
+	}
+
+	static void _installBusHandler()
+	{
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_sigaction = &_handleBusError;
+		action.sa_flags = SA_SIGINFO;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGBUS, &action, &previousBusAction);
+	}
+
+	bool readMappedFile(chstr filename, hstream& stream)
+	{
+		int file = open(filename.cStr(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+		struct stat info;
+		if (fstat(file, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0 || info.st_size > INT_MAX)
+		{
+			close(file);
+			return false;
+		}
+		size_t size = (size_t)info.st_size;
+		void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data == MAP_FAILED)
+		{
+			close(file);
+			return false;
+		}
+		// the whole file is needed right away, so the kernel can read ahead as far as possible
+		madvise(data, size, MADV_SEQUENTIAL);
+		madvise(data, size, MADV_WILLNEED);
+		std::call_once(busHandlerFlag, &_installBusHandler);
+		volatile bool result = false;
+		sigjmp_buf jump;
+		// a file that already shrank isn't copied at all, truncation during the copy is caught by the SIGBUS guard
+		if (fstat(file, &info) == 0 && (size_t)info.st_size == size && sigsetjmp(jump, 1) == 0)
+		{
+			mappedCopyJump = &jump;
+			// the only copy, straight from the page cache into the stream's own storage
+			stream.writeRaw(data, (int)size);
+			result = true;
+		}
+		mappedCopyJump = NULL;
+		munmap(data, size);
+		close(file);
+		return result;
+	}
+
+	int64_t getFileModificationTime(chstr filename)
+	{
+		struct stat info;
+		if (stat(filename.cStr(), &info) != 0)
+		{
+			return 0LL;
+		}
+		return (int64_t)info.st_mtime;
+	}
+#else
+	bool readMappedFile(chstr filename, hstream& stream)
+	{
+		return false;
+	}
+
+	// not available on this platform
+	int64_t getFileModificationTime(chstr filename)
+	{
+		return 0LL;
+	}
+#endif
+
+}
@@ -0,0 +1,26 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines utility functions for fast file reading and file information.
+
+#ifndef APRIL_FILE_UTIL_H
+#define APRIL_FILE_UTIL_H
+
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+namespace april
+{
+	// returns false if the file was truncated while it was copied, the stream has to be cleared in that case
+	bool readMappedFile(chstr filename, hstream& stream);
+	int64_t getFileModificationTime(chstr filename);
+
+}
+#endif
@@ -0,0 +1,33 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hltypesUtil.h>
+
+#include "hashUtil.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+namespace april
+{
+	unsigned long long hashFnv1a(const unsigned char* data, int size)
+	{
+		return hashFnv1a(FNV_OFFSET_BASIS, data, size);
+	}
+
+	// 64-bit FNV-1a, continues from a previous hash so data can be hashed in chunks
+	unsigned long long hashFnv1a(unsigned long long hash, const unsigned char* data, int size)
+	{
+		for_iter (i, 0, size)
+		{
+			hash = (hash ^ data[i]) * FNV_PRIME;
+		}
+		return hash;
+	}
+
+}
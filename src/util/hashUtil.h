@@ -0,0 +1,22 @@
+/// @file
+/// @version 5.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines utility functions for hashing data.
+
+#ifndef APRIL_HASH_UTIL_H
+#define APRIL_HASH_UTIL_H
+
+namespace april
+{
+	unsigned long long hashFnv1a(const unsigned char* data, int size);
+	unsigned long long hashFnv1a(unsigned long long hash, const unsigned char* data, int size);
+
+}
+#endif
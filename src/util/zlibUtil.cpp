@@ -16,6 +16,7 @@
 
 namespace april
 {
+	// only initialization is serialized in case zlib builds its static tables there, each call has its own z_stream otherwise
 	static hmutex zlibMutex;
 
 	unsigned char* zlibDecompress(int streamSize, int compressedSize, hsbase& stream)
@@ -25,6 +26,7 @@ namespace april
 		memset(&zlibStream, 0, sizeof(zlibStream));
 		hmutex::ScopeLock lock(&zlibMutex);
 		int result = inflateInit(&zlibStream);
+		lock.release();
 		if (result != Z_OK)
 		{
 			hlog::error(logTag, "zlib Error: " + hstr(result));
@@ -48,4 +50,68 @@ namespace april
 		return data;
 	}
 
+	unsigned char* zlibDecompress(int size, int compressedSize, unsigned char* compressedData)
+	{
+		// zlib inflate init
+		z_stream zlibStream;
+		memset(&zlibStream, 0, sizeof(zlibStream));
+		hmutex::ScopeLock lock(&zlibMutex);
+		int result = inflateInit(&zlibStream);
+		lock.release();
+		if (result != Z_OK)
+		{
+			hlog::error(logTag, "zlib Error: " + hstr(result));
+			return NULL;
+		}
+		unsigned char* data = new unsigned char[size];
+		// decompress
+		zlibStream.next_in = compressedData;
+		zlibStream.avail_in = compressedSize;
+		zlibStream.next_out = data;
+		zlibStream.avail_out = size;
+		if (inflate(&zlibStream, Z_FINISH) != Z_STREAM_END)
+		{
+			delete[] data;
+			data = NULL;
+		}
+		inflateEnd(&zlibStream);
+		return data;
+	}
+
+	unsigned char* zlibCompress(int size, unsigned char* data, int* compressedSize)
+	{
+		// zlib deflate init, speed matters more than ratio since this is used for data that is needed again at runtime
+		z_stream zlibStream;
+		memset(&zlibStream, 0, sizeof(zlibStream));
+		hmutex::ScopeLock lock(&zlibMutex);
+		int result = deflateInit(&zlibStream, Z_BEST_SPEED);
+		lock.release();
+		if (result != Z_OK)
+		{
+			hlog::error(logTag, "zlib Error: " + hstr(result));
+			return NULL;
+		}
+		int outputSize = (int)deflateBound(&zlibStream, size);
+		unsigned char* output = new unsigned char[outputSize];
+		// compress
+		zlibStream.next_in = data;
+		zlibStream.avail_in = size;
+		zlibStream.next_out = output;
+		zlibStream.avail_out = outputSize;
+		result = deflate(&zlibStream, Z_FINISH);
+		int outputUsed = (int)zlibStream.total_out;
+		deflateEnd(&zlibStream);
+		if (result != Z_STREAM_END)
+		{
+			delete[] output;
+			return NULL;
+		}
+		// the bound is larger than the actual result and the point is to use less memory
+		unsigned char* compressedData = new unsigned char[outputUsed];
+		memcpy(compressedData, output, outputUsed);
+		delete[] output;
+		*compressedSize = outputUsed;
+		return compressedData;
+	}
+
 }
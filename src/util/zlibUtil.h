@@ -18,6 +18,8 @@
 namespace april
 {
 	unsigned char* zlibDecompress(int streamSize, int compressedSize, hsbase& stream);
+	unsigned char* zlibDecompress(int size, int compressedSize, unsigned char* compressedData);
+	unsigned char* zlibCompress(int size, unsigned char* data, int* compressedSize);
 
 }
 #endif